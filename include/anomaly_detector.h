@@ -0,0 +1,304 @@
+// Detección de anomalías de la sonda y del riego a medida que llegan las lecturas
+// Cada lectura cuesta O(1) y el estado son unos 320 bytes (la mayor parte son las
+// referencias del secado por franja de humedad):
+// - STUCK: la lectura cruda de humedad no cambia en STUCK_MS, o queda en un extremo
+//   del ADC (sonda desconectada o en corto) durante RAIL_MS
+// - LEAK: en una ventana de WINDOW_MS con la bomba encendida casi todo el tiempo la
+//   humedad no sube (fuga en la cañería, bomba sin agua)
+// - EVAPORATION / DRIFT: con la bomba apagada la humedad baja por evaporación,
+//   proporcional a la temperatura y a la propia humedad, y sobre la capacidad de campo
+//   además por drenaje, que depende solo de la humedad. En cada ventana sin riego se
+//   calcula el secado relativo a la humedad (%/h) y se compara con el habitual a esa
+//   temperatura y en esa franja de humedad; un CUSUM por cada lado acumula los residuos:
+//   si el suelo se seca más rápido de lo habitual (calor, viento, cama que pierde agua)
+//   se marca EVAPORATION; si se seca mucho más lento o la humedad sube sin riego (sonda
+//   que se descalibra, lluvia) se marca DRIFT.
+// Las alarmas de ventana quedan hasta que una ventana posterior vuelve a lo normal.
+
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+#include <stdint.h>
+
+class AnomalyDetector {
+public:
+  static const uint8_t STUCK = 0x01;
+  static const uint8_t LEAK = 0x02;
+  static const uint8_t EVAPORATION = 0x04;
+  static const uint8_t DRIFT = 0x08;
+
+  static const unsigned long STUCK_MS = 30UL * 60 * 1000;        // Lectura idéntica durante media hora
+  static const unsigned long RAIL_MS = 60UL * 1000;              // Lectura en un extremo del ADC
+  static const uint16_t RAIL_MARGIN = 4;                         // Cuentas desde los extremos del ADC
+  static const unsigned long WINDOW_MS = 15UL * 60 * 1000;       // Ventana de evaluación
+  static const unsigned long PUMP_SETTLE_MS = 10UL * 60 * 1000;  // Tras regar se espera a la sonda y al drenaje
+  static const uint8_t WARMUP_WINDOWS = 4;                       // Ventanas sin riego antes de evaluar el secado
+  static const uint8_t MOISTURE_BANDS = 10;                      // Referencias del secado, una cada 10 % de humedad
+
+  // adcMax: valor máximo del ADC, para reconocer una sonda en un extremo
+  explicit AnomalyDetector(uint16_t adcMax) : adcMax(adcMax) {}
+
+  // Agrega la lectura de un ciclo; pumpOn es el estado de la bomba durante el ciclo anterior
+  void update(uint16_t rawHumidity, float humidity, float temperature, bool pumpOn, unsigned long nowMs)
+  {
+    if (!started)
+    {
+      started = true;
+      smoothed = humidity;
+      lastRaw = rawHumidity;
+      lastChangeMs = lastPumpMs = nowMs;
+      startWindow(nowMs);
+      return;
+    }
+    unsigned long elapsed = nowMs - lastUpdateMs;
+    lastUpdateMs = nowMs;
+
+    checkStuck(rawHumidity, nowMs);
+
+    // Promedio exponencial de unos 16 ciclos para que el ruido de la sonda no pese
+    smoothed += (humidity - smoothed) * SMOOTHING;
+    if (pumpOn)
+    {
+      pumpOnMs += elapsed;
+      lastPumpMs = nowMs;
+    }
+    temperatureSum += temperature;
+    temperatureCount++;
+
+    if (nowMs - windowStartMs >= WINDOW_MS)
+    {
+      closeWindow(nowMs);
+      startWindow(nowMs);
+    }
+  }
+
+  // Anomalías activas (combinación de STUCK, LEAK, EVAPORATION y DRIFT)
+  uint8_t active() const { return flags; }
+
+  // Secado habitual (%/h relativo a la humedad) a una temperatura en la franja de humedad
+  // de la última ventana sin riego, 0 mientras se aprende
+  float dryingBaseline(float temperature) const
+  {
+    const Baseline& baseline = baselines[lastBand];
+    return baseline.windows >= WARMUP_WINDOWS ? expected(baseline, temperature, baseline.moisture) : 0;
+  }
+
+  // Aumento del secado por cada °C, común a todas las franjas (la evaporación)
+  float dryingPerDegree() const { return perDegree(); }
+
+private:
+  static constexpr float SMOOTHING = 1.0f / 16;
+  static constexpr float BASELINE_WEIGHT = 1.0f / 8;  // Peso de cada ventana en la media del secado
+  static constexpr float MIN_DEVIATION = 0.1f;        // Desvío mínimo, en fracción del secado esperado
+  static constexpr float LEAK_DUTY = 0.75f;           // Fracción de la ventana con la bomba encendida
+  static constexpr float LEAK_MIN_RISE = 0.5f;        // Subida mínima de la humedad (%) con esa bomba
+  static constexpr float CUSUM_SLACK = 0.5f;          // Desvíos que se toleran por ventana
+  static constexpr float CUSUM_LIMIT = 4.0f;          // Desvíos acumulados para dar la alarma
+  static constexpr float SLOPE_WEIGHT = 1.0f / 40;    // Peso de cada ventana en la pendiente común
+  static constexpr float TEMPERATURE_PRIOR = 0.25f;   // °C²: sin variación de temperatura la pendiente tiende a 0
+  static constexpr float MOISTURE_PRIOR = 0.00001f;   // Ídem para la humedad (fracción²)
+  static constexpr float NEAR_TEMPERATURE = 2.0f;     // °C desde la media de la franja para evaluar sin la pendiente
+
+  void checkStuck(uint16_t rawHumidity, unsigned long nowMs)
+  {
+    if (rawHumidity != lastRaw)
+    {
+      lastRaw = rawHumidity;
+      lastChangeMs = nowMs;
+    }
+    bool rail = rawHumidity <= RAIL_MARGIN || rawHumidity + RAIL_MARGIN >= adcMax;
+    unsigned long limit = STUCK_MS;
+    if (rail)
+      limit = RAIL_MS;
+    if (nowMs - lastChangeMs >= limit)
+      flags |= STUCK;
+    else
+      flags &= ~STUCK;
+  }
+
+  void startWindow(unsigned long nowMs)
+  {
+    windowStartMs = lastUpdateMs = nowMs;
+    windowStartHumidity = smoothed;
+    pumpOnMs = 0;
+    temperatureSum = 0;
+    temperatureCount = 0;
+  }
+
+  void closeWindow(unsigned long nowMs)
+  {
+    float hours = (nowMs - windowStartMs) / 3600000.0f;
+    float rise = smoothed - windowStartHumidity;
+
+    // Con la bomba casi siempre encendida la humedad tiene que subir
+    if (pumpOnMs >= (unsigned long)(LEAK_DUTY * (nowMs - windowStartMs)))
+    {
+      if (rise < LEAK_MIN_RISE)
+        flags |= LEAK;
+      else
+        flags &= ~LEAK;
+    }
+
+    // El secado solo se evalúa en ventanas completas sin riego ni efectos del riego anterior
+    if (pumpOnMs > 0 || windowStartMs - lastPumpMs < PUMP_SETTLE_MS || temperatureCount == 0 || (flags & (STUCK | LEAK)))
+      return;
+    float temperature = temperatureSum / temperatureCount;
+    if (temperature < 0)
+      temperature = 0;
+    // El suelo húmedo pierde agua más rápido: se normaliza por la humedad media de la ventana
+    float moisture = (windowStartHumidity + smoothed) / 200;
+    if (moisture < 0.05f)
+      moisture = 0.05f;
+    float drying = -rise / (hours * moisture);
+
+    // Secado = media de la franja + pendiente por °C · diferencia con la temperatura media
+    // + pendiente por humedad · diferencia con la humedad media. La pendiente por °C es la
+    // evaporación y es la misma en todas las franjas; la media y la pendiente por humedad
+    // de cada franja incluyen el drenaje, que el detector no conoce porque no sabe dónde
+    // está la capacidad de campo.
+    uint8_t band = (uint8_t)(moisture * MOISTURE_BANDS);
+    if (band >= MOISTURE_BANDS)
+      band = MOISTURE_BANDS - 1;
+    lastBand = band;
+    Baseline& baseline = baselines[band];
+
+    // Se evalúa cuando la franja tiene sus medias, y mientras la pendiente por °C tiene pocas
+    // ventanas solo a una temperatura parecida a la media de la franja, donde pesa poco
+    float offset = temperature - baseline.temperature;
+    bool slopeKnown = pooledWindows >= (uint8_t)(1 / SLOPE_WEIGHT) || (offset < NEAR_TEMPERATURE && offset > -NEAR_TEMPERATURE);
+    if (baseline.windows < WARMUP_WINDOWS || !slopeKnown)
+    {
+      // Primeras ventanas de la franja: media simple para arrancar la EWMA
+      if (baseline.windows < WARMUP_WINDOWS)
+      {
+        baseline.windows++;
+        learn(baseline, drying, temperature, moisture, 1.0f / baseline.windows);
+      }
+      else
+        learn(baseline, drying, temperature, moisture, BASELINE_WEIGHT);
+      return;
+    }
+
+    // Los CUSUM se comparten entre franjas, así que acumulan residuos en desvíos
+    float expectedDrying = expected(baseline, temperature, moisture);
+    float residual = drying - expectedDrying;
+    float deviation = baseline.deviation;
+    float minimum = MIN_DEVIATION * (expectedDrying > 0 ? expectedDrying : -expectedDrying);
+    // Con poco secado (suelo frío, cerca de la capacidad de campo) manda la resolución de la
+    // sonda: una cuenta del ADC en la ventana
+    float resolution = 100.0f / adcMax / (hours * moisture);
+    if (minimum < resolution)
+      minimum = resolution;
+    if (deviation < minimum)
+      deviation = minimum;
+    cusumHigh += residual / deviation - CUSUM_SLACK;
+    cusumLow += -residual / deviation - CUSUM_SLACK;
+    if (cusumHigh < 0)
+      cusumHigh = 0;
+    if (cusumLow < 0)
+      cusumLow = 0;
+
+    flags &= ~(EVAPORATION | DRIFT);
+    if (cusumHigh > CUSUM_LIMIT)
+      flags |= EVAPORATION;
+    if (cusumLow > CUSUM_LIMIT)
+      flags |= DRIFT;
+
+    // La referencia solo aprende de ventanas normales, así una falla no se vuelve habitual
+    if ((flags & (EVAPORATION | DRIFT)) == 0)
+      learn(baseline, drying, temperature, moisture, BASELINE_WEIGHT);
+  }
+
+  uint16_t adcMax;
+  bool started = false;
+  uint8_t flags = 0;
+
+  uint16_t lastRaw = 0;
+  unsigned long lastChangeMs = 0;
+  unsigned long lastUpdateMs = 0;
+  unsigned long lastPumpMs = 0;
+
+  float smoothed = 0;
+  unsigned long windowStartMs = 0;
+  float windowStartHumidity = 0;
+  unsigned long pumpOnMs = 0;
+  float temperatureSum = 0;
+  uint16_t temperatureCount = 0;
+
+  // Medias de la temperatura, la humedad y el secado de las ventanas de una franja de
+  // humedad, desvío del secado respecto del esperado, y varianza de la humedad y su
+  // covarianza con el secado (sin la parte de la temperatura) dentro de la franja
+  struct Baseline {
+    float temperature;
+    float moisture;
+    float drying;
+    float deviation;
+    float moistureVariance;
+    float moistureCovariance;
+    uint8_t windows;
+  };
+
+  // Aumento del secado por °C: regresión con las variaciones de cada ventana respecto de
+  // las medias de su franja, con la humedad como segunda variable para que el drenaje, que
+  // baja junto con la temperatura durante la noche, no se cuente como evaporación
+  float perDegree() const
+  {
+    float tt = varT + TEMPERATURE_PRIOR, mm = varM + MOISTURE_PRIOR;
+    return (covTY * mm - covMY * covTM) / (tt * mm - covTM * covTM);
+  }
+
+  // Aumento del secado por unidad de humedad dentro de la franja: casi 0 bajo la capacidad
+  // de campo, porque la evaporación ya es proporcional a la humedad, y el drenaje por encima
+  static float perMoisture(const Baseline& baseline)
+  {
+    return baseline.moistureCovariance / (baseline.moistureVariance + MOISTURE_PRIOR);
+  }
+
+  float expected(const Baseline& baseline, float temperature, float moisture) const
+  {
+    return baseline.drying + perDegree() * (temperature - baseline.temperature) +
+           perMoisture(baseline) * (moisture - baseline.moisture);
+  }
+
+  // Agrega una ventana a la franja con el peso dado, y su variación a la pendiente por °C
+  void learn(Baseline& baseline, float drying, float temperature, float moisture, float weight)
+  {
+    float residual = drying - expected(baseline, temperature, moisture);
+    if (baseline.windows > 1)
+    {
+      float deviationWeight = weight > BASELINE_WEIGHT ? 1.0f / (baseline.windows - 1) : weight;
+      baseline.deviation += ((residual > 0 ? residual : -residual) - baseline.deviation) * deviationWeight;
+
+      // Media simple hasta juntar 1 / SLOPE_WEIGHT ventanas, después EWMA
+      if (pooledWindows < (uint8_t)(1 / SLOPE_WEIGHT))
+        pooledWindows++;
+      float dt = temperature - baseline.temperature;
+      float dm = moisture - baseline.moisture;
+      float dd = drying - baseline.drying;
+      varT += (dt * dt - varT) / pooledWindows;
+      varM += (dm * dm - varM) / pooledWindows;
+      covTM += (dt * dm - covTM) / pooledWindows;
+      covTY += (dt * dd - covTY) / pooledWindows;
+      covMY += (dm * dd - covMY) / pooledWindows;
+      baseline.moistureVariance += (dm * dm - baseline.moistureVariance) * deviationWeight;
+      baseline.moistureCovariance += (dm * (dd - perDegree() * dt) - baseline.moistureCovariance) * deviationWeight;
+    }
+    baseline.temperature += (temperature - baseline.temperature) * weight;
+    baseline.moisture += (moisture - baseline.moisture) * weight;
+    baseline.drying += (drying - baseline.drying) * weight;
+  }
+
+  Baseline baselines[MOISTURE_BANDS] = {};
+  uint8_t lastBand = 0;
+  // Varianzas y covarianzas de temperatura (T), humedad (M) y secado (Y) dentro de cada franja
+  float varT = 0;
+  float varM = 0;
+  float covTM = 0;
+  float covTY = 0;
+  float covMY = 0;
+  uint8_t pooledWindows = 0;
+  float cusumHigh = 0;
+  float cusumLow = 0;
+};
+
+#endif
@@ -0,0 +1,31 @@
+// Regla de activación del riego
+// La misma regla sirve para dos variantes del controlador:
+// - En tiempo de ejecución, con los parámetros del cultivo elegido en el menú (CropParameters)
+// - Especializada al compilar, con un CropTraits<N> cuyos umbrales son constantes;
+//   el compilador reemplaza las comparaciones por valores inmediatos
+
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+// Se riega si la temperatura está dentro del rango del cultivo y la humedad no supera el máximo
+template <typename Crop>
+inline bool irrigationNeeded(const Crop& crop, float tmp, float hum)
+{
+  if ((tmp >= crop.minTemp && tmp <= crop.maxTemp) && (hum <= crop.minHumidity))
+    return true;
+
+  else if ((tmp >= crop.minTemp && tmp <= crop.maxTemp) && (hum <= crop.maxHumidity))
+    return true;
+
+  else
+    return false;
+}
+
+// Variante con los umbrales del cultivo fijados al compilar
+template <typename Crop>
+inline bool fixedIrrigationNeeded(float tmp, float hum)
+{
+  return irrigationNeeded(Crop(), tmp, hum);
+}
+
+#endif
@@ -0,0 +1,17 @@
+// Parámetros óptimos de un cultivo tal como se definen en config/board.json
+// - name: Nombre que se muestra en la pantalla
+// - minTemp / maxTemp: Rango de temperatura en el que se puede regar (°C)
+// - minHumidity / maxHumidity: Rango de humedad del suelo (%)
+
+#ifndef CROP_PROFILE_H
+#define CROP_PROFILE_H
+
+struct CropProfile {
+  const char* name;
+  float minTemp;
+  float maxTemp;
+  float minHumidity;
+  float maxHumidity;
+};
+
+#endif
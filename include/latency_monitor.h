@@ -0,0 +1,104 @@
+// Latencia del control: desde que se muestrean los sensores hasta que la orden se
+// escribe en el pin del relé (con detector de cruce por cero, al aplicarse en el cruce)
+// Cada medición se anota en un histograma de casillas logarítmicas (4 por cada potencia
+// de 2, error menor al 25 %) del que se obtienen los percentiles sin guardar las
+// mediciones. Cuando una casilla se llena se dividen todas a la mitad, así el
+// histograma pesa más los ciclos recientes y la alarma se apaga cuando la latencia
+// vuelve a cumplir el objetivo (SLO) de la configuración.
+
+#ifndef LATENCY_MONITOR_H
+#define LATENCY_MONITOR_H
+
+#include <stdint.h>
+
+class LatencyMonitor {
+public:
+  static const uint8_t BUCKETS = 64;          // Casillas del histograma (1 byte cada una)
+  static const uint8_t MIN_OCTAVE = 10;       // La primera casilla agrupa todo lo menor a 1024 us
+  static const uint8_t SUB_BUCKETS_LOG2 = 2;  // 4 casillas por cada potencia de 2
+  static const uint8_t MIN_SAMPLES = 32;      // Mediciones antes de evaluar el objetivo
+
+  // percentile: percentil que se vigila (1-100), limitMicros: valor máximo permitido
+  LatencyMonitor(uint8_t percentile, unsigned long limitMicros) : percentile(percentile), limitMicros(limitMicros) {}
+
+  // Anota una medición y actualiza la alarma
+  void record(unsigned long latencyMicros)
+  {
+    if (latencyMicros > maxMicros)
+      maxMicros = latencyMicros;
+
+    uint8_t bucket = bucketOf(latencyMicros);
+    if (counts[bucket] == 0xFF)
+    {
+      for (uint8_t i = 0; i < BUCKETS; i++)
+        counts[i] >>= 1;
+    }
+    counts[bucket]++;
+
+    if (samples < MIN_SAMPLES)
+      samples++;
+    else
+      alarm = percentileMicros(percentile) > limitMicros;
+  }
+
+  // Límite superior de la casilla donde cae el percentil pedido (1-100), acotado por el máximo
+  unsigned long percentileMicros(uint8_t p) const
+  {
+    uint16_t total = 0;
+    for (uint8_t i = 0; i < BUCKETS; i++)
+      total += counts[i];
+    if (total == 0)
+      return 0;
+
+    uint16_t target = ((uint32_t)total * p + 99) / 100;
+    uint16_t seen = 0;
+    uint8_t i = 0;
+    for (; i < BUCKETS; i++)
+    {
+      seen += counts[i];
+      if (seen >= target)
+        break;
+    }
+    // El máximo es exacto y acota la casilla
+    unsigned long limit = bucketLimit(i < BUCKETS ? i : BUCKETS - 1);
+    return limit < maxMicros ? limit : maxMicros;
+  }
+
+  unsigned long maximum() const { return maxMicros; }
+  bool alarmActive() const { return alarm; }
+
+private:
+  uint8_t percentile;
+  unsigned long limitMicros;
+
+  uint8_t counts[BUCKETS] = {};
+  unsigned long maxMicros = 0;
+  uint8_t samples = 0;
+  bool alarm = false;
+
+  static uint8_t bucketOf(unsigned long latencyMicros)
+  {
+    if (latencyMicros < (1UL << MIN_OCTAVE))
+      return 0;
+
+    uint8_t octave = MIN_OCTAVE;
+    while (octave < 31 && (latencyMicros >> (octave + 1)) != 0)
+      octave++;
+
+    uint8_t sub = (latencyMicros >> (octave - SUB_BUCKETS_LOG2)) & ((1 << SUB_BUCKETS_LOG2) - 1);
+    uint16_t bucket = 1 + ((octave - MIN_OCTAVE) << SUB_BUCKETS_LOG2) + sub;
+    return bucket < BUCKETS ? bucket : BUCKETS - 1;
+  }
+
+  static unsigned long bucketLimit(uint8_t bucket)
+  {
+    if (bucket == 0)
+      return 1UL << MIN_OCTAVE;
+
+    uint8_t octave = MIN_OCTAVE + ((bucket - 1) >> SUB_BUCKETS_LOG2);
+    uint8_t sub = (bucket - 1) & ((1 << SUB_BUCKETS_LOG2) - 1);
+    return (unsigned long)((1 << SUB_BUCKETS_LOG2) + sub + 1) << (octave - SUB_BUCKETS_LOG2);
+  }
+};
+
+#endif
@@ -0,0 +1,169 @@
+// Pronóstico de la humedad de la zona a partir de su historial
+// La humedad de la cama sigue el balance del modelo del suelo:
+//   dh/dt = -evaporación · T · h / 100 + ganancia · bomba   (%/h)
+// donde T es la temperatura (°C), h la humedad (%) y bomba la fracción del tiempo con
+// la bomba encendida. Los dos coeficientes se ajustan en la placa por mínimos cuadrados
+// recursivos (RLS) con olvido exponencial: cada SAMPLE_MS se agrega una muestra, así
+// el ajuste sigue los cambios de la cama (compactación, época del año) en O(1) y unos
+// 50 bytes. Para no sumar ruido del ADC cada muestra compara el promedio de todas las
+// lecturas de un intervalo con el del anterior.
+//
+// Con los coeficientes ajustados y la temperatura actual, sin regar la humedad baja de
+// forma exponencial y el cruce con un umbral tiene solución cerrada:
+//   t = ln(h / umbral) · 100 / (evaporación · T)
+// que el planificador de riego usa para decidir cuánto se puede esperar.
+
+#ifndef MOISTURE_FORECASTER_H
+#define MOISTURE_FORECASTER_H
+
+#include <math.h>
+#include <stdint.h>
+
+class MoistureForecaster {
+public:
+  static const unsigned long SAMPLE_MS = 10UL * 60 * 1000;       // Intervalo entre muestras del ajuste
+  static const unsigned long PUMP_SETTLE_MS = 10UL * 60 * 1000;  // Tras regar se espera a la sonda y al drenaje
+  static const uint8_t MIN_SAMPLES = 3;                          // Muestras ajustadas antes de pronosticar
+  static const uint16_t HORIZON_MINUTES = 24 * 60;               // Alcance del pronóstico
+  static const uint16_t NO_CROSSING = 0xFFFF;                    // Sin cruce dentro del horizonte
+
+  // Agrega la lectura de un ciclo; pumpWasOn es el estado de la bomba durante el ciclo anterior
+  void observe(float humidity, float temperature, bool pumpWasOn, unsigned long nowMs)
+  {
+    if (!started)
+    {
+      started = true;
+      intervalStartMs = lastUpdateMs = lastPumpMs = nowMs;
+      return;
+    }
+    unsigned long elapsed = nowMs - lastUpdateMs;
+    lastUpdateMs = nowMs;
+
+    if (pumpWasOn)
+    {
+      pumpOnMs += elapsed;
+      lastPumpMs = nowMs;
+    }
+    humiditySum += humidity;
+    temperatureSum += temperature;
+    readings++;
+
+    if (nowMs - intervalStartMs >= SAMPLE_MS)
+      closeInterval(nowMs);
+  }
+
+  // Hay suficientes muestras para pronosticar
+  bool ready() const { return samples >= MIN_SAMPLES && theta[0] > 0; }
+
+  // Humedad prevista dentro de minutesAhead minutos sin regar, con la temperatura actual
+  float predict(float humidity, float temperature, uint16_t minutesAhead) const
+  {
+    return humidity * expf(-decayPerHour(temperature) * minutesAhead / 60.0f);
+  }
+
+  // Minutos hasta que la humedad baje del umbral sin regar, con la temperatura actual;
+  // 0 si ya está debajo y NO_CROSSING si no lo cruza dentro de HORIZON_MINUTES
+  uint16_t minutesUntil(float humidity, float threshold, float temperature) const
+  {
+    if (humidity <= threshold)
+      return 0;
+    float decay = decayPerHour(temperature);
+    if (decay <= 0 || threshold <= 0)
+      return NO_CROSSING;
+    float minutes = logf(humidity / threshold) / decay * 60.0f;
+    if (minutes >= HORIZON_MINUTES)
+      return NO_CROSSING;
+    return (uint16_t)minutes;
+  }
+
+  // Coeficiente de evaporación ajustado (%/h por °C, relativo a la humedad)
+  float evaporationCoeff() const { return theta[0]; }
+
+  // Humedad que aporta la bomba encendida (%/h)
+  float pumpGain() const { return theta[1]; }
+
+private:
+  static constexpr float FORGETTING = 0.98f;   // Peso de las muestras anteriores (memoria de unas 8 h)
+  static constexpr float INITIAL_COVARIANCE = 100.0f;
+  static constexpr float MAX_COVARIANCE = 1000.0f; // Sin muestras nuevas de una variable no se sigue olvidando
+
+  float decayPerHour(float temperature) const
+  {
+    if (temperature <= 0)
+      return 0;
+    return theta[0] * temperature / 100;
+  }
+
+  void closeInterval(unsigned long nowMs)
+  {
+    float hours = (nowMs - intervalStartMs) / 3600000.0f;
+    float humidity = humiditySum / readings;
+    float temperature = temperatureSum / readings;
+    float pump = (float)pumpOnMs / (nowMs - intervalStartMs);
+
+    // Los intervalos con la bomba se usan para la ganancia; los que siguen al riego no,
+    // porque la sonda y el drenaje todavía no se asentaron
+    bool watering = pump > 0 || previousPump > 0;
+    if (hasPrevious && (watering || previousStartMs - lastPumpMs >= PUMP_SETTLE_MS))
+    {
+      float x[2] = {-(temperature + previousTemperature) / 2 * (humidity + previousHumidity) / 200,
+                    (pump + previousPump) / 2};
+      fit(x, (humidity - previousHumidity) / hours);
+      if (samples < MIN_SAMPLES)
+        samples++;
+    }
+
+    hasPrevious = true;
+    previousHumidity = humidity;
+    previousTemperature = temperature;
+    previousPump = pump;
+    previousStartMs = intervalStartMs;
+
+    intervalStartMs = nowMs;
+    humiditySum = 0;
+    temperatureSum = 0;
+    readings = 0;
+    pumpOnMs = 0;
+  }
+
+  // Un paso de RLS: theta += K·(y - x·theta), P = (P - K·xᵀ·P) / λ
+  void fit(const float* x, float y)
+  {
+    float px[2] = {covariance[0] * x[0] + covariance[1] * x[1],
+                   covariance[1] * x[0] + covariance[2] * x[1]};
+    float denominator = FORGETTING + x[0] * px[0] + x[1] * px[1];
+    float gain[2] = {px[0] / denominator, px[1] / denominator};
+    float error = y - (x[0] * theta[0] + x[1] * theta[1]);
+    theta[0] += gain[0] * error;
+    theta[1] += gain[1] * error;
+
+    float forgetting = FORGETTING;
+    if (covariance[0] + covariance[2] > MAX_COVARIANCE)
+      forgetting = 1;
+    covariance[0] = (covariance[0] - gain[0] * px[0]) / forgetting;
+    covariance[1] = (covariance[1] - gain[0] * px[1]) / forgetting;
+    covariance[2] = (covariance[2] - gain[1] * px[1]) / forgetting;
+  }
+
+  bool started = false;
+  unsigned long lastUpdateMs = 0;
+  unsigned long lastPumpMs = 0;
+
+  unsigned long intervalStartMs = 0;
+  float humiditySum = 0;
+  float temperatureSum = 0;
+  uint16_t readings = 0;
+  unsigned long pumpOnMs = 0;
+
+  bool hasPrevious = false;
+  float previousHumidity = 0;
+  float previousTemperature = 0;
+  float previousPump = 0;
+  unsigned long previousStartMs = 0;
+
+  float theta[2] = {0, 0};                               // Evaporación y ganancia de la bomba
+  float covariance[3] = {INITIAL_COVARIANCE, 0, INITIAL_COVARIANCE}; // P simétrica: p00, p01, p11
+  uint8_t samples = 0;
+};
+
+#endif
@@ -0,0 +1,36 @@
+// Perfilador por muestreo para el Arduino Uno
+// El Timer1 interrumpe unas 1000 veces por segundo y anota en un histograma la
+// dirección de flash donde estaba ejecutándose el programa. Cada PROFILER_REPORT_MS
+// el histograma se envía por el puerto serie y tools/profile_report.py lo traduce a
+// funciones con el ELF del firmware.
+//
+// Solo se compila con -DENABLE_PROFILER (entorno uno_profile); en otro caso las
+// funciones no hacen nada. Necesita el puerto serie habilitado en la configuración.
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+#include "serial_frame.h"
+
+const uint8_t PROFILER_BUCKETS = 128;            // Casillas del histograma (256 bytes de SRAM)
+const unsigned long PROFILER_REPORT_MS = 5000UL; // Intervalo entre envíos del histograma
+
+// Formato de cada envío por el puerto serie (little endian):
+// FRAME_SYNC 'P' | desplazamiento (1) | casillas (1) | muestras (4) | fuera de rango (2) |
+// casillas x 2 bytes | suma de comprobación (1, suma de todo lo anterior a partir de 'P')
+const uint8_t PROFILER_TAG = 'P';
+
+#if defined(ENABLE_PROFILER) && defined(__AVR__)
+// Configura el Timer1 y el puerto serie y empieza a muestrear
+void profilerBegin();
+
+// Envía el histograma cuando toca; se llama desde loop()
+void profilerService();
+#else
+inline void profilerBegin() {}
+inline void profilerService() {}
+#endif
+
+#endif
@@ -0,0 +1,52 @@
+// Planificación del riego según las ventanas de tarifa
+// En la ventana más barata del día la regla del cultivo llena el suelo hasta el máximo.
+// En las ventanas caras el riego se pospone mientras la humedad prevista se mantenga
+// sobre el mínimo del cultivo durante los próximos GUARD_MINUTES o hasta que empiece
+// una ventana más barata; así solo se compra en horas caras el agua imprescindible.
+//
+// El momento en que la humedad cruza el mínimo lo pronostica MoistureForecaster con el
+// modelo de secado ajustado a la zona.
+
+#ifndef PUMP_SCHEDULER_H
+#define PUMP_SCHEDULER_H
+
+#include "moisture_forecaster.h"
+#include "tariff.h"
+
+class PumpScheduler {
+public:
+  static const uint16_t GUARD_MINUTES = 10;               // Anticipación con la que se riega en ventanas caras
+
+  PumpScheduler(const TariffWindow* windows, uint8_t count, const MoistureForecaster& forecaster)
+    : windows(windows), count(count), forecaster(forecaster) {}
+
+  // Decide si la bomba debe funcionar ahora
+  bool shouldRun(bool irrigationNeeded, float humidity, float temperature, float minHumidity, uint16_t minuteOfDay) const
+  {
+    if (!irrigationNeeded || count == 0)
+      return irrigationNeeded;
+
+    // En la ventana más barata se sigue la regla del cultivo: se llena hasta el máximo
+    uint16_t wait = minutesUntilCheaper(windows, count, minuteOfDay);
+    if (wait == NO_CHEAPER_WINDOW)
+      return true;
+
+    // Sin un modelo ajustado no se sabe cuánto se puede esperar
+    if (!forecaster.ready() || humidity <= minHumidity)
+      return true;
+
+    // En una ventana cara solo se riega lo necesario para no bajar del mínimo
+    // durante el horizonte de guarda o hasta que empiece la ventana más barata
+    uint16_t horizon = GUARD_MINUTES;
+    if (wait < horizon)
+      horizon = wait;
+    return forecaster.minutesUntil(humidity, minHumidity, temperature) <= horizon;
+  }
+
+private:
+  const TariffWindow* windows;
+  uint8_t count;
+  const MoistureForecaster& forecaster;
+};
+
+#endif
@@ -0,0 +1,49 @@
+// Salida del relé de la bomba sincronizada con el cruce por cero de la red
+// Conmutar una bomba de corriente alterna en cualquier punto de la onda desgasta los
+// contactos del relé por el arco. Si la configuración define "zero_cross", el control
+// deja las órdenes en una cola y la interrupción del detector de cruce por cero las
+// aplica: tras RELAY_SWITCH_DELAY_US (Timer2) se energiza la bobina para que los
+// contactos cierren o abran justo en un cruce posterior.
+//
+// Si no llegan cruces durante ZERO_CROSS_TIMEOUT_MS (detector desconectado o bomba
+// de corriente continua) las órdenes se aplican al momento y se cuentan como no
+// sincronizadas. La interrupción del detector anota el millis() de cada cruce, y
+// mientras haya órdenes en la cola el Timer2 revisa ese tiempo cada 16 ms, así la
+// falla se nota aunque loop() esté detenido en un delay(). Sin "zero_cross" el relé conmuta al recibir la orden, como antes.
+//
+// Cada orden lleva el instante de la lectura de los sensores que la decidió; al
+// escribir el pin se guarda la latencia hasta ese momento, que loop() retira con
+// relayNextLatency(). Así la latencia del control incluye la espera del cruce por cero.
+
+#ifndef RELAY_SWITCH_H
+#define RELAY_SWITCH_H
+
+#include <stdint.h>
+
+const uint8_t RELAY_QUEUE_SIZE = 4;                // Órdenes pendientes (potencia de 2)
+const unsigned long ZERO_CROSS_TIMEOUT_MS = 100UL; // Sin cruces en este tiempo se conmuta directo
+const uint8_t RELAY_LATENCY_SLOTS = 8;             // Latencias sin retirar (potencia de 2, más que la cola)
+
+// Contadores de desgaste de los contactos desde el encendido
+struct RelayWear {
+  uint32_t operations;     // Conmutaciones del relé
+  uint32_t synchronized;   // Conmutaciones en un cruce por cero
+  uint32_t unsynchronized; // Conmutaciones sin cruces disponibles
+  uint16_t dropped;        // Órdenes descartadas con la cola llena
+};
+
+// Configura la salida y el detector de cruce por cero
+void relayBegin();
+
+// Pide encender o apagar la bomba según la lectura tomada en sampleMicros; se aplica
+// en el próximo cruce por cero
+void relayCommand(bool on, unsigned long sampleMicros);
+
+// Retira la latencia de la próxima orden aplicada, desde la lectura hasta la escritura
+// del pin; devuelve false si no quedan
+bool relayNextLatency(unsigned long& latencyMicros);
+
+// Copia de los contadores, sin deshabilitar las interrupciones
+RelayWear relayWear();
+
+#endif
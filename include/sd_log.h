@@ -0,0 +1,83 @@
+// Registro de lecturas en una tarjeta SD, sin sistema de archivos
+// Las lecturas se guardan como registros de 16 bytes en bloques de 512 bytes de una
+// zona reservada de la tarjeta (SD_LOG_START_BLOCK, SD_LOG_BLOCKS). Cada bloque empieza
+// con un registro de cabecera con su número, así al iniciar se busca por bisección el
+// primer bloque libre y se sigue escribiendo a continuación: la tarjeta solo crece.
+//
+// No hay buffer de 512 bytes (un cuarto de la SRAM): el bloque se abre con CMD24 y
+// cada registro se envía en cuanto llega. Al completar el bloque la tarjeta lo graba
+// mientras loop() sigue; sdLogService() comprueba sin esperar si terminó, y mientras
+// tanto los registros nuevos esperan en una cola de SD_LOG_QUEUE registros.
+// Si se corta la alimentación se pierde el bloque abierto (hasta 31 registros).
+//
+// Sin buffer del bloque, los registros ya enviados no se pueden reenviar: si la tarjeta
+// rechaza un bloque se vuelve a escribir el mismo número con las lecturas siguientes y
+// las del bloque rechazado se cuentan como perdidas, igual que las que no entran en la
+// cola. La cabecera de cada bloque lleva las perdidas desde el bloque anterior.
+//
+// La zona no tiene valor por defecto: al iniciar se lee la tabla de particiones del
+// MBR y el registro no arranca si la zona pisa alguna partición.
+//
+// tools/sdlog_dump.py lee la tarjeta (o una imagen) y escribe las lecturas en CSV.
+
+#ifndef SD_LOG_H
+#define SD_LOG_H
+
+#include <stdint.h>
+
+#include "board_config.h"
+
+const uint16_t SD_BLOCK_SIZE = 512;
+const uint8_t SD_RECORD_SIZE = 16;
+const uint8_t SD_RECORDS_PER_BLOCK = SD_BLOCK_SIZE / SD_RECORD_SIZE; // Incluida la cabecera
+const uint8_t SD_LOG_QUEUE = 4; // Registros que esperan mientras la tarjeta graba
+
+// Formato (little endian, el último byte es la suma de los 15 anteriores):
+// Cabecera 'H' | versión (1) | arranque (2) | número de bloque en la zona (4) |
+//          millis() (4) | referencia del TMP36 en mV (2) |
+//          lecturas perdidas desde el bloque anterior (1, satura en 255) | suma (1)
+// Lectura  'R' | estado (1: bit 0 bomba, bit 1 alarma de latencia, bits 2-5 anomalías
+//          de AnomalyDetector) | millis() (4) |
+//          temperatura cruda (2) | humedad cruda (2) | lecturas del ADC (2) |
+//          conmutaciones del relé (2) | cultivo (1) | suma (1)
+const uint8_t SD_LOG_VERSION = 1;
+const uint8_t SD_HEADER_TAG = 'H';
+const uint8_t SD_READING_TAG = 'R';
+
+// Lectura que se guarda en la tarjeta
+struct SdLogReading {
+  unsigned long millis;
+  uint16_t rawTemperature;
+  uint16_t rawHumidity;
+  uint16_t samples;
+  uint16_t relayOperations;
+  bool motorOn;
+  bool latencyAlarm;
+  uint8_t crop;
+  uint8_t anomalies; // AnomalyDetector::active()
+};
+
+// Resultado de sdLogBegin()
+enum SdLogStatus : uint8_t {
+  SD_LOG_READY,     // Registrando
+  SD_LOG_NO_CARD,   // Sin registro en la configuración, o la tarjeta no respondió
+  SD_LOG_PARTITION, // La zona pisa una partición de la tarjeta
+  SD_LOG_FULL,      // La zona ya está llena
+};
+
+#if SD_LOG_ENABLED
+// Inicia la tarjeta, comprueba la zona y busca el punto de escritura
+SdLogStatus sdLogBegin();
+
+// Agrega una lectura a la cola; se escribe en sdLogService()
+void sdLogAppend(const SdLogReading& reading);
+
+// Envía los registros pendientes sin esperar a la tarjeta; se llama desde loop()
+void sdLogService();
+#else
+inline SdLogStatus sdLogBegin() { return SD_LOG_NO_CARD; }
+inline void sdLogAppend(const SdLogReading&) {}
+inline void sdLogService() {}
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+// Lectura de los sensores por interrupciones
+// El comparador B del Timer0 (el mismo temporizador de millis(), ~1 kHz) inicia cada
+// SAMPLE_PERIOD_TICKS una conversión del ADC en el canal de temperatura y, cuando
+// termina, la interrupción del ADC lee el valor e inicia la del canal de humedad.
+// Con las dos lecturas se publica una copia en un SeqLock, así loop() nunca espera
+// al ADC y siempre ve las dos lecturas de la misma pasada.
+//
+// Si la configuración define "probe_power", el YL-69 se alimenta desde un pin solo
+// durante cada lectura para reducir la corrosión de la sonda y el consumo: la pasada
+// enciende el pin, espera PROBE_SETTLE_MS en ticks del temporizador, promedia
+// PROBE_BURST lecturas de humedad y lo apaga, cada PROBE_PERIOD_MS.
+//
+// Con "temperature_reference": "internal" el TMP36 se lee con la referencia de 1.1 V
+// (unos 0.1 °C por cuenta en lugar de 0.5 °C, hasta 60 °C) y la humedad con AVcc.
+// Tras cada cambio de referencia se espera en ticks a que se estabilice AREF y se
+// descarta la primera conversión.
+//
+// En el host (entorno native) HostArduino llama a la interrupción del temporizador
+// con el reloj virtual y la conversión termina de inmediato.
+
+#ifndef SENSOR_SAMPLER_H
+#define SENSOR_SAMPLER_H
+
+#include <stdint.h>
+
+const unsigned int SAMPLER_TICK_US = 1024; // Periodo del Timer0 (16 MHz / 64 / 256)
+const uint8_t SAMPLE_PERIOD_TICKS = 98;    // Ticks entre lecturas con la sonda siempre alimentada, ~100 ms
+
+// Última lectura de los sensores
+struct SensorSnapshot {
+  uint16_t rawTemperature;    // Valor del ADC del TMP36
+  uint16_t rawHumidity;       // Valor del ADC del YL-69
+  unsigned long sampleMicros; // micros() al terminar la última conversión de humedad
+  uint16_t samples;           // Lecturas publicadas desde el inicio (da la vuelta)
+};
+
+// Hace una primera lectura y empieza a leer por interrupciones
+void sensorSamplerBegin();
+
+// Copia de la última lectura, sin deshabilitar las interrupciones
+SensorSnapshot sensorSnapshot();
+
+#endif
@@ -0,0 +1,122 @@
+// Valor compartido entre una interrupción que lo escribe y el programa principal que lo lee
+// Un valor de varios bytes puede quedar a medias si la interrupción llega mientras
+// loop() lo copia. Con el contador de secuencia el escritor lo deja impar mientras
+// escribe y lo vuelve par al terminar; el lector copia el valor y repite la copia si el
+// contador cambió entre medio. Ninguno de los dos deshabilita las interrupciones.
+//
+// Un solo escritor: la interrupción, o el programa principal con las interrupciones
+// deshabilitadas antes de habilitar la que escribe.
+//
+// En el AVR alcanza con impedir que el compilador reordene los accesos, y un contador
+// de 8 bits no llega a dar la vuelta mientras loop() copia el valor. En el host el
+// escritor y el lector pueden ser hilos en núcleos distintos (test/test_seqlock): el
+// lector puede quedar suspendido mientras el escritor da cientos de vueltas, así que el
+// contador es de 32 bits, y el valor se copia byte a byte con accesos atómicos de
+// adquisición y liberación que lo ordenan respecto del contador, como pide el modelo
+// de memoria de C++ para no tener carreras de datos.
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+
+#ifdef __AVR__
+
+template <typename T>
+class SeqLock {
+public:
+  void write(const T& value)
+  {
+    sequence = sequence + 1; // Impar: escritura en curso
+    barrier();
+    data = value;
+    barrier();
+    sequence = sequence + 1;
+  }
+
+  T read() const
+  {
+    T copy;
+    uint8_t start;
+    do
+    {
+      start = sequence;
+      barrier();
+      copy = data;
+      barrier();
+    } while ((start & 1) != 0 || sequence != start);
+    return copy;
+  }
+
+  // Cambia en cada escritura; sirve para saber si hay un valor nuevo sin copiarlo
+  uint8_t version() const { return sequence; }
+
+private:
+  // Impide que el compilador mueva los accesos a data fuera de los cambios del contador
+  static void barrier() { __asm__ __volatile__("" ::: "memory"); }
+
+  volatile uint8_t sequence = 0;
+  T data = T();
+};
+
+#else
+
+#include <atomic>
+#include <string.h>
+
+template <typename T>
+class SeqLock {
+public:
+  SeqLock() { store(T()); }
+
+  void write(const T& value)
+  {
+    uint32_t start = sequence.load(std::memory_order_relaxed);
+    sequence.store(start + 1, std::memory_order_relaxed); // Impar: escritura en curso
+    store(value);
+    sequence.store(start + 2, std::memory_order_release);
+  }
+
+  T read() const
+  {
+    T copy;
+    uint32_t start;
+    do
+    {
+      start = sequence.load(std::memory_order_acquire);
+      copy = load();
+    } while ((start & 1) != 0 || sequence.load(std::memory_order_relaxed) != start);
+    return copy;
+  }
+
+  // Cambia en cada escritura; sirve para saber si hay un valor nuevo sin copiarlo
+  uint8_t version() const { return (uint8_t)sequence.load(std::memory_order_acquire); }
+
+private:
+  // Quien lea un byte nuevo ve también el contador impar que lo precede
+  void store(const T& value)
+  {
+    unsigned char bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    for (size_t i = 0; i < sizeof(T); i++)
+      data[i].store(bytes[i], std::memory_order_release);
+  }
+
+  // La última lectura del contador no puede adelantarse a la de los bytes
+  T load() const
+  {
+    unsigned char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); i++)
+      bytes[i] = data[i].load(std::memory_order_acquire);
+    T value;
+    memcpy(&value, bytes, sizeof(T));
+    return value;
+  }
+
+  std::atomic<uint32_t> sequence{0};
+  std::atomic<unsigned char> data[sizeof(T)];
+};
+
+#endif
+
+#endif
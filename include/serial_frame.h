@@ -0,0 +1,13 @@
+// Sincronización común de los envíos binarios por el puerto serie
+// Cada envío empieza con FRAME_SYNC_1 FRAME_SYNC_2 y una letra que indica su tipo
+// ('P' perfilador, 'T' trazas), lo que permite mezclarlos en el mismo puerto.
+
+#ifndef SERIAL_FRAME_H
+#define SERIAL_FRAME_H
+
+#include <stdint.h>
+
+const uint8_t FRAME_SYNC_1 = 0xA5;
+const uint8_t FRAME_SYNC_2 = 0x5A;
+
+#endif
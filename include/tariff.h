@@ -0,0 +1,51 @@
+// Ventanas de tarifa eléctrica del día
+// Cada ventana cubre [startMinute, endMinute) minutos desde la medianoche con un precio
+// por kWh; la configuración (config/board.json) garantiza que cubren las 24 horas sin solaparse.
+
+#ifndef TARIFF_H
+#define TARIFF_H
+
+#include <stdint.h>
+
+const uint16_t MINUTES_PER_DAY = 1440;
+const uint16_t NO_CHEAPER_WINDOW = 0xFFFF;
+
+struct TariffWindow {
+  uint16_t startMinute;
+  uint16_t endMinute;
+  float price;
+};
+
+// Ventana que contiene el minuto del día indicado
+inline const TariffWindow* tariffAt(const TariffWindow* windows, uint8_t count, uint16_t minuteOfDay)
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (minuteOfDay >= windows[i].startMinute && minuteOfDay < windows[i].endMinute)
+      return &windows[i];
+  }
+  return count > 0 ? &windows[0] : nullptr;
+}
+
+// Minutos que faltan para que empiece una ventana más barata que la actual
+// Devuelve NO_CHEAPER_WINDOW si la ventana actual es la más barata del día
+inline uint16_t minutesUntilCheaper(const TariffWindow* windows, uint8_t count, uint16_t minuteOfDay)
+{
+  const TariffWindow* current = tariffAt(windows, count, minuteOfDay);
+  if (current == nullptr)
+    return NO_CHEAPER_WINDOW;
+
+  uint16_t best = NO_CHEAPER_WINDOW;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (windows[i].price >= current->price)
+      continue;
+
+    uint16_t wait = (windows[i].startMinute + MINUTES_PER_DAY - minuteOfDay) % MINUTES_PER_DAY;
+    if (wait < best)
+      best = wait;
+  }
+  return best;
+}
+
+#endif
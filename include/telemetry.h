@@ -0,0 +1,75 @@
+// Telemetría comprimida por el puerto serie (include/telemetry_codec.h)
+// telemetryRecord() agrega un registro al envío en curso y telemetryFlush() lo envía
+// cuando se llena o cuando pasan TELEMETRY_MAX_DELAY_MS desde el primer registro, solo
+// si cabe en el buffer de transmisión, así que nunca bloquea. Si el envío no sale a
+// tiempo los registros nuevos se descartan y se cuentan. tools/telemetry_decode.py
+// recibe los envíos, los descomprime y muestra la relación de compresión.
+//
+// Cada TELEMETRY_STATS_INTERVAL_MS se envía además un resumen del estado del firmware
+// (latencia del control, duración del ciclo, desgaste del relé, fallas, anomalías y el
+// pronóstico de la humedad),
+// que tools/telemetry_decode.py publica en formato Prometheus con --metrics-port.
+//
+// Solo se compila con -DENABLE_TELEMETRY (entorno uno_telemetry); en otro caso las
+// funciones no generan código.
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+#include "serial_frame.h"
+#include "telemetry_codec.h"
+
+const uint8_t TELEMETRY_FRAME_BYTES = 48;             // Datos comprimidos por envío (cabe en el buffer de 64 bytes)
+const unsigned long TELEMETRY_MAX_DELAY_MS = 15000UL; // Antigüedad máxima del primer registro de un envío
+
+// Formato de cada envío por el puerto serie:
+// FRAME_SYNC 'C' | número de envío (1) | registros descartados (1) | bytes (1) |
+// datos comprimidos | suma de comprobación (1, suma de todo lo anterior a partir de 'C')
+const uint8_t TELEMETRY_TAG = 'C';
+
+const unsigned long TELEMETRY_STATS_INTERVAL_MS = 60000UL; // Tiempo entre resúmenes
+
+// Resumen del estado del firmware
+// Formato de cada envío: FRAME_SYNC 'S' | campos en el orden de la estructura (little
+// endian, las alarmas en un byte) | suma de comprobación (a partir de 'S')
+const uint8_t TELEMETRY_STATS_TAG = 'S';
+
+struct TelemetryStats {
+  uint32_t uptimeSeconds;
+  uint16_t loopMillis;           // Duración del último ciclo de loop()
+  uint32_t latencyP50Micros;     // Latencia entre la lectura y el relé
+  uint32_t latencyP99Micros;
+  uint32_t latencyMaxMicros;
+  bool latencyAlarm;
+  uint32_t relayOperations;      // Contadores de RelayWear
+  uint32_t relaySynchronized;
+  uint32_t relayUnsynchronized;
+  uint16_t relayDropped;
+  uint16_t sensorFaults;         // Lecturas fuera de rango de los sensores
+  uint16_t telemetryDropped;     // Registros de telemetría descartados desde el inicio (lo completa telemetrySendStats)
+  uint8_t anomalies;             // AnomalyDetector::active()
+  uint16_t dryMinutes;           // Minutos hasta bajar del mínimo del cultivo sin regar (0xFFFF sin cruce)
+  uint16_t evaporationMilli;     // Coeficiente de evaporación ajustado en milésimas, 0 sin pronóstico
+};
+
+#if defined(ENABLE_TELEMETRY) && defined(__AVR__)
+#define TELEMETRY_ENABLED 1
+
+void telemetryBegin();
+void telemetryRecord(const uint16_t* values);
+void telemetryFlush();
+
+// Envía el resumen si cabe en el buffer de transmisión; devuelve false si no se envió
+bool telemetrySendStats(const TelemetryStats& stats);
+#else
+#define TELEMETRY_ENABLED 0
+
+inline void telemetryBegin() {}
+inline void telemetryRecord(const uint16_t*) {}
+inline void telemetryFlush() {}
+inline bool telemetrySendStats(const TelemetryStats&) { return false; }
+#endif
+
+#endif
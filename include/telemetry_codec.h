@@ -0,0 +1,144 @@
+// Compresión de la telemetría para enlaces lentos (RS-485 a 9600 baudios)
+// Cada registro son TELEMETRY_FIELDS valores de 16 bits que cambian poco entre lecturas.
+// En lugar de enviar los 10 bytes se envía la diferencia con el registro anterior:
+// - un byte con la máscara de los campos que cambiaron, seguido de sus diferencias en
+//   zigzag (los negativos pequeños quedan pequeños) y varint (7 bits por byte);
+// - el primer campo es el tiempo, que avanza a ritmo casi constante: se codifica la
+//   diferencia de su delta, que casi siempre es 0;
+// - los registros sin cambios se agrupan en un solo byte de repetición;
+// - cada KEYFRAME_INTERVAL registros va un registro completo, para que el receptor se
+//   recupere si pierde un envío.
+// Los códigos son: 0x01-0x7F máscara, 0x80 | n repetición de n registros, 0xFF completo.
+// tools/telemetry_decode.py hace la operación inversa.
+
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <stdint.h>
+
+// Campos de cada registro (el orden se repite en tools/telemetry_decode.py)
+enum TelemetryField : uint8_t {
+  TELEMETRY_TIME = 0,        // Lecturas del ADC publicadas (una cada ~100 ms)
+  TELEMETRY_TEMPERATURE = 1, // Temperatura cruda
+  TELEMETRY_HUMIDITY = 2,    // Humedad cruda
+  TELEMETRY_STATUS = 3,      // Bit 0 bomba, bit 1 alarma de latencia, cultivo desde el bit 2
+  TELEMETRY_RELAY = 4,       // Conmutaciones del relé
+  TELEMETRY_FIELDS = 5,
+};
+
+class TelemetryEncoder {
+public:
+  static const uint8_t TOKEN_RUN = 0x80;
+  static const uint8_t TOKEN_KEYFRAME = 0xFF;
+  static const uint8_t MAX_RUN = 0x7E;               // 0x80 | 0x7F sería el registro completo
+  static const uint8_t KEYFRAME_INTERVAL = 64;       // Registros entre registros completos
+  static const uint8_t MAX_RECORD_BYTES = 1 + 3 * TELEMETRY_FIELDS; // Código y varint de 16 bits
+
+  // buffer: donde se escriben los códigos; capacity: su tamaño
+  TelemetryEncoder(uint8_t* buffer, uint8_t capacity) : buffer(buffer), capacity(capacity) {}
+
+  // Agrega un registro; devuelve false sin cambiar nada si no cabe en el buffer
+  bool push(const uint16_t* values)
+  {
+    // Se reserva un byte para la repetición pendiente que cierra finish()
+    if (length + 1 + MAX_RECORD_BYTES > capacity)
+      return false;
+
+    if (sinceKeyframe == 0)
+    {
+      writeRun();
+      buffer[length++] = TOKEN_KEYFRAME;
+      for (uint8_t i = 0; i < TELEMETRY_FIELDS; i++)
+        writeVarint(values[i]);
+      timeDelta = 0;
+    }
+    else
+    {
+      uint16_t residuals[TELEMETRY_FIELDS];
+      uint8_t mask = 0;
+      for (uint8_t i = 0; i < TELEMETRY_FIELDS; i++)
+      {
+        uint16_t delta = values[i] - previous[i];
+        residuals[i] = i == TELEMETRY_TIME ? (uint16_t)(delta - timeDelta) : delta;
+        if (residuals[i] != 0)
+          mask |= 1 << i;
+      }
+      timeDelta = values[TELEMETRY_TIME] - previous[TELEMETRY_TIME];
+
+      if (mask == 0)
+      {
+        if (++run == MAX_RUN)
+          writeRun();
+      }
+      else
+      {
+        writeRun();
+        buffer[length++] = mask;
+        for (uint8_t i = 0; i < TELEMETRY_FIELDS; i++)
+        {
+          if (mask & (1 << i))
+            writeVarint(zigzag(residuals[i]));
+        }
+      }
+    }
+
+    for (uint8_t i = 0; i < TELEMETRY_FIELDS; i++)
+      previous[i] = values[i];
+    if (++sinceKeyframe == KEYFRAME_INTERVAL)
+      sinceKeyframe = 0;
+    records++;
+    return true;
+  }
+
+  // Cierra la repetición pendiente; se llama antes de enviar el buffer
+  void finish() { writeRun(); }
+
+  // Vacía el buffer ya enviado; las diferencias siguen contra el último registro
+  void clear()
+  {
+    length = 0;
+    records = 0;
+  }
+
+  // El próximo registro va completo (por ejemplo tras perder un envío)
+  void forceKeyframe() { sinceKeyframe = 0; }
+
+  uint8_t size() const { return length; }
+  uint16_t recordCount() const { return records; }
+
+private:
+  static uint16_t zigzag(uint16_t value)
+  {
+    int16_t signedValue = (int16_t)value;
+    return (uint16_t)(signedValue << 1) ^ (uint16_t)(signedValue >> 15);
+  }
+
+  void writeVarint(uint16_t value)
+  {
+    while (value >= 0x80)
+    {
+      buffer[length++] = (uint8_t)value | 0x80;
+      value >>= 7;
+    }
+    buffer[length++] = (uint8_t)value;
+  }
+
+  void writeRun()
+  {
+    if (run == 0)
+      return;
+    buffer[length++] = TOKEN_RUN | run;
+    run = 0;
+  }
+
+  uint8_t* buffer;
+  uint8_t capacity;
+  uint8_t length = 0;
+  uint8_t run = 0;
+  uint8_t sinceKeyframe = 0;
+  uint16_t records = 0;
+  uint16_t previous[TELEMETRY_FIELDS] = {0};
+  uint16_t timeDelta = 0;
+};
+
+#endif
@@ -0,0 +1,51 @@
+// Trazas de eventos para ver en Chrome (chrome://tracing) o Perfetto
+// TRACE_BEGIN(id) y TRACE_END(id) marcan el inicio y el fin de una tarea. Cada evento
+// ocupa 4 bytes en un buffer circular: el id con un bit de inicio/fin y los 24 bits
+// bajos de micros() / 4. traceFlush() los envía por el puerto serie solo si caben en
+// el buffer de transmisión, así que nunca bloquea; tools/trace_convert.py los convierte
+// a JSON.
+//
+// Solo se compila con -DENABLE_TRACE (entorno uno_trace); en otro caso las macros no
+// generan código. Los eventos se registran desde el programa principal, no desde interrupciones.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#include "serial_frame.h"
+
+// Tareas instrumentadas (los nombres se repiten en tools/trace_convert.py)
+enum TraceId : uint8_t {
+  TRACE_SENSE = 0,   // Lectura de sensores
+  TRACE_CONTROL = 1, // Decisión de riego y salida al relé
+  TRACE_DISPLAY = 2, // Escritura en la pantalla
+  TRACE_KEYPAD = 3,  // Lectura del teclado
+  TRACE_DELAY = 4,   // Esperas bloqueantes con delay()
+};
+
+const uint8_t TRACE_BUFFER_EVENTS = 32; // Eventos en el buffer circular (128 bytes de SRAM)
+const uint8_t TRACE_FRAME_EVENTS = 12;  // Máximo de eventos por envío
+
+// Formato de cada envío por el puerto serie:
+// FRAME_SYNC 'T' | eventos (1) | eventos perdidos (1) | eventos x 4 bytes |
+// suma de comprobación (1, suma de todo lo anterior a partir de 'T')
+// Cada evento: (id << 1 | fin) seguido del tiempo en unidades de 4 us (24 bits, little endian)
+const uint8_t TRACE_TAG = 'T';
+
+#if defined(ENABLE_TRACE) && defined(__AVR__)
+void traceBegin();
+void traceEvent(uint8_t id, bool end);
+void traceFlush();
+
+#define TRACE_BEGIN(id) traceEvent((id), false)
+#define TRACE_END(id) traceEvent((id), true)
+#else
+inline void traceBegin() {}
+inline void traceFlush() {}
+
+#define TRACE_BEGIN(id) ((void)0)
+#define TRACE_END(id) ((void)0)
+#endif
+
+#endif
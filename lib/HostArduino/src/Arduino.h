@@ -0,0 +1,102 @@
+// Capa de la API de Arduino para ejecutar el firmware en el host (entorno native)
+// El tiempo es virtual: delay() y delayMicroseconds() lo avanzan sin esperar,
+// de modo que una ejecución de varios minutos de firmware tarda milisegundos.
+//
+// Variables de entorno reconocidas:
+// - HOST_RUN_MS: tiempo virtual máximo de la ejecución (por defecto 60000 ms)
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+#include "WString.h"
+
+// Definida solo en el host, para el código del firmware que avisa a los emuladores
+#define ARDUINO_HOST 1
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+// Referencias del ADC del ATmega328P (valor de REFS1:0)
+#define EXTERNAL 0
+#define DEFAULT 1
+#define INTERNAL 3
+
+// Numeración de pines analógicos del Arduino Uno
+#define NUM_DIGITAL_PINS 20
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+
+// ======== API DE ARDUINO ========
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogReference(uint8_t mode);
+
+// En el host las interrupciones solo ocurren dentro de delay(), nunca a mitad de una instrucción
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Funciones del sketch
+void setup();
+void loop();
+
+// ======== CONTROL DEL HOST ========
+// Funciones para que los emuladores y herramientas manipulen el entorno simulado
+
+// Avanza el reloj virtual sin pasar por delay()
+void hostAdvanceMicros(unsigned long us);
+
+// Fija el valor (0-1023) que devuelve analogRead() en un pin
+void hostSetAnalog(uint8_t pin, int value);
+
+// Fuente alternativa de lecturas analógicas; si devuelve < 0 se usa el valor fijado.
+// La fuente debe escalar el valor según hostAnalogReference()
+void hostSetAnalogProvider(int (*provider)(uint8_t pin));
+
+// Referencia elegida con analogReference() (DEFAULT al iniciar)
+uint8_t hostAnalogReference();
+
+// Nivel actual de un pin configurado como salida
+int hostDigitalOutput(uint8_t pin);
+
+// Función que se llama en cada digitalWrite(), antes de cambiar el nivel del pin
+void hostOnDigitalWrite(void (*hook)(uint8_t pin, uint8_t value));
+
+// Registra una interrupción del temporizador: se llama cada HOST_TICK_US de tiempo
+// virtual, como el Timer0 de la placa, en el orden de registro. No debe avanzar el reloj.
+const unsigned long HOST_TICK_US = 1024;
+void hostOnTick(void (*hook)());
+
+// El firmware avisa del cultivo elegido en el menú (desde 1); los emuladores que miden
+// contra su rango se registran con hostOnCropSelected()
+void hostCropSelected(uint8_t crop);
+void hostOnCropSelected(void (*hook)(uint8_t crop));
+
+// Registra una función que se ejecuta al terminar la simulación
+void hostAtExit(void (*hook)());
+
+// Termina la simulación ejecutando las funciones registradas
+void hostFinish();
+
+#endif
@@ -0,0 +1,36 @@
+// Implementación del bus SPI emulado
+
+#include "SPI.h"
+
+SPIClass SPI;
+
+namespace {
+
+uint8_t (*spiDevice)(uint8_t) = nullptr;
+uint32_t spiClock = 4000000;
+
+} // namespace
+
+void SPIClass::begin()
+{
+  // Como en la placa, SS queda como salida para que el ATmega siga siendo maestro
+  pinMode(10, OUTPUT);
+  digitalWrite(10, HIGH);
+}
+
+void SPIClass::beginTransaction(SPISettings settings)
+{
+  spiClock = settings.clock;
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+  // Cada byte ocupa 8 ciclos del reloj del bus
+  hostAdvanceMicros(8000000UL / spiClock);
+  return spiDevice != nullptr ? spiDevice(data) : 0xFF;
+}
+
+void hostSpiAttach(uint8_t (*device)(uint8_t mosi))
+{
+  spiDevice = device;
+}
@@ -0,0 +1,41 @@
+// Sustituto de la librería SPI para el entorno native
+// Cada byte transferido se entrega al dispositivo conectado con hostSpiAttach(), que
+// devuelve el byte que el esclavo pone en MISO. Sin dispositivo la línea queda en alto.
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings {
+public:
+  SPISettings() {}
+  SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+
+  uint32_t clock = 4000000;
+  uint8_t bitOrder = MSBFIRST;
+  uint8_t dataMode = SPI_MODE0;
+};
+
+class SPIClass {
+public:
+  void begin();
+  void end() {}
+  void beginTransaction(SPISettings settings);
+  void endTransaction() {}
+  uint8_t transfer(uint8_t data);
+};
+
+extern SPIClass SPI;
+
+// Conecta el dispositivo esclavo del bus
+void hostSpiAttach(uint8_t (*device)(uint8_t mosi));
+
+#endif
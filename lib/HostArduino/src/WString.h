@@ -0,0 +1,43 @@
+// Clase String compatible con la de Arduino para las compilaciones en el host
+// Solo implementa lo que usa el firmware: construcción desde texto y números,
+// concatenación con + y acceso al texto
+
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+#include <string>
+
+class String {
+public:
+  String() {}
+  String(const char* text) : value(text ? text : "") {}
+  String(const std::string& text) : value(text) {}
+  String(char c) : value(1, c) {}
+  String(int number) : value(std::to_string(number)) {}
+  String(unsigned int number) : value(std::to_string(number)) {}
+  String(long number) : value(std::to_string(number)) {}
+  String(unsigned long number) : value(std::to_string(number)) {}
+  String(unsigned char number) : value(std::to_string(number)) {}
+  String(float number, unsigned char decimals = 2) : value(formatFloat(number, decimals)) {}
+  String(double number, unsigned char decimals = 2) : value(formatFloat(number, decimals)) {}
+
+  const char* c_str() const { return value.c_str(); }
+  unsigned int length() const { return value.size(); }
+  char operator[](unsigned int index) const { return index < value.size() ? value[index] : 0; }
+
+  String& operator+=(const String& other) { value += other.value; return *this; }
+  bool operator==(const String& other) const { return value == other.value; }
+  bool operator!=(const String& other) const { return value != other.value; }
+
+  friend String operator+(const String& a, const String& b) { return String(a.value + b.value); }
+  friend String operator+(const String& a, const char* b) { return String(a.value + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.value); }
+
+private:
+  // Igual que en Arduino: número con la cantidad de decimales indicada
+  static std::string formatFloat(double number, unsigned char decimals);
+
+  std::string value;
+};
+
+#endif
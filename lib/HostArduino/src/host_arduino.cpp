@@ -0,0 +1,209 @@
+// Implementación de la capa de Arduino para el host
+
+#include "Arduino.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace {
+
+const unsigned long DEFAULT_RUN_MS = 60000; // Tiempo virtual por defecto de una ejecución
+
+unsigned long long nowMicros = 0;
+unsigned long long runLimitMicros = DEFAULT_RUN_MS * 1000ULL;
+
+int analogValues[NUM_DIGITAL_PINS] = {0};
+uint8_t pinModes[NUM_DIGITAL_PINS] = {0};
+uint8_t pinLevels[NUM_DIGITAL_PINS] = {0};
+int (*analogProvider)(uint8_t) = nullptr;
+uint8_t analogReferenceMode = DEFAULT;
+void (*digitalWriteHook)(uint8_t, uint8_t) = nullptr;
+unsigned long long nextTickMicros = HOST_TICK_US;
+
+std::vector<void (*)()>& exitHooks()
+{
+  static std::vector<void (*)()> hooks;
+  return hooks;
+}
+
+std::vector<void (*)(uint8_t)>& cropHooks()
+{
+  static std::vector<void (*)(uint8_t)> hooks;
+  return hooks;
+}
+
+std::vector<void (*)()>& tickHooks()
+{
+  static std::vector<void (*)()> hooks;
+  return hooks;
+}
+
+void advance(unsigned long long us)
+{
+  unsigned long long target = nowMicros + us;
+
+  // Las interrupciones del temporizador ven el reloj en el instante en que ocurren
+  while (!tickHooks().empty() && nextTickMicros <= target)
+  {
+    nowMicros = nextTickMicros;
+    nextTickMicros += HOST_TICK_US;
+    for (void (*hook)() : tickHooks())
+      hook();
+  }
+
+  nowMicros = target;
+  if (nowMicros >= runLimitMicros)
+    hostFinish();
+}
+
+} // namespace
+
+std::string String::formatFloat(double number, unsigned char decimals)
+{
+  char buffer[48];
+  snprintf(buffer, sizeof(buffer), "%.*f", decimals, number);
+  return buffer;
+}
+
+// ======== API DE ARDUINO ========
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if (pin < NUM_DIGITAL_PINS)
+    pinModes[pin] = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if (digitalWriteHook != nullptr)
+    digitalWriteHook(pin, value);
+  if (pin < NUM_DIGITAL_PINS)
+    pinLevels[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin)
+{
+  return pin < NUM_DIGITAL_PINS ? pinLevels[pin] : LOW;
+}
+
+int analogRead(uint8_t pin)
+{
+  if (pin >= NUM_DIGITAL_PINS)
+    return 0;
+
+  if (analogProvider != nullptr)
+  {
+    int value = analogProvider(pin);
+    if (value >= 0)
+      return value;
+  }
+  return analogValues[pin];
+}
+
+void analogReference(uint8_t mode)
+{
+  analogReferenceMode = mode;
+}
+
+unsigned long millis()
+{
+  return (unsigned long)(nowMicros / 1000);
+}
+
+unsigned long micros()
+{
+  return (unsigned long)nowMicros;
+}
+
+void delay(unsigned long ms)
+{
+  advance(ms * 1000ULL);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  advance(us);
+}
+
+// ======== CONTROL DEL HOST ========
+void hostAdvanceMicros(unsigned long us)
+{
+  advance(us);
+}
+
+void hostSetAnalog(uint8_t pin, int value)
+{
+  if (pin < NUM_DIGITAL_PINS)
+    analogValues[pin] = value;
+}
+
+void hostSetAnalogProvider(int (*provider)(uint8_t pin))
+{
+  analogProvider = provider;
+}
+
+uint8_t hostAnalogReference()
+{
+  return analogReferenceMode;
+}
+
+int hostDigitalOutput(uint8_t pin)
+{
+  return (pin < NUM_DIGITAL_PINS && pinModes[pin] == OUTPUT) ? pinLevels[pin] : LOW;
+}
+
+void hostOnDigitalWrite(void (*hook)(uint8_t pin, uint8_t value))
+{
+  digitalWriteHook = hook;
+}
+
+void hostOnTick(void (*hook)())
+{
+  if (tickHooks().empty())
+    nextTickMicros = (nowMicros / HOST_TICK_US + 1) * HOST_TICK_US;
+  tickHooks().push_back(hook);
+}
+
+void hostCropSelected(uint8_t crop)
+{
+  for (void (*hook)(uint8_t) : cropHooks())
+    hook(crop);
+}
+
+void hostOnCropSelected(void (*hook)(uint8_t crop))
+{
+  cropHooks().push_back(hook);
+}
+
+void hostAtExit(void (*hook)())
+{
+  exitHooks().push_back(hook);
+}
+
+void hostFinish()
+{
+  static bool finishing = false;
+  if (finishing)
+    return;
+  finishing = true;
+
+  for (void (*hook)() : exitHooks())
+    hook();
+  fflush(stdout);
+  exit(0);
+}
+
+// En las pruebas (pio test define UNIT_TEST) main() es el de Unity, y la prueba llama a
+// setup() y loop() si necesita el firmware
+#ifndef UNIT_TEST
+int main()
+{
+  const char* runMs = getenv("HOST_RUN_MS");
+  if (runMs != nullptr)
+    runLimitMicros = strtoull(runMs, nullptr, 10) * 1000ULL;
+
+  setup();
+  for (;;)
+    loop();
+}
+#endif
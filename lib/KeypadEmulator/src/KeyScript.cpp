@@ -0,0 +1,222 @@
+// Implementación del guion de pulsaciones
+
+#include "KeyScript.h"
+
+#include <Arduino.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+
+bool KeyEvent::closedAt(unsigned long ms) const
+{
+  if (ms < pressMs)
+    return false;
+
+  unsigned long bounceSpan = bounces * bouncePeriodMs;
+  unsigned long releaseMs = pressMs + holdMs;
+
+  // Al cerrar el contacto alterna cerrado/abierto durante los rebotes
+  if (ms < pressMs + bounceSpan)
+    return ((ms - pressMs) / bouncePeriodMs) % 2 == 0;
+  if (ms < releaseMs)
+    return true;
+
+  // Al abrirse alterna abierto/cerrado hasta quedar abierto
+  if (ms < releaseMs + bounceSpan)
+    return ((ms - releaseMs) / bouncePeriodMs) % 2 == 1;
+  return false;
+}
+
+KeyScript& KeyScript::instance()
+{
+  static KeyScript* script = nullptr;
+  if (script == nullptr)
+  {
+    script = new KeyScript();
+
+    const char* inlineScript = getenv("HOST_KEYS");
+    if (inlineScript != nullptr && !script->parse(inlineScript))
+      fprintf(stderr, "keypad: error en HOST_KEYS\n");
+
+    const char* path = getenv("HOST_KEYS_FILE");
+    if (path != nullptr)
+    {
+      std::ifstream file(path);
+      std::stringstream text;
+      text << file.rdbuf();
+      if (!file || !script->parse(text.str()))
+        fprintf(stderr, "keypad: error en %s\n", path);
+    }
+
+    if (getenv("HOST_KEYPAD_STATS") != nullptr)
+      hostAtExit([] { KeyScript::instance().report(); });
+  }
+  return *script;
+}
+
+namespace {
+
+// Número decimal sin signo que ocupa todo el texto
+bool parseMs(const char* text, unsigned long& value)
+{
+  if (*text < '0' || *text > '9')
+    return false;
+  char* end = nullptr;
+  value = strtoul(text, &end, 10);
+  return *end == '\0';
+}
+
+} // namespace
+
+bool KeyScript::parse(const std::string& text)
+{
+  // Un evento por línea y sin comentarios; '#' en el lugar de la tecla es la tecla #
+  std::string normalized = text;
+  bool inComment = false;
+  bool inField = false;
+  unsigned int field = 0; // Campo del evento en el que estamos
+  for (char& c : normalized)
+  {
+    if (c == '\n' || c == '\r' || c == ';')
+    {
+      if (c != ';' || !inComment)
+      {
+        inComment = false;
+        inField = false;
+        field = 0;
+        c = '\n';
+      }
+    }
+    else if (c == ' ' || c == '\t')
+    {
+      if (inField)
+        field++;
+      inField = false;
+    }
+    else if (!inComment && !inField)
+    {
+      inComment = c == '#' && field != 1;
+      inField = !inComment;
+    }
+
+    if (inComment)
+      c = ' ';
+  }
+
+  // Los eventos se añaden solo si todo el guion es válido
+  std::vector<KeyEvent> parsed;
+  std::stringstream lines(normalized);
+  std::string line;
+  while (std::getline(lines, line))
+  {
+    std::stringstream fields(line);
+    std::string when;
+    std::string key;
+    if (!(fields >> when))
+      continue; // Línea vacía
+    if (!(fields >> key) || key.size() != 1 || (when[0] != '@' && when[0] != '+'))
+      return false;
+
+    KeyEvent event;
+    event.key = key[0];
+    unsigned long offset;
+    if (!parseMs(when.c_str() + 1, offset))
+      return false;
+    const KeyEvent* previous = !parsed.empty() ? &parsed.back() : !script.empty() ? &script.back() : nullptr;
+    event.pressMs = when[0] == '@' ? offset : (previous ? previous->endMs() : 0) + offset;
+
+    std::string option;
+    while (fields >> option)
+    {
+      size_t equals = option.find('=');
+      unsigned long value;
+      if (equals == std::string::npos || !parseMs(option.c_str() + equals + 1, value))
+        return false;
+      std::string name = option.substr(0, equals);
+
+      if (name == "hold")
+        event.holdMs = value;
+      else if (name == "bounce" && value <= UINT8_MAX)
+        event.bounces = (uint8_t)value;
+      else if (name == "period")
+        event.bouncePeriodMs = value > 0 ? value : 1;
+      else
+        return false;
+    }
+    parsed.push_back(event);
+  }
+
+  for (const KeyEvent& event : parsed)
+    add(event);
+  return true;
+}
+
+void KeyScript::add(const KeyEvent& event)
+{
+  script.push_back(event);
+}
+
+bool KeyScript::isClosed(char key, unsigned long ms) const
+{
+  for (const KeyEvent& event : script)
+  {
+    if (event.key == key && event.closedAt(ms))
+      return true;
+  }
+  return false;
+}
+
+void KeyScript::delivered(char key, unsigned long ms)
+{
+  // Se atribuye al último evento de esa tecla que ya había comenzado
+  KeyEvent* owner = nullptr;
+  for (KeyEvent& event : script)
+  {
+    if (event.key == key && event.pressMs <= ms)
+      owner = &event;
+  }
+
+  if (owner == nullptr)
+  {
+    unexpected++;
+    return;
+  }
+
+  if (owner->deliveries == 0)
+    owner->firstDeliveryMs = (long)ms;
+  owner->deliveries++;
+}
+
+void KeyScript::report() const
+{
+  unsigned long missed = 0;
+  unsigned long duplicated = 0;
+  unsigned long worstMs = 0;
+  unsigned long totalMs = 0;
+  unsigned long deliveredCount = 0;
+
+  for (const KeyEvent& event : script)
+  {
+    if (event.deliveries == 0)
+    {
+      missed++;
+      fprintf(stderr, "keypad: '%c' @%lu ms hold=%lu bounce=%u perdida\n", event.key, event.pressMs, event.holdMs, event.bounces);
+      continue;
+    }
+
+    unsigned long latency = (unsigned long)event.firstDeliveryMs - event.pressMs;
+    fprintf(stderr, "keypad: '%c' @%lu ms hold=%lu bounce=%u latencia %lu ms, %u entregas\n", event.key, event.pressMs, event.holdMs,
+            event.bounces, latency, event.deliveries);
+    deliveredCount++;
+    totalMs += latency;
+    if (latency > worstMs)
+      worstMs = latency;
+    if (event.deliveries > 1)
+      duplicated++;
+  }
+
+  fprintf(stderr, "keypad: %lu eventos, %lu perdidos, %lu duplicados, %lu inesperados, latencia media %lu ms, máxima %lu ms\n",
+          (unsigned long)script.size(), missed, duplicated, unexpected, deliveredCount ? totalMs / deliveredCount : 0, worstMs);
+}
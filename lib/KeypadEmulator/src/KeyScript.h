@@ -0,0 +1,62 @@
+// Guion de pulsaciones para el teclado emulado
+// Cada evento describe una tecla física: cuándo se pulsa, cuánto tiempo se mantiene
+// y cuántos rebotes produce el contacto al cerrarse y al abrirse.
+//
+// Formato del guion (eventos separados por ';' o saltos de línea, '#' inicia un comentario
+// salvo en el lugar de la tecla):
+//   @<ms> <tecla> [hold=<ms>] [bounce=<n>] [period=<ms>]   tiempo absoluto de pulsación
+//   +<ms> <tecla> [...]                                    tiempo desde que se soltó la tecla anterior
+// Ejemplo: "@11000 2 hold=200 bounce=4 period=1; +3000 1"
+//
+// Variables de entorno reconocidas:
+// - HOST_KEYS: guion en línea
+// - HOST_KEYS_FILE: archivo con el guion
+// - HOST_KEYPAD_STATS: si está definida, imprime en stderr la latencia de cada pulsación
+
+#ifndef KEY_SCRIPT_H
+#define KEY_SCRIPT_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct KeyEvent {
+  char key;
+  unsigned long pressMs;   // Instante en que se cierra el contacto por primera vez
+  unsigned long holdMs = 100; // Tiempo desde la pulsación hasta que se suelta
+  uint8_t bounces = 0;     // Cambios de estado extra al cerrar y al abrir el contacto
+  unsigned long bouncePeriodMs = 1; // Duración de cada rebote
+
+  // Estado del contacto en un instante, incluyendo los rebotes
+  bool closedAt(unsigned long ms) const;
+  unsigned long endMs() const { return pressMs + holdMs + bounces * bouncePeriodMs; }
+
+  // Resultado observado por el firmware
+  long firstDeliveryMs = -1; // Primera vez que getKey() devolvió la tecla
+  unsigned int deliveries = 0; // Veces que getKey() la devolvió (más de 1 = rebote no filtrado)
+};
+
+class KeyScript {
+public:
+  // Guion global, cargado de las variables de entorno la primera vez que se usa
+  static KeyScript& instance();
+
+  // Añade los eventos de un guion en texto; devuelve false, sin añadir ninguno, si tiene errores
+  bool parse(const std::string& text);
+  void add(const KeyEvent& event);
+
+  // Estado del contacto de una tecla en un instante
+  bool isClosed(char key, unsigned long ms) const;
+
+  // Registra que el firmware recibió una tecla
+  void delivered(char key, unsigned long ms);
+
+  const std::vector<KeyEvent>& events() const { return script; }
+  void report() const;
+
+private:
+  std::vector<KeyEvent> script;
+  unsigned long unexpected = 0; // Teclas recibidas fuera de cualquier evento
+};
+
+#endif
@@ -0,0 +1,164 @@
+// Implementación del teclado emulado, con la misma máquina de estados que la librería Keypad
+
+#include "Keypad.h"
+
+#include <stdio.h>
+
+Keypad::Keypad(char* userKeymap, byte*, byte*, byte numRows, byte numCols)
+    : keymap(userKeymap), rows(numRows), cols(numCols)
+{
+  // Carga el guion antes de empezar a escanear y avisa de teclas que no existen
+  for (const KeyEvent& event : KeyScript::instance().events())
+  {
+    if (!isMapped(event.key))
+      fprintf(stderr, "keypad: la tecla '%c' del guion no está en el teclado\n", event.key);
+  }
+}
+
+bool Keypad::isMapped(char keyChar) const
+{
+  for (byte i = 0; i < rows * cols; i++)
+  {
+    if (keymap[i] == keyChar)
+      return true;
+  }
+  return false;
+}
+
+void Keypad::nextState(TrackedKey& key, bool closed)
+{
+  key.stateChanged = false;
+
+  switch (key.kstate)
+  {
+    case IDLE:
+      if (closed)
+      {
+        key.kstate = PRESSED;
+        key.stateChanged = true;
+        key.holdTimer = millis();
+      }
+      break;
+
+    case PRESSED:
+      if ((millis() - key.holdTimer) > holdTime)
+      {
+        key.kstate = HOLD;
+        key.stateChanged = true;
+      }
+      else if (!closed)
+      {
+        key.kstate = RELEASED;
+        key.stateChanged = true;
+      }
+      break;
+
+    case HOLD:
+      if (!closed)
+      {
+        key.kstate = RELEASED;
+        key.stateChanged = true;
+      }
+      break;
+
+    case RELEASED:
+      key.kstate = IDLE;
+      key.stateChanged = true;
+      break;
+  }
+}
+
+bool Keypad::scan()
+{
+  if ((millis() - startTime) <= debounceTime)
+    return false;
+  startTime = millis();
+
+  KeyScript& script = KeyScript::instance();
+  unsigned long now = millis();
+
+  for (TrackedKey& key : keys)
+  {
+    if (key.kstate == IDLE)
+    {
+      key.kchar = NO_KEY;
+      key.stateChanged = false;
+    }
+  }
+
+  for (byte i = 0; i < rows * cols; i++)
+  {
+    char keyChar = keymap[i];
+    bool closed = script.isClosed(keyChar, now);
+
+    TrackedKey* tracked = nullptr;
+    for (TrackedKey& key : keys)
+    {
+      if (key.kchar == keyChar)
+        tracked = &key;
+    }
+
+    if (tracked != nullptr)
+    {
+      nextState(*tracked, closed);
+    }
+    else if (closed)
+    {
+      for (TrackedKey& key : keys)
+      {
+        if (key.kchar == NO_KEY)
+        {
+          key.kchar = keyChar;
+          key.kstate = IDLE;
+          nextState(key, closed);
+          break;
+        }
+      }
+    }
+  }
+
+  for (const TrackedKey& key : keys)
+  {
+    if (key.stateChanged)
+      return true;
+  }
+  return false;
+}
+
+char Keypad::getKey()
+{
+  if (scan() && keys[0].stateChanged && keys[0].kstate == PRESSED)
+  {
+    KeyScript::instance().delivered(keys[0].kchar, millis());
+    return keys[0].kchar;
+  }
+  return NO_KEY;
+}
+
+char Keypad::waitForKey()
+{
+  char key = NO_KEY;
+  while ((key = getKey()) == NO_KEY)
+    delay(1);
+  return key;
+}
+
+KeyState Keypad::getState()
+{
+  return keys[0].kstate;
+}
+
+bool Keypad::isPressed(char keyChar)
+{
+  for (const TrackedKey& key : keys)
+  {
+    if (key.kchar == keyChar && key.kstate == PRESSED && key.stateChanged)
+      return true;
+  }
+  return false;
+}
+
+bool Keypad::keyStateChanged()
+{
+  return keys[0].stateChanged;
+}
@@ -0,0 +1,56 @@
+// Sustituto de la librería Keypad para el entorno native
+// Lee el estado de cada tecla del guion de pulsaciones (KeyScript) y reproduce el
+// comportamiento de la librería real: escaneo cada debounceTime ms, estados
+// PRESSED/HOLD/RELEASED y getKey() devolviendo la tecla solo al pulsarse.
+// Con rebotes más largos que el tiempo de debounce aparecen las mismas
+// pulsaciones repetidas que tendría el hardware.
+
+#ifndef HOST_KEYPAD_H
+#define HOST_KEYPAD_H
+
+#include <Arduino.h>
+
+#include "KeyScript.h"
+
+#define NO_KEY '\0'
+#define makeKeymap(x) ((char*)x)
+
+typedef enum { IDLE, PRESSED, HOLD, RELEASED } KeyState;
+
+class Keypad {
+public:
+  static constexpr byte LIST_MAX = 10; // Teclas simultáneas que sigue la librería
+
+  Keypad(char* userKeymap, byte* row, byte* col, byte numRows, byte numCols);
+
+  char getKey();
+  char waitForKey();
+  KeyState getState();
+  bool isPressed(char keyChar);
+  bool keyStateChanged();
+
+  void setDebounceTime(unsigned int debounce) { debounceTime = debounce < 1 ? 1 : debounce; }
+  void setHoldTime(unsigned int hold) { holdTime = hold; }
+
+private:
+  struct TrackedKey {
+    char kchar = NO_KEY;
+    KeyState kstate = IDLE;
+    bool stateChanged = false;
+    unsigned long holdTimer = 0;
+  };
+
+  bool scan();
+  bool isMapped(char keyChar) const;
+  void nextState(TrackedKey& key, bool closed);
+
+  char* keymap;
+  byte rows;
+  byte cols;
+  unsigned int debounceTime = 10;
+  unsigned int holdTime = 500;
+  unsigned long startTime = 0;
+  TrackedKey keys[LIST_MAX];
+};
+
+#endif
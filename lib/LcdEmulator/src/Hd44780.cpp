@@ -0,0 +1,232 @@
+// Implementación del emulador del HD44780
+
+#include "Hd44780.h"
+
+#include <string.h>
+
+Hd44780::Hd44780(uint8_t cols, uint8_t rows) : cols(cols), rows(rows > 2 ? 2 : rows)
+{
+  memset(ddram, ' ', sizeof(ddram));
+  memset(cgram, 0, sizeof(cgram));
+}
+
+void Hd44780::command(uint8_t value, unsigned long long nowMicros)
+{
+  stats.commands++;
+  write(false, value, nowMicros);
+}
+
+void Hd44780::data(uint8_t value, unsigned long long nowMicros)
+{
+  stats.dataWrites++;
+  write(true, value, nowMicros);
+}
+
+void Hd44780::initNibble(uint8_t value, unsigned long long nowMicros)
+{
+  stats.commands++;
+  stats.nibbles++;
+  if (nowMicros < busyUntil)
+    stats.busyViolations++;
+  busyUntil = nowMicros + EXEC_US;
+  lastWrite = nowMicros;
+  (void)value; // Solo selecciona el ancho del bus, que no afecta a la emulación
+}
+
+void Hd44780::write(bool isData, uint8_t value, unsigned long long nowMicros)
+{
+  stats.nibbles += 2;
+
+  // El controlador ignora lo que llega mientras ejecuta la instrucción anterior
+  if (nowMicros < busyUntil)
+    stats.busyViolations++;
+
+  recordIfStable(nowMicros);
+
+  if (isData)
+    store(value);
+  else
+    execute(value);
+
+  bool slow = !isData && (value == 0x01 || (value & 0xFE) == 0x02);
+  busyUntil = nowMicros + (slow ? CLEAR_EXEC_US : EXEC_US);
+  lastWrite = nowMicros;
+  dirty = true;
+}
+
+void Hd44780::execute(uint8_t value)
+{
+  if (value & 0x80) // Set DDRAM address
+  {
+    address = value & 0x7F;
+    addressInCgram = false;
+  }
+  else if (value & 0x40) // Set CGRAM address
+  {
+    address = value & 0x3F;
+    addressInCgram = true;
+  }
+  else if (value & 0x20) // Function set: se asume siempre 2 líneas
+  {
+  }
+  else if (value & 0x10) // Cursor / display shift
+  {
+    bool displayShift = value & 0x08;
+    bool right = value & 0x04;
+    if (displayShift)
+      shift = right ? (shift + DDRAM_LINE - 1) % DDRAM_LINE : (shift + 1) % DDRAM_LINE;
+    else
+      address = right ? address + 1 : address - 1;
+  }
+  else if (value & 0x08) // Display on/off control
+  {
+    displayOn = value & 0x04;
+    cursorOn = value & 0x02;
+    blinkOn = value & 0x01;
+  }
+  else if (value & 0x04) // Entry mode set
+  {
+    increment = value & 0x02;
+    shiftOnWrite = value & 0x01;
+  }
+  else if (value & 0x02) // Return home
+  {
+    address = 0;
+    addressInCgram = false;
+    shift = 0;
+  }
+  else if (value & 0x01) // Clear display
+  {
+    stats.clears++;
+    memset(ddram, ' ', sizeof(ddram));
+    address = 0;
+    addressInCgram = false;
+    increment = true;
+    shift = 0;
+  }
+}
+
+void Hd44780::store(uint8_t value)
+{
+  if (addressInCgram)
+  {
+    cgram[address & 0x3F] = value & 0x1F;
+    address = (increment ? address + 1 : address - 1) & 0x3F;
+    return;
+  }
+
+  uint8_t line = (address & 0x40) ? 1 : 0;
+  uint8_t offset = (address & 0x3F) % DDRAM_LINE;
+  ddram[line * DDRAM_LINE + offset] = value;
+
+  // El contador pasa del final de una línea al inicio de la otra
+  if (increment)
+    offset++;
+  else
+    offset = offset == 0 ? DDRAM_LINE : offset - 1;
+
+  if (offset >= DDRAM_LINE)
+  {
+    line ^= 1;
+    offset = increment ? 0 : DDRAM_LINE - 1;
+  }
+  address = (line ? 0x40 : 0x00) | offset;
+
+  if (shiftOnWrite)
+    shift = increment ? (shift + 1) % DDRAM_LINE : (shift + DDRAM_LINE - 1) % DDRAM_LINE;
+}
+
+uint8_t Hd44780::visibleAddress(uint8_t row, uint8_t col) const
+{
+  return row * DDRAM_LINE + (col + shift) % DDRAM_LINE;
+}
+
+char Hd44780::cell(uint8_t row, uint8_t col) const
+{
+  uint8_t value = ddram[visibleAddress(row, col)];
+  if (value < 0x10)
+    return '#'; // Carácter personalizado de la CGRAM
+  if (value < 0x20 || value > 0x7E)
+    return '?'; // Carácter de la ROM sin equivalente ASCII
+  return (char)value;
+}
+
+Hd44780::Frame Hd44780::snapshot(unsigned long long nowMicros) const
+{
+  Frame frame;
+  frame.atMicros = nowMicros;
+  for (uint8_t row = 0; row < rows; row++)
+  {
+    std::string line;
+    for (uint8_t col = 0; col < cols; col++)
+      line += displayOn ? cell(row, col) : ' ';
+    frame.lines.push_back(line);
+  }
+
+  uint8_t line = (address & 0x40) ? 1 : 0;
+  uint8_t offset = (address & 0x3F) % DDRAM_LINE;
+  frame.cursorRow = line;
+  frame.cursorCol = (offset + DDRAM_LINE - shift) % DDRAM_LINE;
+  frame.cursorVisible = displayOn && (cursorOn || blinkOn) && !addressInCgram && frame.cursorCol < cols;
+  frame.displayOn = displayOn;
+  return frame;
+}
+
+bool Hd44780::sameContent(const Frame& a, const Frame& b)
+{
+  return a.lines == b.lines && a.displayOn == b.displayOn && a.cursorVisible == b.cursorVisible &&
+         (!a.cursorVisible || (a.cursorRow == b.cursorRow && a.cursorCol == b.cursorCol));
+}
+
+void Hd44780::recordIfStable(unsigned long long nowMicros)
+{
+  if (dirty && nowMicros - lastWrite >= STABLE_FRAME_US)
+    flush(lastWrite);
+}
+
+void Hd44780::flush(unsigned long long nowMicros)
+{
+  if (!dirty)
+    return;
+  dirty = false;
+
+  Frame frame = snapshot(nowMicros);
+  if (recorded.empty() || !sameContent(recorded.back(), frame))
+    recorded.push_back(frame);
+}
+
+std::string Hd44780::renderFrame(const Frame& frame, bool border)
+{
+  std::string edge = "+" + std::string(frame.lines.empty() ? 0 : frame.lines[0].size(), '-') + "+\n";
+  std::string out = border ? edge : "";
+
+  for (size_t row = 0; row < frame.lines.size(); row++)
+  {
+    std::string line = frame.lines[row];
+    if (frame.cursorVisible && frame.cursorRow == row && frame.cursorCol < line.size() && line[frame.cursorCol] == ' ')
+      line[frame.cursorCol] = '_';
+    out += border ? "|" + line + "|\n" : line + "\n";
+  }
+
+  if (border)
+    out += edge;
+  return out;
+}
+
+std::string Hd44780::render(bool border) const
+{
+  return renderFrame(snapshot(lastWrite), border);
+}
+
+std::string Hd44780::renderGlyph(uint8_t index) const
+{
+  std::string out;
+  for (uint8_t row = 0; row < 8; row++)
+  {
+    uint8_t bits = cgram[(index & 0x07) * 8 + row];
+    for (int8_t bit = 4; bit >= 0; bit--)
+      out += (bits & (1 << bit)) ? '#' : '.';
+    out += '\n';
+  }
+  return out;
+}
@@ -0,0 +1,105 @@
+// Emulador del controlador HD44780 de la pantalla LCD 16x2
+// Recibe los mismos comandos y datos que el controlador real y mantiene:
+// - DDRAM (80 posiciones, 2 líneas de 40) con desplazamiento de pantalla
+// - CGRAM (8 caracteres personalizados de 5x8)
+// - Cursor, parpadeo y encendido de la pantalla
+// - Tiempos de ejecución del datasheet (37 us por comando, 1.52 ms para clear/home),
+//   contando las operaciones que llegan mientras el controlador está ocupado
+//
+// Cada vez que el contenido visible se mantiene estable se guarda un "frame"
+// que se puede renderizar como texto ASCII para comparar snapshots.
+
+#ifndef HD44780_H
+#define HD44780_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class Hd44780 {
+public:
+  // Tiempos de ejecución del controlador según el datasheet (fosc = 270 kHz)
+  static constexpr uint32_t EXEC_US = 37;
+  static constexpr uint32_t CLEAR_EXEC_US = 1520;
+
+  // Tiempo que el contenido debe permanecer sin cambios para guardarse como frame
+  static constexpr uint32_t STABLE_FRAME_US = 20000;
+
+  // Contadores de uso del bus
+  struct BusStats {
+    unsigned long commands = 0;     // Escrituras con RS = 0
+    unsigned long dataWrites = 0;   // Escrituras con RS = 1
+    unsigned long nibbles = 0;      // Transferencias de 4 bits (2 por byte en modo 4 bits)
+    unsigned long clears = 0;       // Comandos clear display
+    unsigned long busyViolations = 0; // Escrituras recibidas con el controlador ocupado
+    unsigned long long busMicros = 0; // Tiempo total invertido por la MCU en el bus
+  };
+
+  // Contenido visible en un instante
+  struct Frame {
+    unsigned long long atMicros; // Instante en que apareció el contenido
+    std::vector<std::string> lines;
+    uint8_t cursorRow;
+    uint8_t cursorCol;
+    bool cursorVisible;
+    bool displayOn;
+  };
+
+  Hd44780(uint8_t cols = 16, uint8_t rows = 2);
+
+  void command(uint8_t value, unsigned long long nowMicros);
+  void data(uint8_t value, unsigned long long nowMicros);
+
+  // Nibble suelto de la secuencia de inicialización en modo 4 bits (function set)
+  void initNibble(uint8_t value, unsigned long long nowMicros);
+
+  // Contabiliza el tiempo que la MCU pasó en el bus (lo informa la capa LiquidCrystal)
+  void chargeBusTime(unsigned long long micros) { stats.busMicros += micros; }
+
+  // Cierra el frame pendiente aunque no haya pasado STABLE_FRAME_US
+  void flush(unsigned long long nowMicros);
+
+  Frame snapshot(unsigned long long nowMicros) const;
+  std::string render(bool border = true) const;
+  static std::string renderFrame(const Frame& frame, bool border = true);
+  std::string renderGlyph(uint8_t index) const;
+
+  const std::vector<Frame>& frames() const { return recorded; }
+  const BusStats& busStats() const { return stats; }
+  void resetStats() { stats = BusStats(); }
+
+  char cell(uint8_t row, uint8_t col) const;
+
+private:
+  static constexpr uint8_t DDRAM_LINE = 40;
+
+  void write(bool isData, uint8_t value, unsigned long long nowMicros);
+  void execute(uint8_t value);
+  void store(uint8_t value);
+  void recordIfStable(unsigned long long nowMicros);
+  uint8_t visibleAddress(uint8_t row, uint8_t col) const;
+  static bool sameContent(const Frame& a, const Frame& b);
+
+  uint8_t cols;
+  uint8_t rows;
+
+  uint8_t ddram[2 * DDRAM_LINE];
+  uint8_t cgram[64];
+  uint8_t address = 0;     // Contador de direcciones (AC)
+  bool addressInCgram = false;
+  bool increment = true;   // I/D
+  bool shiftOnWrite = false; // S
+  bool displayOn = false;
+  bool cursorOn = false;
+  bool blinkOn = false;
+  uint8_t shift = 0;       // Desplazamiento de la pantalla respecto a la DDRAM
+
+  unsigned long long busyUntil = 0;
+  unsigned long long lastWrite = 0;
+  bool dirty = false;
+
+  BusStats stats;
+  std::vector<Frame> recorded;
+};
+
+#endif
@@ -0,0 +1,182 @@
+// Implementación del sustituto de LiquidCrystal sobre el emulador Hd44780
+
+#include "LiquidCrystal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+
+std::vector<LiquidCrystal*>& instances()
+{
+  static std::vector<LiquidCrystal*> all;
+  return all;
+}
+
+} // namespace
+
+LiquidCrystal::LiquidCrystal(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t) : pinCount(6)
+{
+  if (instances().empty())
+    hostAtExit(dumpAll);
+  instances().push_back(this);
+}
+
+LiquidCrystal::LiquidCrystal(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t) : pinCount(7)
+{
+  if (instances().empty())
+    hostAtExit(dumpAll);
+  instances().push_back(this);
+}
+
+void LiquidCrystal::begin(uint8_t cols, uint8_t rows, uint8_t)
+{
+  lcd = Hd44780(cols, rows);
+  numLines = rows;
+  rowOffsets[2] = cols;
+  rowOffsets[3] = 0x40 + cols;
+
+  // Misma secuencia y esperas que la librería real en modo 4 bits
+  delayMicroseconds(50000);
+  const unsigned int initWaits[] = {4500, 4500, 150};
+  for (unsigned int wait : initWaits)
+  {
+    lcd.initNibble(0x03, micros());
+    lcd.chargeBusTime(4 * DIGITAL_WRITE_US + PULSE_ENABLE_US + wait);
+    delayMicroseconds(4 * DIGITAL_WRITE_US + PULSE_ENABLE_US + wait);
+  }
+  lcd.initNibble(0x02, micros());
+  lcd.chargeBusTime(4 * DIGITAL_WRITE_US + PULSE_ENABLE_US);
+  delayMicroseconds(4 * DIGITAL_WRITE_US + PULSE_ENABLE_US);
+
+  command(0x20 | (rows > 1 ? 0x08 : 0x00));
+  displayControl = 0x04;
+  display();
+  clear();
+  displayMode = 0x02;
+  command(0x04 | displayMode);
+}
+
+void LiquidCrystal::send(uint8_t value, bool isData)
+{
+  if (isData)
+    lcd.data(value, micros());
+  else
+    lcd.command(value, micros());
+
+  // RS (y RW) más dos nibbles de 4 pines de datos y un pulso de enable cada uno
+  unsigned int cost = (pinCount - 5) * DIGITAL_WRITE_US + 2 * (7 * DIGITAL_WRITE_US + PULSE_ENABLE_US);
+  lcd.chargeBusTime(cost);
+  delayMicroseconds(cost);
+}
+
+void LiquidCrystal::command(uint8_t value)
+{
+  send(value, false);
+}
+
+size_t LiquidCrystal::write(uint8_t value)
+{
+  send(value, true);
+  return 1;
+}
+
+void LiquidCrystal::clear()
+{
+  command(0x01);
+  lcd.chargeBusTime(CLEAR_DELAY_US);
+  delayMicroseconds(CLEAR_DELAY_US);
+}
+
+void LiquidCrystal::home()
+{
+  command(0x02);
+  lcd.chargeBusTime(CLEAR_DELAY_US);
+  delayMicroseconds(CLEAR_DELAY_US);
+}
+
+void LiquidCrystal::noDisplay() { displayControl &= ~0x04; command(0x08 | displayControl); }
+void LiquidCrystal::display() { displayControl |= 0x04; command(0x08 | displayControl); }
+void LiquidCrystal::noCursor() { displayControl &= ~0x02; command(0x08 | displayControl); }
+void LiquidCrystal::cursor() { displayControl |= 0x02; command(0x08 | displayControl); }
+void LiquidCrystal::noBlink() { displayControl &= ~0x01; command(0x08 | displayControl); }
+void LiquidCrystal::blink() { displayControl |= 0x01; command(0x08 | displayControl); }
+void LiquidCrystal::scrollDisplayLeft() { command(0x10 | 0x08); }
+void LiquidCrystal::scrollDisplayRight() { command(0x10 | 0x08 | 0x04); }
+void LiquidCrystal::leftToRight() { displayMode |= 0x02; command(0x04 | displayMode); }
+void LiquidCrystal::rightToLeft() { displayMode &= ~0x02; command(0x04 | displayMode); }
+void LiquidCrystal::autoscroll() { displayMode |= 0x01; command(0x04 | displayMode); }
+void LiquidCrystal::noAutoscroll() { displayMode &= ~0x01; command(0x04 | displayMode); }
+
+void LiquidCrystal::createChar(uint8_t location, uint8_t charmap[])
+{
+  location &= 0x07;
+  command(0x40 | (location << 3));
+  for (uint8_t i = 0; i < 8; i++)
+    write(charmap[i]);
+}
+
+void LiquidCrystal::setCursor(uint8_t col, uint8_t row)
+{
+  if (row >= 4)
+    row = 3;
+  if (row >= numLines)
+    row = numLines - 1;
+  command(0x80 | (col + rowOffsets[row]));
+}
+
+void LiquidCrystal::writeAll(const char* text, size_t length)
+{
+  for (size_t i = 0; i < length; i++)
+    write((uint8_t)text[i]);
+}
+
+size_t LiquidCrystal::print(const String& text)
+{
+  writeAll(text.c_str(), text.length());
+  return text.length();
+}
+
+size_t LiquidCrystal::print(const char* text)
+{
+  size_t length = strlen(text);
+  writeAll(text, length);
+  return length;
+}
+
+size_t LiquidCrystal::print(char c) { return write((uint8_t)c); }
+size_t LiquidCrystal::print(int number) { return print(String(number)); }
+size_t LiquidCrystal::print(unsigned int number) { return print(String(number)); }
+size_t LiquidCrystal::print(long number) { return print(String(number)); }
+size_t LiquidCrystal::print(unsigned long number) { return print(String(number)); }
+size_t LiquidCrystal::print(double number, int decimals) { return print(String(number, (unsigned char)decimals)); }
+
+void LiquidCrystal::dumpAll()
+{
+  const char* snapshotPath = getenv("HOST_LCD_SNAPSHOT");
+  FILE* snapshot = snapshotPath ? fopen(snapshotPath, "w") : nullptr;
+
+  for (LiquidCrystal* instance : instances())
+  {
+    Hd44780& lcd = instance->lcd;
+    lcd.flush(micros());
+
+    if (snapshot != nullptr)
+    {
+      for (const Hd44780::Frame& frame : lcd.frames())
+        fprintf(snapshot, "@%llu ms\n%s", frame.atMicros / 1000, Hd44780::renderFrame(frame).c_str());
+    }
+
+    if (getenv("HOST_LCD_STATS") != nullptr)
+    {
+      const Hd44780::BusStats& stats = lcd.busStats();
+      fprintf(stderr, "lcd: %lu comandos, %lu datos, %lu nibbles, %lu clears, %lu violaciones de busy, %llu us en el bus\n",
+              stats.commands, stats.dataWrites, stats.nibbles, stats.clears, stats.busyViolations, stats.busMicros);
+    }
+  }
+
+  if (snapshot != nullptr)
+    fclose(snapshot);
+}
@@ -0,0 +1,75 @@
+// Sustituto de la librería LiquidCrystal para el entorno native
+// Expone la misma API que la librería de Arduino y envía cada comando al emulador
+// Hd44780, cargando en el reloj virtual el mismo tiempo que tarda la librería real
+// en modo 4 bits, de modo que el coste de la pantalla se puede medir en el host.
+//
+// Variables de entorno reconocidas:
+// - HOST_LCD_SNAPSHOT: archivo donde se escriben todos los frames al terminar
+// - HOST_LCD_STATS: si está definida, imprime los contadores del bus en stderr
+
+#ifndef HOST_LIQUID_CRYSTAL_H
+#define HOST_LIQUID_CRYSTAL_H
+
+#include <Arduino.h>
+
+#include "Hd44780.h"
+
+class LiquidCrystal {
+public:
+  // Coste aproximado de la librería real en un Uno a 16 MHz
+  static constexpr unsigned int DIGITAL_WRITE_US = 4; // Cada digitalWrite()
+  static constexpr unsigned int PULSE_ENABLE_US = 102; // delayMicroseconds(1 + 1 + 100) de pulseEnable()
+  static constexpr unsigned int CLEAR_DELAY_US = 2000; // delayMicroseconds(2000) tras clear() y home()
+
+  LiquidCrystal(uint8_t rs, uint8_t enable, uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3);
+  LiquidCrystal(uint8_t rs, uint8_t rw, uint8_t enable, uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3);
+
+  void begin(uint8_t cols, uint8_t rows, uint8_t charsize = 0);
+
+  void clear();
+  void home();
+
+  void noDisplay();
+  void display();
+  void noBlink();
+  void blink();
+  void noCursor();
+  void cursor();
+  void scrollDisplayLeft();
+  void scrollDisplayRight();
+  void leftToRight();
+  void rightToLeft();
+  void autoscroll();
+  void noAutoscroll();
+
+  void createChar(uint8_t location, uint8_t charmap[]);
+  void setCursor(uint8_t col, uint8_t row);
+  void command(uint8_t value);
+
+  size_t write(uint8_t value);
+  size_t print(const String& text);
+  size_t print(const char* text);
+  size_t print(char c);
+  size_t print(int number);
+  size_t print(unsigned int number);
+  size_t print(long number);
+  size_t print(unsigned long number);
+  size_t print(double number, int decimals = 2);
+
+  // Acceso al emulador para snapshots y medición
+  Hd44780& emulator() { return lcd; }
+
+private:
+  void send(uint8_t value, bool isData);
+  void writeAll(const char* text, size_t length);
+  static void dumpAll();
+
+  Hd44780 lcd;
+  uint8_t pinCount;       // 6 o 7 pines de control y datos (con o sin RW)
+  uint8_t displayControl = 0x04;
+  uint8_t displayMode = 0x02;
+  uint8_t numLines = 2;
+  uint8_t rowOffsets[4] = {0x00, 0x40, 0x10, 0x50};
+};
+
+#endif
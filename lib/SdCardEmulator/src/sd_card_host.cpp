@@ -0,0 +1,307 @@
+// Tarjeta SD emulada en el bus SPI del entorno native
+// Responde a los comandos que usa src/sd_log.cpp en modo SPI (CMD0, CMD8, CMD55/ACMD41,
+// CMD58, CMD16, CMD17 y CMD24) como una tarjeta SDHC, direccionada por bloques. Solo
+// atiende el bus con SD_CS_PIN en bajo. Tras escribir un bloque la tarjeta queda ocupada
+// (MISO en bajo) durante HOST_SD_BUSY_MS de tiempo virtual, como al grabar la flash.
+// Al terminar se imprime en stderr cuántos bloques se leyeron y escribieron.
+//
+// Variables de entorno reconocidas:
+// - HOST_SD_IMAGE: archivo con el contenido de la tarjeta; se crea si no existe y se
+//   conserva entre ejecuciones (sin él la tarjeta está en memoria y empieza vacía)
+// - HOST_SD_BUSY_MS: tiempo de grabación de un bloque (por defecto 2 ms)
+// - HOST_SD_PARTITION_START: bloque donde empieza la partición FAT32 de una tarjeta
+//   nueva (por defecto 8192, como el SD Card Formatter en una SDHC); 0 la deja sin
+//   tabla de particiones
+// - HOST_SD_REJECT_EVERY: rechaza uno de cada n bloques escritos (error de escritura)
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#include "board_config.h"
+
+#if SD_LOG_ENABLED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace {
+
+const uint16_t BLOCK_SIZE = 512;
+const uint8_t IDLE_POLLS = 2; // ACMD41 que responden "inactiva" antes de quedar lista
+const uint32_t CARD_BLOCKS = 15523840; // Tarjeta SDHC de 8 GB
+
+enum class Phase {
+  COMMAND,    // Esperando un comando
+  WAIT_TOKEN, // CMD24 aceptado, esperando el inicio de los datos
+  DATA,       // Recibiendo el bloque y su CRC
+};
+
+struct Card {
+  FILE* image = nullptr;
+  std::map<uint32_t, std::vector<uint8_t>> blocks; // Sin imagen
+  unsigned long busyMicros = 2000;
+  unsigned long rejectEvery = 0;
+
+  Phase phase = Phase::COMMAND;
+  uint8_t command[6];
+  uint8_t commandLength = 0;
+  bool idle = true;
+  bool applicationCommand = false;
+  uint8_t idlePolls = 0;
+  std::deque<uint8_t> output; // Bytes que la tarjeta pondrá en MISO
+  uint32_t writeBlock = 0;
+  std::vector<uint8_t> writeData;
+  bool busy = false;
+  unsigned long busyStart = 0;
+
+  unsigned long blocksRead = 0;
+  unsigned long blocksWritten = 0;
+  unsigned long blocksRejected = 0;
+};
+
+Card card;
+
+void readBlock(uint32_t block, uint8_t* data)
+{
+  std::fill(data, data + BLOCK_SIZE, 0);
+  if (card.image != nullptr)
+  {
+    if (fseek(card.image, (long)block * BLOCK_SIZE, SEEK_SET) == 0)
+      fread(data, 1, BLOCK_SIZE, card.image);
+    return;
+  }
+  auto found = card.blocks.find(block);
+  if (found != card.blocks.end())
+    std::copy(found->second.begin(), found->second.end(), data);
+}
+
+void writeBlock(uint32_t block, const uint8_t* data)
+{
+  if (card.image != nullptr)
+  {
+    fseek(card.image, (long)block * BLOCK_SIZE, SEEK_SET);
+    fwrite(data, 1, BLOCK_SIZE, card.image);
+    fflush(card.image);
+    return;
+  }
+  card.blocks[block].assign(data, data + BLOCK_SIZE);
+}
+
+// MBR con una sola partición FAT32 (LBA) hasta el final de la tarjeta
+void partition(uint32_t start)
+{
+  if (start == 0 || start >= CARD_BLOCKS)
+    return;
+  uint8_t mbr[BLOCK_SIZE] = {};
+  uint8_t* entry = mbr + 446;
+  entry[1] = entry[2] = entry[3] = 0xFE; // CHS fuera de rango: solo vale la dirección LBA
+  entry[4] = 0x0C;
+  entry[5] = entry[6] = entry[7] = 0xFE;
+  uint32_t count = CARD_BLOCKS - start;
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    entry[8 + i] = start >> (8 * i);
+    entry[12 + i] = count >> (8 * i);
+  }
+  mbr[510] = 0x55;
+  mbr[511] = 0xAA;
+  writeBlock(0, mbr);
+}
+
+void respond(uint8_t r1)
+{
+  card.output.push_back(0xFF); // Al menos un byte antes de la respuesta
+  card.output.push_back(r1);
+}
+
+void execute()
+{
+  uint8_t index = card.command[0] & 0x3F;
+  uint32_t argument = ((uint32_t)card.command[1] << 24) | ((uint32_t)card.command[2] << 16) | ((uint32_t)card.command[3] << 8) | card.command[4];
+  bool application = card.applicationCommand;
+  card.applicationCommand = false;
+  uint8_t state = card.idle ? 0x01 : 0x00;
+
+  if (index == 0)
+  {
+    card.idle = true;
+    card.idlePolls = 0;
+    respond(card.command[5] == 0x95 ? 0x01 : 0x09); // 0x08: error de CRC
+  }
+  else if (index == 8)
+  {
+    respond(card.command[5] == 0x87 ? state : state | 0x08);
+    card.output.push_back(0x00);
+    card.output.push_back(0x00);
+    card.output.push_back(argument >> 8 & 0x0F); // Rango de tensión aceptado
+    card.output.push_back(argument & 0xFF);      // Patrón de comprobación
+  }
+  else if (index == 55)
+  {
+    card.applicationCommand = true;
+    respond(state);
+  }
+  else if (index == 41 && application)
+  {
+    if (card.idle && ++card.idlePolls > IDLE_POLLS)
+      card.idle = false;
+    respond(card.idle ? 0x01 : 0x00);
+  }
+  else if (index == 58)
+  {
+    respond(state);
+    card.output.push_back(card.idle ? 0x80 : 0xC0); // Encendida y de alta capacidad (CCS)
+    card.output.push_back(0xFF);
+    card.output.push_back(0x80);
+    card.output.push_back(0x00);
+  }
+  else if (index == 16)
+  {
+    respond(argument == BLOCK_SIZE ? state : state | 0x40);
+  }
+  else if ((index == 17 || index == 24) && card.idle)
+  {
+    respond(0x05); // Comando ilegal antes de iniciar
+  }
+  else if (index == 17)
+  {
+    uint8_t data[BLOCK_SIZE];
+    readBlock(argument, data);
+    card.blocksRead++;
+    respond(0x00);
+    card.output.push_back(0xFF);
+    card.output.push_back(0xFE);
+    card.output.insert(card.output.end(), data, data + BLOCK_SIZE);
+    card.output.push_back(0xFF); // CRC
+    card.output.push_back(0xFF);
+  }
+  else if (index == 24)
+  {
+    respond(0x00);
+    card.writeBlock = argument;
+    card.writeData.clear();
+    card.phase = Phase::WAIT_TOKEN;
+  }
+  else
+  {
+    respond(state | 0x04);
+  }
+}
+
+uint8_t transfer(uint8_t mosi)
+{
+  if (hostDigitalOutput(SD_CS_PIN) != LOW)
+  {
+    card.commandLength = 0;
+    return 0xFF;
+  }
+
+  // La respuesta al bloque sale antes de la señal de ocupada
+  if (card.busy && card.output.empty())
+  {
+    if (micros() - card.busyStart < card.busyMicros)
+      return 0x00;
+    card.busy = false;
+  }
+
+  uint8_t miso = 0xFF;
+  if (!card.output.empty())
+  {
+    miso = card.output.front();
+    card.output.pop_front();
+  }
+
+  switch (card.phase)
+  {
+  case Phase::COMMAND:
+    if (card.commandLength > 0 || (mosi & 0xC0) == 0x40)
+    {
+      card.command[card.commandLength++] = mosi;
+      if (card.commandLength == sizeof(card.command))
+      {
+        card.commandLength = 0;
+        card.output.clear();
+        execute();
+      }
+    }
+    break;
+
+  case Phase::WAIT_TOKEN:
+    if (mosi == 0xFE)
+      card.phase = Phase::DATA;
+    break;
+
+  case Phase::DATA:
+    card.writeData.push_back(mosi);
+    if (card.writeData.size() == BLOCK_SIZE + 2u)
+    {
+      card.phase = Phase::COMMAND;
+      if (card.rejectEvery != 0 && (card.blocksWritten + card.blocksRejected + 1) % card.rejectEvery == 0)
+      {
+        card.blocksRejected++;
+        card.output.push_back(0xED); // Error de escritura
+        break;
+      }
+      writeBlock(card.writeBlock, card.writeData.data());
+      card.blocksWritten++;
+      card.output.push_back(0xE5); // Datos aceptados
+      card.busy = true;
+      card.busyStart = micros();
+    }
+    break;
+  }
+  return miso;
+}
+
+void report()
+{
+  fprintf(stderr, "sd: %lu bloques escritos, %lu leídos", card.blocksWritten, card.blocksRead);
+  if (card.blocksRejected > 0)
+    fprintf(stderr, ", %lu rechazados", card.blocksRejected);
+  fprintf(stderr, "\n");
+  if (card.image != nullptr)
+    fclose(card.image);
+}
+
+// Se conecta al arrancar el programa, antes de setup()
+struct Installer {
+  Installer()
+  {
+    const char* busy = getenv("HOST_SD_BUSY_MS");
+    if (busy != nullptr)
+      card.busyMicros = (unsigned long)(strtof(busy, nullptr) * 1000);
+
+    const char* reject = getenv("HOST_SD_REJECT_EVERY");
+    if (reject != nullptr)
+      card.rejectEvery = strtoul(reject, nullptr, 10);
+
+    const char* start = getenv("HOST_SD_PARTITION_START");
+    uint32_t partitionStart = start != nullptr ? strtoul(start, nullptr, 10) : 8192;
+
+    // Solo una tarjeta nueva se particiona; una imagen existente se usa como está
+    bool blank = true;
+    const char* image = getenv("HOST_SD_IMAGE");
+    if (image != nullptr)
+    {
+      card.image = fopen(image, "r+b");
+      blank = card.image == nullptr;
+      if (card.image == nullptr)
+        card.image = fopen(image, "w+b");
+      if (card.image == nullptr)
+        fprintf(stderr, "sd: no se pudo abrir %s, la tarjeta queda en memoria\n", image);
+    }
+    if (blank)
+      partition(partitionStart);
+
+    hostSpiAttach(transfer);
+    hostAtExit(report);
+  }
+} installer;
+
+} // namespace
+
+#endif
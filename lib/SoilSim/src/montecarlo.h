@@ -0,0 +1,238 @@
+// Realizaciones y simulación del análisis de Monte Carlo (src/bench/montecarlo.cpp)
+// Cada realización sortea un clima (temperatura media y amplitud, variación entre días,
+// lluvias), un suelo (los parámetros de SoilParams alrededor de los de referencia), la
+// sonda (ruido y desvío de calibración) y la humedad inicial. Cada candidato (un cultivo
+// de la configuración con la regla de riego y, si hay tarifas, el mismo cultivo con el
+// planificador por tarifa) se simula sobre todas las realizaciones con la regla, el
+// planificador y el pronóstico del firmware.
+//
+// Cada realización tiene su propio generador, derivado de la semilla y su número con
+// splitmix64: los hilos toman realizaciones de a una, y el resultado no depende de
+// cuántos hilos haya ni del orden en que terminen. Todos los candidatos ven las mismas
+// realizaciones (mismo clima, suelo y ruido), así las diferencias entre ellos no son
+// suerte del sorteo. Lo comprueba test/test_montecarlo.
+
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include <math.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "board_config.h"
+#include "controller.h"
+#include "moisture_forecaster.h"
+#include "pump_scheduler.h"
+#include "soil_model.h"
+
+const float STEP_SECONDS = 10.0f;           // Paso de la simulación y del control
+const float SOIL_SPREAD = 0.2f;             // Desvío relativo de cada parámetro del suelo
+const float RAIN_PROBABILITY = 0.2f;        // Probabilidad de lluvia de cada día
+const float TEMPERATURE_NOISE = 0.2f;       // Ruido del TMP36 (°C)
+const unsigned MAX_DAYS = 366;
+
+// Generador splitmix64: rápido, con buena calidad para simulación y el mismo en todas las plataformas
+struct Random {
+  uint64_t state;
+
+  explicit Random(uint64_t seed) : state(seed) {}
+
+  uint64_t next()
+  {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  // Uniforme en [low, high)
+  float uniform(float low, float high) { return low + (high - low) * (float)((next() >> 40) * (1.0 / (1ULL << 24))); }
+
+  // Normal por Box-Muller (se descarta el segundo valor para no guardar estado)
+  float normal(float mean, float deviation)
+  {
+    float u = uniform(1e-7f, 1.0f);
+    float v = uniform(0.0f, 1.0f);
+    return mean + deviation * sqrtf(-2.0f * logf(u)) * cosf(6.2831853f * v);
+  }
+};
+
+struct Day {
+  float temperatureOffset; // Diferencia de la media del día con la media de la realización
+  float rainStartHour;
+  float rainHours;         // 0 si no llueve
+  float rainMmPerHour;
+};
+
+struct Scenario {
+  SoilParams soil;
+  float temperatureMean;
+  float temperatureSwing;
+  float startHour;
+  float humidity;
+  float probeNoise;        // Desvío estándar del ruido de la sonda (%)
+  float probeBias;         // Error de calibración de la sonda (%)
+  uint64_t noiseSeed;      // Ruido de las lecturas, igual para todos los candidatos
+  std::vector<Day> days;
+};
+
+struct Candidate {
+  uint8_t crop;            // Índice en CROP_PROFILES
+  bool tariff;             // Con el planificador por tarifa
+};
+
+struct Outcome {
+  float pumpMinutesPerDay;
+  float belowPercent;      // Tiempo con la humedad real debajo del mínimo del cultivo
+  float abovePercent;
+  float costPerDay;        // Energía con una bomba de 1 kW
+};
+
+// Cada cultivo de la configuración con la regla de riego y, si hay tarifas, con el planificador
+inline std::vector<Candidate> allCandidates()
+{
+  std::vector<Candidate> candidates;
+  for (uint8_t crop = 0; crop < CROP_COUNT; crop++)
+  {
+    candidates.push_back({crop, false});
+    if (TARIFF_WINDOW_COUNT > 0)
+      candidates.push_back({crop, true});
+  }
+  return candidates;
+}
+
+inline Scenario drawScenario(uint64_t seed, unsigned days, const SoilParams& reference)
+{
+  Random random(seed);
+  Scenario scenario;
+  scenario.soil = reference;
+  scenario.soil.fieldCapacity *= expf(random.normal(0, SOIL_SPREAD));
+  scenario.soil.drainageRate *= expf(random.normal(0, SOIL_SPREAD));
+  scenario.soil.evaporationCoeff *= expf(random.normal(0, SOIL_SPREAD));
+  scenario.soil.pumpGain *= expf(random.normal(0, SOIL_SPREAD));
+  scenario.soil.probeLagSeconds *= expf(random.normal(0, SOIL_SPREAD));
+  scenario.temperatureMean = random.uniform(12, 26);
+  scenario.temperatureSwing = random.uniform(2, 8);
+  scenario.startHour = random.uniform(0, 24);
+  scenario.humidity = random.uniform(30, 70);
+  scenario.probeNoise = random.uniform(0.1f, 1.0f);
+  scenario.probeBias = random.normal(0, 2);
+  scenario.noiseSeed = random.next();
+  for (unsigned i = 0; i < days; i++)
+  {
+    Day day;
+    day.temperatureOffset = random.normal(0, 2);
+    day.rainStartHour = random.uniform(0, 24);
+    day.rainHours = random.uniform(0, 1) < RAIN_PROBABILITY ? random.uniform(1, 4) : 0;
+    day.rainMmPerHour = random.uniform(1, 5);
+    scenario.days.push_back(day);
+  }
+  return scenario;
+}
+
+// Lectura del ADC como la convierte SensorData::update()
+inline float quantize(float value, float reference)
+{
+  float raw = floorf(value * ADC_MAX_VALUE / (reference * 100.0f) + 0.5f);
+  if (raw < 0)
+    raw = 0;
+  if (raw > ADC_MAX_VALUE)
+    raw = ADC_MAX_VALUE;
+  return raw * reference / ADC_MAX_VALUE * 100.0f;
+}
+
+inline Outcome simulate(const Scenario& scenario, const Candidate& candidate)
+{
+  const CropProfile& crop = CROP_PROFILES[candidate.crop];
+  Random noise(scenario.noiseSeed);
+  SoilState state;
+  state.moisture = state.probe = scenario.humidity;
+
+  MoistureForecaster forecaster;
+#if TARIFF_WINDOW_COUNT > 0
+  PumpScheduler scheduler(TARIFF_WINDOWS, TARIFF_WINDOW_COUNT, forecaster);
+#endif
+
+  unsigned long steps = (unsigned long)(scenario.days.size() * 86400.0f / STEP_SECONDS);
+  unsigned long pumpSteps = 0;
+  unsigned long belowSteps = 0;
+  unsigned long aboveSteps = 0;
+  double cost = 0;
+  bool pumpOn = false;
+  for (unsigned long step = 0; step < steps; step++)
+  {
+    float elapsedHours = step * STEP_SECONDS / 3600.0f;
+    float hours = scenario.startHour + elapsedHours;
+    const Day& day = scenario.days[(unsigned)(elapsedHours / 24)];
+    float hour = fmodf(hours, 24.0f);
+
+    float temperature = diurnalTemperature(scenario.temperatureMean + day.temperatureOffset, scenario.temperatureSwing, hour);
+    float rainHour = hour - day.rainStartHour;
+    float rain = rainHour >= 0 && rainHour < day.rainHours ? day.rainMmPerHour : 0;
+    soilStep(scenario.soil, state, STEP_SECONDS, temperature, pumpOn, rain);
+
+    // Lo que ve el firmware: sonda con ruido y desvío, ambas lecturas con la resolución del ADC
+    float humidity = quantize(state.probe + scenario.probeBias + noise.normal(0, scenario.probeNoise), VCC);
+    float measuredTemperature = quantize(temperature + noise.normal(0, TEMPERATURE_NOISE) - TEMP_CALIBRATION_OFFSET, TEMP_VREF) +
+                                TEMP_CALIBRATION_OFFSET;
+
+    unsigned long nowMs = (unsigned long)(step * STEP_SECONDS * 1000);
+    forecaster.observe(humidity, measuredTemperature, pumpOn, nowMs);
+    bool needed = irrigationNeeded(crop, measuredTemperature, humidity);
+#if TARIFF_WINDOW_COUNT > 0
+    uint16_t minute = (uint16_t)(hour * 60) % MINUTES_PER_DAY;
+    pumpOn = candidate.tariff ? scheduler.shouldRun(needed, humidity, measuredTemperature, crop.minHumidity, minute) : needed;
+    if (pumpOn)
+      cost += tariffAt(TARIFF_WINDOWS, TARIFF_WINDOW_COUNT, minute)->price * STEP_SECONDS / 3600.0;
+#else
+    pumpOn = needed;
+#endif
+
+    pumpSteps += pumpOn;
+    belowSteps += state.moisture < crop.minHumidity;
+    aboveSteps += state.moisture > crop.maxHumidity;
+  }
+
+  Outcome outcome;
+  float days = scenario.days.size();
+  outcome.pumpMinutesPerDay = pumpSteps * STEP_SECONDS / 60 / days;
+  outcome.belowPercent = 100.0f * belowSteps / steps;
+  outcome.abovePercent = 100.0f * aboveSteps / steps;
+  outcome.costPerDay = cost / days;
+  return outcome;
+}
+
+inline uint64_t streamSeed(uint64_t seed, unsigned index)
+{
+  Random mixer(seed ^ (0x632BE59BD9B4E019ULL * (index + 1)));
+  return mixer.next();
+}
+
+// Resultado de cada candidato en cada realización, en results[realización * candidatos + candidato]
+inline std::vector<Outcome> runAll(const std::vector<Candidate>& candidates, unsigned runs, unsigned days, unsigned threads,
+                            uint64_t seed, const SoilParams& reference)
+{
+  // Cada hilo escribe solo las realizaciones que toma
+  std::vector<Outcome> results(runs * candidates.size());
+  std::atomic<unsigned> nextRun(0);
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; t++)
+  {
+    workers.emplace_back([&]() {
+      for (unsigned run = nextRun++; run < runs; run = nextRun++)
+      {
+        Scenario scenario = drawScenario(streamSeed(seed, run), days, reference);
+        for (size_t c = 0; c < candidates.size(); c++)
+          results[run * candidates.size() + c] = simulate(scenario, candidates[c]);
+      }
+    });
+  }
+  for (std::thread& worker : workers)
+    worker.join();
+  return results;
+}
+
+#endif
@@ -0,0 +1,104 @@
+// Modelo de balance hídrico de una cama de cultivo
+// La humedad del suelo (%) cambia por:
+// - riego: pumpGain %/h con la bomba encendida
+// - lluvia: rainGain % por cada mm
+// - evaporación: proporcional a la temperatura y a la humedad relativa a la capacidad de campo
+// - drenaje: fracción por hora del agua por encima de la capacidad de campo
+// La sonda YL-69 no ve el cambio al instante: su lectura sigue a la humedad real
+// con un retardo de primer orden (probeLagSeconds).
+// Los parámetros de una cama se pueden leer de un archivo .soil (tools/soil_fit.py).
+
+#ifndef SOIL_MODEL_H
+#define SOIL_MODEL_H
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+struct SoilParams {
+  float fieldCapacity = 60.0f;     // Humedad a capacidad de campo (%)
+  float drainageRate = 0.5f;       // Fracción del exceso sobre capacidad de campo que drena por hora
+  float evaporationCoeff = 0.25f;  // %/h por °C de temperatura, a capacidad de campo
+  float pumpGain = 30.0f;          // %/h que aporta la bomba encendida
+  float rainGain = 1.5f;           // % por mm de lluvia
+  float probeLagSeconds = 120.0f;  // Constante de tiempo de la sonda
+};
+
+struct SoilState {
+  float moisture = 45.0f; // Humedad real del suelo (%)
+  float probe = 45.0f;    // Humedad que ve la sonda (%)
+};
+
+// Avanza el modelo dtSeconds con temperatura, bomba y lluvia constantes en el intervalo
+inline void soilStep(const SoilParams& params, SoilState& state, float dtSeconds, float temperatureC, bool pumpOn, float rainMmPerHour)
+{
+  float hours = dtSeconds / 3600.0f;
+
+  float evaporation = params.evaporationCoeff * (temperatureC > 0 ? temperatureC : 0) * state.moisture / params.fieldCapacity;
+  float excess = state.moisture - params.fieldCapacity;
+  float drainage = excess > 0 ? params.drainageRate * excess : 0;
+  float inflow = (pumpOn ? params.pumpGain : 0) + params.rainGain * rainMmPerHour;
+
+  state.moisture += (inflow - evaporation - drainage) * hours;
+  if (state.moisture < 0)
+    state.moisture = 0;
+  if (state.moisture > 100)
+    state.moisture = 100;
+
+  float follow = params.probeLagSeconds > 0 ? 1.0f - expf(-dtSeconds / params.probeLagSeconds) : 1.0f;
+  state.probe += (state.moisture - state.probe) * follow;
+}
+
+// Lee los parámetros del suelo de un archivo; los que falten quedan con su valor por defecto
+inline void loadSoilParams(const char* path, SoilParams& params)
+{
+  FILE* file = fopen(path, "r");
+  if (file == nullptr)
+  {
+    fprintf(stderr, "suelo: no se pudo abrir %s\n", path);
+    return;
+  }
+  struct Field {
+    const char* name;
+    float* value;
+  };
+  const Field fields[] = {
+    {"field_capacity", &params.fieldCapacity}, {"drainage_rate", &params.drainageRate},
+    {"evaporation_coeff", &params.evaporationCoeff}, {"pump_gain", &params.pumpGain},
+    {"rain_gain", &params.rainGain}, {"probe_lag_seconds", &params.probeLagSeconds},
+  };
+  char line[128];
+  int number = 0;
+  while (fgets(line, sizeof(line), file) != nullptr)
+  {
+    number++;
+    char name[64];
+    float value;
+    if (line[0] == '#' || sscanf(line, " %63[a-z_] = %f", name, &value) != 2)
+    {
+      if (line[0] != '#' && strspn(line, " \t\r\n") != strlen(line))
+        fprintf(stderr, "suelo: %s:%d: se esperaba \"nombre = valor\"\n", path, number);
+      continue;
+    }
+    bool known = false;
+    for (const Field& field : fields)
+    {
+      if (strcmp(name, field.name) == 0)
+      {
+        *field.value = value;
+        known = true;
+      }
+    }
+    if (!known)
+      fprintf(stderr, "suelo: %s:%d: parámetro desconocido %s\n", path, number, name);
+  }
+  fclose(file);
+}
+
+// Temperatura del aire con un ciclo diario sinusoidal, máxima a las 15:00
+inline float diurnalTemperature(float meanC, float swingC, float hourOfDay)
+{
+  return meanC + swingC * sinf((hourOfDay - 9.0f) * 3.14159265f / 12.0f);
+}
+
+#endif
@@ -0,0 +1,324 @@
+// Conexión del modelo de suelo con el firmware en el entorno native
+// Las lecturas de analogRead() en los pines de los sensores salen del modelo y
+// la bomba es el nivel del pin IRRIGATION_MOTOR. Al terminar se imprime en stderr
+// el resumen del riego: tiempo con la bomba encendida, costo por ventana de tarifa
+// y tiempo fuera del rango de humedad del cultivo.
+//
+// Con la sonda de humedad alimentada desde un pin (PROBE_POWER_ENABLED), la lectura es
+// 0 con la sonda apagada y sube hacia el valor real tras encenderla; el resumen
+// incluye la fracción del tiempo que estuvo alimentada.
+//
+// Variables de entorno reconocidas:
+// - HOST_SIM_START_HOUR: hora del día al iniciar la simulación (por defecto 6)
+// - HOST_SIM_HUMIDITY: humedad inicial del suelo (por defecto 45 %)
+// - HOST_SIM_TEMP_MEAN / HOST_SIM_TEMP_SWING: temperatura media y amplitud diaria (18 y 4 °C)
+// - HOST_SIM_NOISE: desviación estándar del ruido de la sonda (por defecto 0.3 %)
+// - HOST_SIM_SEED: semilla del ruido
+// - HOST_SIM_PUMP_KW: potencia de la bomba para calcular el costo (por defecto 0.5 kW)
+// - HOST_SIM_SOIL: archivo con los parámetros del suelo de una zona, una línea
+//   "nombre = valor" por parámetro de SoilParams (field_capacity, drainage_rate,
+//   evaporation_coeff, pump_gain, rain_gain, probe_lag_seconds); lo genera tools/soil_fit.py
+// - HOST_SIM_WEATHER: archivo de clima (EPW o CSV, ver lib/WeatherFile) del que salen la
+//   temperatura y la lluvia en lugar del ciclo diario de HOST_SIM_TEMP_MEAN y HOST_SIM_TEMP_SWING;
+//   la simulación empieza el primer día del archivo a la hora HOST_SIM_START_HOUR
+// - HOST_SIM_WEATHER_DAY: días desde el comienzo del archivo hasta el día de inicio (por defecto 0)
+// - HOST_SIM_FAULT: falla que aparece a las tantas horas de simulación, como "leak@12":
+//   stuck (la sonda repite la última lectura), leak (la bomba no aporta agua),
+//   evaporation (el suelo se seca tres veces más rápido) o drift (la sonda sube 1 %/h)
+
+#include <Arduino.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+
+#include "board_config.h"
+#include "soil_model.h"
+#include "weather_file.h"
+
+namespace {
+
+const float STEP_SECONDS = 1.0f; // Paso máximo de integración
+const float PROBE_RISE_MS = 1.0f; // Constante de tiempo de la sonda al encenderla
+const float DRIFT_PER_HOUR = 1.0f; // Deriva de la sonda con la falla drift (%/h)
+
+enum class Fault { NONE, STUCK, LEAK, EVAPORATION, DRIFT };
+const char* const FAULT_NAMES[] = {"", "stuck", "leak", "evaporation", "drift"};
+
+struct Simulation {
+  SoilParams params;
+  SoilState state;
+  float startHour = 6;
+  float tempMean = 18;
+  float tempSwing = 4;
+  float noise = 0.3f;
+  float pumpKw = 0.5f;
+  uint8_t crop = 0; // Cultivo elegido en el menú del firmware; 0 hasta que se elige
+  std::mt19937 rng;
+
+  unsigned long long simulatedMicros = 0;
+  bool pumpOn = false;
+  bool probePowered = false;
+  unsigned long long probeOnMicros = 0;
+  double probePoweredSeconds = 0;
+
+  WeatherFile weather;
+  bool hasWeather = false;
+  double weatherStartHour = 0; // Instante del archivo de clima al comenzar la simulación
+  bool weatherEnded = false;
+  double rainMm = 0;
+
+  Fault fault = Fault::NONE;
+  double faultHours = 0;
+  bool faultActive = false;
+  int stuckRaw = -1;
+
+  // Resumen
+  double pumpSeconds = 0;
+  double belowSeconds = 0;
+  double aboveSeconds = 0;
+  double cost = 0;
+  double windowPumpSeconds[TARIFF_WINDOW_COUNT > 0 ? TARIFF_WINDOW_COUNT : 1] = {0};
+  float minMoisture = 100;
+  float maxMoisture = 0;
+};
+
+Simulation sim;
+
+float envFloat(const char* name, float fallback)
+{
+  const char* value = getenv(name);
+  return value != nullptr ? strtof(value, nullptr) : fallback;
+}
+
+float hourOfDay(unsigned long long micros)
+{
+  double hours = sim.startHour + micros / 3.6e9;
+  return (float)(hours - 24.0 * (long long)(hours / 24.0));
+}
+
+// Temperatura del aire y lluvia (mm/h) en un instante de la simulación
+void weatherAt(unsigned long long micros, float& temperatureC, float& rainMmPerHour)
+{
+  if (!sim.hasWeather)
+  {
+    temperatureC = diurnalTemperature(sim.tempMean, sim.tempSwing, hourOfDay(micros));
+    rainMmPerHour = 0;
+    return;
+  }
+  if (!sim.weather.sample(sim.weatherStartHour + micros / 3.6e9, temperatureC, rainMmPerHour) && !sim.weatherEnded)
+  {
+    sim.weatherEnded = true;
+    fprintf(stderr, "suelo: el archivo de clima terminó a las %.2f h de simulación, sigue la última temperatura sin lluvia\n", micros / 3.6e9);
+  }
+}
+
+void accountStep(float dt, float hour)
+{
+  // El tiempo fuera del rango se cuenta desde que el firmware tiene un cultivo
+  if (sim.crop != 0)
+  {
+    const CropProfile& crop = CROP_PROFILES[sim.crop - 1];
+    if (sim.state.moisture < crop.minHumidity)
+      sim.belowSeconds += dt;
+    if (sim.state.moisture > crop.maxHumidity)
+      sim.aboveSeconds += dt;
+  }
+  if (sim.state.moisture < sim.minMoisture)
+    sim.minMoisture = sim.state.moisture;
+  if (sim.state.moisture > sim.maxMoisture)
+    sim.maxMoisture = sim.state.moisture;
+
+  if (!sim.pumpOn)
+    return;
+  sim.pumpSeconds += dt;
+
+#if TARIFF_WINDOW_COUNT > 0
+  uint16_t minute = (uint16_t)(hour * 60) % MINUTES_PER_DAY;
+  const TariffWindow* window = tariffAt(TARIFF_WINDOWS, TARIFF_WINDOW_COUNT, minute);
+  sim.windowPumpSeconds[window - TARIFF_WINDOWS] += dt;
+  sim.cost += window->price * sim.pumpKw * dt / 3600.0;
+#else
+  (void)hour;
+#endif
+}
+
+// Integra el modelo hasta el instante actual del reloj virtual
+void advance()
+{
+  unsigned long long now = micros();
+  while (sim.simulatedMicros < now)
+  {
+    unsigned long long remaining = now - sim.simulatedMicros;
+    float dt = remaining >= STEP_SECONDS * 1e6 ? STEP_SECONDS : remaining / 1e6f;
+    float hour = hourOfDay(sim.simulatedMicros);
+
+    if (!sim.faultActive && sim.fault != Fault::NONE && sim.simulatedMicros >= sim.faultHours * 3.6e9)
+    {
+      sim.faultActive = true;
+      if (sim.fault == Fault::EVAPORATION)
+        sim.params.evaporationCoeff *= 3;
+    }
+    bool watering = sim.pumpOn && !(sim.faultActive && sim.fault == Fault::LEAK);
+
+    float temperature, rain;
+    weatherAt(sim.simulatedMicros, temperature, rain);
+    soilStep(sim.params, sim.state, dt, temperature, watering, rain);
+    sim.rainMm += rain * dt / 3600.0;
+    accountStep(dt, hour);
+    sim.simulatedMicros += (unsigned long long)(dt * 1e6f + 0.5f);
+  }
+}
+
+// Valor del ADC para una tensión en centésimas de voltio, con la referencia elegida
+int toRaw(float value)
+{
+  float reference = hostAnalogReference() == INTERNAL ? TEMP_VREF : VCC;
+  int raw = (int)(value * ADC_MAX_VALUE / (reference * 100.0f) + 0.5f);
+  return raw < 0 ? 0 : (raw > ADC_MAX_VALUE ? ADC_MAX_VALUE : raw);
+}
+
+// Inversa de las conversiones de SensorData::update()
+int readSensor(uint8_t pin)
+{
+  advance();
+
+  if (pin == HUM_SENSOR)
+  {
+    std::normal_distribution<float> noise(0.0f, sim.noise);
+    float reading = sim.state.probe + (sim.noise > 0 ? noise(sim.rng) : 0);
+    if (sim.faultActive && sim.fault == Fault::DRIFT)
+      reading += DRIFT_PER_HOUR * (sim.simulatedMicros / 3.6e9 - sim.faultHours);
+#if PROBE_POWER_ENABLED
+    if (!sim.probePowered)
+      return 0;
+    float poweredMs = (micros() - sim.probeOnMicros) / 1000.0f;
+    reading *= 1.0f - expf(-poweredMs / PROBE_RISE_MS);
+#endif
+    int raw = toRaw(reading);
+    if (sim.faultActive && sim.fault == Fault::STUCK)
+    {
+      if (sim.stuckRaw < 0)
+        sim.stuckRaw = raw;
+      return sim.stuckRaw;
+    }
+    return raw;
+  }
+  if (pin == TMP_SENSOR)
+  {
+    float temperature, rain;
+    weatherAt(sim.simulatedMicros, temperature, rain);
+    return toRaw(temperature - TEMP_CALIBRATION_OFFSET);
+  }
+  return -1;
+}
+
+void onDigitalWrite(uint8_t pin, uint8_t value)
+{
+#if PROBE_POWER_ENABLED
+  if (pin == PROBE_POWER_PIN && (value == HIGH) != sim.probePowered)
+  {
+    sim.probePowered = value == HIGH;
+    if (sim.probePowered)
+      sim.probeOnMicros = micros();
+    else
+      sim.probePoweredSeconds += (micros() - sim.probeOnMicros) / 1e6;
+  }
+#endif
+  if (pin != IRRIGATION_MOTOR)
+    return;
+  advance();
+  sim.pumpOn = value == HIGH;
+}
+
+void onCropSelected(uint8_t crop)
+{
+  advance(); // Lo anterior a la elección queda fuera de la cuenta
+  sim.crop = crop >= 1 && crop <= CROP_COUNT ? crop : 0;
+}
+
+void report()
+{
+  advance();
+  double hours = sim.simulatedMicros / 3.6e9;
+
+  fprintf(stderr, "suelo: %.2f h simuladas, bomba %.1f min, humedad %.1f-%.1f %%\n", hours, sim.pumpSeconds / 60, sim.minMoisture, sim.maxMoisture);
+  if (sim.crop != 0)
+  {
+    const CropProfile& crop = CROP_PROFILES[sim.crop - 1];
+    fprintf(stderr, "suelo: fuera del rango de %s (%.0f-%.0f %%): %.1f min por debajo, %.1f min por encima\n", crop.name, crop.minHumidity,
+            crop.maxHumidity, sim.belowSeconds / 60, sim.aboveSeconds / 60);
+  }
+  else
+    fprintf(stderr, "suelo: el firmware no llegó a elegir un cultivo, no se mide el tiempo fuera de rango\n");
+  if (sim.hasWeather)
+  {
+    char start[20];
+    WeatherFile::formatHour(sim.weatherStartHour, start, sizeof(start));
+    fprintf(stderr, "suelo: clima desde %s, lluvia %.1f mm\n", start, sim.rainMm);
+  }
+  if (sim.fault != Fault::NONE)
+    fprintf(stderr, "suelo: falla %s desde la hora %.2f%s\n", FAULT_NAMES[(int)sim.fault], sim.faultHours, sim.faultActive ? "" : " (no llegó a ocurrir)");
+#if PROBE_POWER_ENABLED
+  fprintf(stderr, "suelo: sonda alimentada %.2f %% del tiempo\n", 100.0 * sim.probePoweredSeconds / (sim.simulatedMicros / 1e6));
+#endif
+#if TARIFF_WINDOW_COUNT > 0
+  for (uint8_t i = 0; i < TARIFF_WINDOW_COUNT; i++)
+  {
+    fprintf(stderr, "suelo: ventana %02u:%02u-%02u:%02u (%.3f/kWh): bomba %.1f min\n", TARIFF_WINDOWS[i].startMinute / 60,
+            TARIFF_WINDOWS[i].startMinute % 60, TARIFF_WINDOWS[i].endMinute / 60, TARIFF_WINDOWS[i].endMinute % 60, TARIFF_WINDOWS[i].price,
+            sim.windowPumpSeconds[i] / 60);
+  }
+  fprintf(stderr, "suelo: costo de energía %.4f\n", sim.cost);
+#endif
+}
+
+// Se conecta al arrancar el programa, antes de setup()
+struct Installer {
+  Installer()
+  {
+    sim.startHour = envFloat("HOST_SIM_START_HOUR", sim.startHour);
+    sim.state.moisture = sim.state.probe = envFloat("HOST_SIM_HUMIDITY", sim.state.moisture);
+    sim.tempMean = envFloat("HOST_SIM_TEMP_MEAN", sim.tempMean);
+    sim.tempSwing = envFloat("HOST_SIM_TEMP_SWING", sim.tempSwing);
+    sim.noise = envFloat("HOST_SIM_NOISE", sim.noise);
+    sim.pumpKw = envFloat("HOST_SIM_PUMP_KW", sim.pumpKw);
+    const char* soil = getenv("HOST_SIM_SOIL");
+    if (soil != nullptr && soil[0] != '\0')
+      loadSoilParams(soil, sim.params);
+    const char* weather = getenv("HOST_SIM_WEATHER");
+    if (weather != nullptr && weather[0] != '\0' && sim.weather.open(weather))
+    {
+      sim.hasWeather = true;
+      sim.weatherStartHour = floor(sim.weather.firstHour() / 24) * 24 + 24 * envFloat("HOST_SIM_WEATHER_DAY", 0) + sim.startHour;
+    }
+    const char* seed = getenv("HOST_SIM_SEED");
+    sim.rng.seed(seed != nullptr ? strtoul(seed, nullptr, 10) : 1);
+
+    const char* fault = getenv("HOST_SIM_FAULT");
+    if (fault != nullptr && fault[0] != '\0')
+    {
+      const char* at = strchr(fault, '@');
+      for (int i = 1; i < 5; i++)
+      {
+        if (at != nullptr && strncmp(fault, FAULT_NAMES[i], at - fault) == 0 && FAULT_NAMES[i][at - fault] == '\0')
+        {
+          sim.fault = (Fault)i;
+          sim.faultHours = strtod(at + 1, nullptr);
+        }
+      }
+      if (sim.fault == Fault::NONE)
+        fprintf(stderr, "suelo: falla desconocida \"%s\" (stuck@h, leak@h, evaporation@h o drift@h)\n", fault);
+    }
+
+    hostOnCropSelected(onCropSelected);
+
+    hostSetAnalogProvider(readSensor);
+    hostOnDigitalWrite(onDigitalWrite);
+    hostAtExit(report);
+  }
+} installer;
+
+} // namespace
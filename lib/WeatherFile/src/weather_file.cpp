@@ -0,0 +1,427 @@
+// Lectura de archivos de clima (ver weather_file.h)
+
+#include "weather_file.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <stdlib.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Los faltantes son 99.9 y 999; se comparan con un límite más bajo porque 99.9 leído
+// como double es menor que 99.9f
+const double EPW_MISSING_TEMPERATURE = 99.0;
+const double EPW_MISSING_RAIN = 999.0;
+const int EPW_TEMPERATURE_FIELD = 6;  // Dry Bulb Temperature
+const int EPW_RAIN_FIELD = 33;        // Liquid Precipitation Depth
+
+// Días desde el 1970-01-01 de una fecha del calendario gregoriano
+long daysFromCivil(long year, unsigned month, unsigned day)
+{
+  year -= month <= 2;
+  long era = (year >= 0 ? year : year - 399) / 400;
+  unsigned yearOfEra = (unsigned)(year - era * 400);
+  unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + (long)dayOfEra - 719468;
+}
+
+void civilFromDays(long days, long& year, unsigned& month, unsigned& day)
+{
+  days += 719468;
+  long era = (days >= 0 ? days : days - 146096) / 146097;
+  unsigned dayOfEra = (unsigned)(days - era * 146097);
+  unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  unsigned shiftedMonth = (5 * dayOfYear + 2) / 153;
+  day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+  month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+  year = yearOfEra + era * 400 + (month <= 2);
+}
+
+void skipBlanks(const char*& p, const char* end)
+{
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '"'))
+    p++;
+}
+
+// Número decimal sin exponente; la proyección del archivo no termina en '\0', así que
+// no se puede usar strtod()
+bool parseNumber(const char*& p, const char* end, char decimal, double& value)
+{
+  skipBlanks(p, end);
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+'))
+    negative = *p++ == '-';
+  double result = 0;
+  bool digits = false;
+  for (; p < end && *p >= '0' && *p <= '9'; p++, digits = true)
+    result = result * 10 + (*p - '0');
+  if (p < end && *p == decimal)
+  {
+    double scale = 0.1;
+    for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits = true, scale *= 0.1)
+      result += (*p - '0') * scale;
+  }
+  value = negative ? -result : result;
+  return digits;
+}
+
+bool parseUnsigned(const char*& p, const char* end, unsigned& value)
+{
+  const char* start = p;
+  value = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; p++)
+    value = value * 10 + (*p - '0');
+  return p > start;
+}
+
+// Comienzo del campo index de una línea, o nullptr si tiene menos campos
+const char* field(const char* line, const char* end, int index, char separator)
+{
+  for (; index > 0; index--)
+  {
+    line = (const char*)memchr(line, separator, end - line);
+    if (line == nullptr)
+      return nullptr;
+    line++;
+  }
+  return line;
+}
+
+// "AAAA-MM-DD HH:MM[:SS]" o con T, en horas desde el 1970-01-01
+bool parseTimestamp(const char* p, const char* end, double& hour)
+{
+  unsigned year, month, day, hours, minutes, seconds = 0;
+  skipBlanks(p, end);
+  if (!parseUnsigned(p, end, year) || p == end || *p++ != '-' || !parseUnsigned(p, end, month) || p == end || *p++ != '-' ||
+      !parseUnsigned(p, end, day) || p == end || (*p != ' ' && *p != 'T'))
+    return false;
+  p++;
+  if (!parseUnsigned(p, end, hours) || p == end || *p++ != ':' || !parseUnsigned(p, end, minutes))
+    return false;
+  if (p < end && *p == ':')
+    parseUnsigned(++p, end, seconds);
+  if (month < 1 || month > 12 || day < 1 || day > 31 || hours > 24 || minutes > 59 || seconds > 60)
+    return false;
+  hour = daysFromCivil(year, month, day) * 24.0 + hours + minutes / 60.0 + seconds / 3600.0;
+  return true;
+}
+
+// Nombre de una columna del encabezado, sin comillas ni espacios y en minúsculas
+void columnName(const char* p, const char* end, char separator, char* name, size_t size)
+{
+  skipBlanks(p, end);
+  size_t length = 0;
+  for (; p < end && *p != separator && length + 1 < size; p++)
+  {
+    if (*p != '"' && *p != ' ' && *p != '\t')
+      name[length++] = (*p >= 'A' && *p <= 'Z') ? *p - 'A' + 'a' : *p;
+  }
+  name[length] = '\0';
+}
+
+bool nameIn(const char* name, const char* const* names)
+{
+  for (; *names != nullptr; names++)
+  {
+    if (strcmp(name, *names) == 0)
+      return true;
+  }
+  return false;
+}
+
+} // namespace
+
+WeatherFile::~WeatherFile()
+{
+#if defined(_WIN32)
+  delete[] data;
+#else
+  if (mapped)
+    munmap((void*)data, size);
+#endif
+}
+
+bool WeatherFile::open(const char* filePath)
+{
+  path = filePath;
+#if defined(_WIN32)
+  // Sin proyección en memoria: se lee el archivo completo
+  FILE* file = fopen(path, "rb");
+  if (file != nullptr && fseek(file, 0, SEEK_END) == 0)
+  {
+    long length = ftell(file);
+    char* buffer = length > 0 ? new char[length] : nullptr;
+    if (buffer != nullptr && fseek(file, 0, SEEK_SET) == 0 && fread(buffer, 1, length, file) == (size_t)length)
+    {
+      data = buffer;
+      size = length;
+    }
+    else
+      delete[] buffer;
+  }
+  if (file != nullptr)
+    fclose(file);
+  mapped = data != nullptr;
+#else
+  int descriptor = ::open(path, O_RDONLY);
+  struct stat info;
+  if (descriptor >= 0 && fstat(descriptor, &info) == 0 && info.st_size > 0)
+  {
+    void* address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (address != MAP_FAILED)
+    {
+      madvise(address, info.st_size, MADV_SEQUENTIAL);
+      data = (const char*)address;
+      size = info.st_size;
+      mapped = true;
+    }
+  }
+  if (descriptor >= 0)
+    close(descriptor);
+#endif
+  if (!mapped)
+  {
+    fprintf(stderr, "clima: no se pudo leer %s\n", path);
+    return false;
+  }
+
+  cursor = data;
+  if (size >= 3 && memcmp(cursor, "\xEF\xBB\xBF", 3) == 0)
+    cursor += 3; // Marca de orden de bytes de UTF-8
+  if (!readHeader())
+    return false;
+  if (!next(first))
+  {
+    fprintf(stderr, "clima: %s no tiene registros\n", path);
+    return false;
+  }
+  current = first;
+  return true;
+}
+
+bool WeatherFile::readHeader()
+{
+  const char* end;
+  const char* header = nextLine(end);
+  if (header == nullptr)
+    return false;
+
+  if (end - header >= 8 && memcmp(header, "LOCATION", 8) == 0)
+  {
+    format = Format::EPW;
+    while ((header = nextLine(end)) != nullptr)
+    {
+      if (end - header >= 12 && memcmp(header, "DATA PERIODS", 12) == 0)
+      {
+        const char* p = field(header, end, 2, ',');
+        unsigned perHour;
+        if (p == nullptr || !parseUnsigned(p, end, perHour) || perHour == 0)
+          break;
+        intervalHours = 1.0 / perHour;
+        return true;
+      }
+    }
+    fprintf(stderr, "clima: %s: falta la línea DATA PERIODS del encabezado EPW\n", path);
+    return false;
+  }
+
+  format = Format::CSV;
+  separator = memchr(header, ';', end - header) != nullptr && memchr(header, ',', end - header) == nullptr ? ';' : ',';
+  static const char* const TIME_NAMES[] = {"fecha", "time", "timestamp", nullptr};
+  static const char* const TEMPERATURE_NAMES[] = {"temperatura", "temperature", "temp_c", nullptr};
+  static const char* const RAIN_NAMES[] = {"lluvia", "rain", "precip_mm", nullptr};
+  const char* p = header;
+  for (int column = 0; p != nullptr; column++)
+  {
+    char name[32];
+    columnName(p, end, separator, name, sizeof(name));
+    if (nameIn(name, TIME_NAMES))
+      timeColumn = column;
+    else if (nameIn(name, TEMPERATURE_NAMES))
+      temperatureColumn = column;
+    else if (nameIn(name, RAIN_NAMES))
+      rainColumn = column;
+    p = field(p, end, 1, separator);
+  }
+  if (timeColumn < 0 || temperatureColumn < 0)
+  {
+    fprintf(stderr, "clima: %s: el encabezado necesita las columnas fecha y temperatura (o un archivo EPW)\n", path);
+    return false;
+  }
+  return true;
+}
+
+// Línea siguiente sin el salto final; nullptr al terminar el archivo
+const char* WeatherFile::nextLine(const char*& end)
+{
+  const char* dataEnd = data + size;
+  if (cursor >= dataEnd)
+    return nullptr;
+  const char* start = cursor;
+  const char* newline = (const char*)memchr(start, '\n', dataEnd - start);
+  end = newline != nullptr ? newline : dataEnd;
+  cursor = newline != nullptr ? newline + 1 : dataEnd;
+  if (end > start && end[-1] == '\r')
+    end--;
+  line++;
+  return start;
+}
+
+bool WeatherFile::next(WeatherRecord& record)
+{
+  const char* end;
+  const char* start;
+  while ((start = nextLine(end)) != nullptr)
+  {
+    if (start == end)
+      continue;
+    bool valid = format == Format::EPW ? parseEpw(start, end, record) : parseCsv(start, end, record);
+    if (valid)
+    {
+      records++;
+      return true;
+    }
+    fprintf(stderr, "clima: %s:%lu: registro inválido\n", path, line);
+  }
+  return false;
+}
+
+bool WeatherFile::parseEpw(const char* start, const char* end, WeatherRecord& record)
+{
+  if (records == 0)
+  {
+    // Año, mes, día, hora (1 a 24, la del final del intervalo) y minuto
+    unsigned values[5];
+    const char* p = start;
+    for (int i = 0; i < 5; i++)
+    {
+      if (p == nullptr || !parseUnsigned(p, end, values[i]))
+        return false;
+      p = field(p, end, 1, ',');
+    }
+    if (values[1] < 1 || values[1] > 12 || values[2] < 1 || values[2] > 31 || values[3] < 1 || values[3] > 24)
+      return false;
+    unsigned minute = values[4] == 0 ? 60 : values[4];
+    record.hour = daysFromCivil(values[0], values[1], values[2]) * 24.0 + values[3] - 1 + minute / 60.0;
+  }
+  else
+    record.hour = first.hour + records * intervalHours;
+
+  double value;
+  const char* p = field(start, end, EPW_TEMPERATURE_FIELD, ',');
+  if (p == nullptr)
+    return false;
+  record.temperatureC = parseNumber(p, end, '.', value) && value < EPW_MISSING_TEMPERATURE ? (float)value : current.temperatureC;
+  p = field(start, end, EPW_RAIN_FIELD, ',');
+  record.rainMm = p != nullptr && parseNumber(p, end, '.', value) && value >= 0 && value < EPW_MISSING_RAIN ? (float)value : 0;
+  return true;
+}
+
+bool WeatherFile::parseCsv(const char* start, const char* end, WeatherRecord& record)
+{
+  char decimal = separator == ';' ? ',' : '.';
+  const char* p = field(start, end, timeColumn, separator);
+  if (p == nullptr || !parseTimestamp(p, end, record.hour))
+    return false;
+  if (records > 0 && record.hour <= current.hour)
+    return false; // Fuera de orden o repetida
+
+  double value;
+  p = field(start, end, temperatureColumn, separator);
+  if (p == nullptr)
+    return false;
+  record.temperatureC = parseNumber(p, end, decimal, value) ? (float)value : current.temperatureC;
+  p = rainColumn >= 0 ? field(start, end, rainColumn, separator) : nullptr;
+  record.rainMm = p != nullptr && parseNumber(p, end, decimal, value) && value > 0 ? (float)value : 0;
+  return true;
+}
+
+bool WeatherFile::sample(double hour, float& temperatureC, float& rainMmPerHour)
+{
+  // Un día de inicio lejano en un EPW se alcanza contando saltos de línea, sin
+  // interpretar los registros; se leen los dos últimos para interpolar. Si el salto
+  // pasa el final del archivo se vuelve al último registro.
+  if (format == Format::EPW && !ended && hour - current.hour > 3 * intervalHours)
+  {
+    unsigned long skip = (unsigned long)((hour - current.hour) / intervalHours) - 2;
+    const char* lastRecord = cursor;
+    unsigned long lastRecords = records, lastLine = line;
+    for (; skip > 0; skip--, records++)
+    {
+      const char* start = cursor;
+      const char* end;
+      if (nextLine(end) == nullptr)
+        break;
+      if (end > start)
+      {
+        lastRecord = start;
+        lastRecords = records;
+        lastLine = line - 1;
+      }
+    }
+    if (skip > 0)
+    {
+      cursor = lastRecord;
+      records = lastRecords;
+      line = lastLine;
+    }
+    hasPrevious = false;
+  }
+
+  while (!ended && current.hour < hour)
+  {
+    WeatherRecord record;
+    if (!next(record))
+    {
+      ended = true;
+      break;
+    }
+    previous = current;
+    current = record;
+    hasPrevious = true;
+  }
+
+  if (hour > current.hour)
+  {
+    temperatureC = current.temperatureC;
+    rainMmPerHour = 0;
+    return false;
+  }
+  if (!hasPrevious || hour <= previous.hour)
+  {
+    temperatureC = current.temperatureC;
+    rainMmPerHour = 0;
+    return true;
+  }
+  double span = current.hour - previous.hour;
+  float fraction = (float)((hour - previous.hour) / span);
+  temperatureC = previous.temperatureC + (current.temperatureC - previous.temperatureC) * fraction;
+  rainMmPerHour = (float)(current.rainMm / span);
+  return true;
+}
+
+void WeatherFile::formatHour(double hour, char* text, size_t size)
+{
+  long days = (long)floor(hour / 24);
+  long minutes = lround((hour - days * 24.0) * 60);
+  if (minutes >= 24 * 60)
+  {
+    days++;
+    minutes -= 24 * 60;
+  }
+  long year;
+  unsigned month, day;
+  civilFromDays(days, year, month, day);
+  snprintf(text, size, "%04ld-%02u-%02u %02ld:%02ld", year, month, day, minutes / 60, minutes % 60);
+}
@@ -0,0 +1,82 @@
+// Clima registrado para la simulación: temperatura del aire y lluvia de un archivo
+// Formatos reconocidos:
+// - EPW (EnergyPlus): se detecta por la línea LOCATION del encabezado. Se usan la
+//   temperatura de bulbo seco y la lluvia del intervalo (Liquid Precipitation Depth);
+//   los valores faltantes (99.9 y 999) repiten la temperatura anterior y cuentan como
+//   sin lluvia. El primer registro fija la fecha y los siguientes avanzan de a un
+//   intervalo (DATA PERIODS), porque los años típicos mezclan meses de años distintos.
+// - CSV con encabezado: columnas fecha (o time), temperatura (o temperature, temp_c) y,
+//   opcional, lluvia (o rain, precip_mm) con los mm caídos desde la fila anterior. La
+//   fecha es "AAAA-MM-DD HH:MM[:SS]" (o con T). Con ';' como separador se acepta la
+//   coma decimal.
+//
+// El archivo se proyecta en memoria y cada registro se interpreta recién cuando la
+// simulación llega a él: abrir un archivo de varios años o de varias estaciones no
+// cuesta más que abrir uno corto, y en un EPW saltar al día de inicio solo cuenta
+// saltos de línea.
+
+#ifndef WEATHER_FILE_H
+#define WEATHER_FILE_H
+
+#include <stddef.h>
+
+struct WeatherRecord {
+  double hour = 0;          // Final del intervalo, en horas desde el 1970-01-01 00:00
+  float temperatureC = 0;
+  float rainMm = 0;         // Lluvia caída en el intervalo que termina en el registro
+};
+
+class WeatherFile {
+public:
+  WeatherFile() = default;
+  ~WeatherFile();
+  WeatherFile(const WeatherFile&) = delete;
+  WeatherFile& operator=(const WeatherFile&) = delete;
+
+  // Proyecta el archivo y lee su encabezado y el primer registro; si no es válido
+  // explica el motivo en stderr y devuelve false
+  bool open(const char* path);
+
+  // Instante del primer registro
+  double firstHour() const { return first.hour; }
+
+  // Temperatura interpolada entre registros y lluvia (mm/h) en un instante; los instantes
+  // de llamadas sucesivas no pueden retroceder. Pasado el último registro repite su
+  // temperatura sin lluvia y devuelve false.
+  bool sample(double hour, float& temperatureC, float& rainMmPerHour);
+
+  // Fecha y hora de un instante como "AAAA-MM-DD HH:MM"
+  static void formatHour(double hour, char* text, size_t size);
+
+private:
+  enum class Format { EPW, CSV };
+
+  bool next(WeatherRecord& record);
+  bool parseEpw(const char* start, const char* end, WeatherRecord& record);
+  bool parseCsv(const char* start, const char* end, WeatherRecord& record);
+  bool readHeader();
+  const char* nextLine(const char*& end);
+
+  const char* path = nullptr;
+  const char* data = nullptr;
+  size_t size = 0;
+  bool mapped = false;
+  const char* cursor = nullptr;
+  unsigned long line = 0;
+
+  Format format = Format::CSV;
+  char separator = ',';
+  int timeColumn = -1;
+  int temperatureColumn = -1;
+  int rainColumn = -1;
+  double intervalHours = 1;  // EPW: duración de cada registro
+  unsigned long records = 0;
+
+  WeatherRecord first;
+  WeatherRecord previous;
+  WeatherRecord current;
+  bool hasPrevious = false;
+  bool ended = false;
+};
+
+#endif
@@ -0,0 +1,590 @@
+"""Genera board_config.h a partir de la descripción de la placa y los cultivos (config/board.json).
+
+Se ejecuta como extra_script de PlatformIO antes de compilar cada entorno. El archivo
+de configuración se elige con la opción `custom_board_config` del entorno y el
+encabezado se escribe en <build_dir>/generated, así cada entorno tiene el suyo.
+
+Antes de generar valida la configuración:
+- que ningún pin se use dos veces (ni choque con el puerto serie si está habilitado)
+- que los sensores estén en canales del ADC que existan en la placa
+- que la SRAM estimada quepa en la placa con margen para la pila, contando el perfilador,
+  las trazas y la telemetría si las build_flags del entorno los habilitan (fuera de
+  PlatformIO se pasan como argumentos: gen_config.py config.json board_config.h -DENABLE_TRACE)
+- que los rangos de cada cultivo sean coherentes y que el cultivo fijo exista
+- que los nombres de los cultivos sean ASCII imprimible (la pantalla no tiene tildes) y
+  quepan en una línea; en el encabezado se escriben como literales con escapes
+- que las ventanas de tarifa cubran el día completo, en orden y sin solaparse
+- que el objetivo de latencia del control tenga un percentil y un límite válidos
+- que la alimentación conmutada de la sonda de humedad deje leerla dentro de ese objetivo
+- que con la referencia interna del ADC el TMP36 alcance a medir el rango de los cultivos
+- que el detector de cruce por cero tenga una frecuencia de red y un tiempo de relé válidos
+- que el registro en la tarjeta SD tenga libres los pines del bus SPI
+- que el mapa de teclas tenga el tamaño del teclado
+
+Si la configuración define "fixed_crop", el firmware se especializa para ese cultivo:
+no muestra el menú y compara contra los umbrales como constantes.
+
+También se puede usar desde la línea de comandos:
+    python scripts/gen_config.py config/board.json salida/board_config.h
+"""
+
+import json
+import os
+import sys
+
+# Descripción de las placas soportadas
+BOARDS = {
+    "uno": {
+        "sram": 2048,
+        "digital": list(range(0, 20)),
+        "analog": {"A0": 14, "A1": 15, "A2": 16, "A3": 17, "A4": 18, "A5": 19},
+        "analog_only": [],
+        "serial": [0, 1],
+        "pcint": {"PCINT2_vect": range(0, 8), "PCINT0_vect": range(8, 14), "PCINT1_vect": range(14, 20)},
+        "spi": {"ss": 10, "mosi": 11, "miso": 12, "sck": 13},
+    },
+    "nano": {
+        "sram": 2048,
+        "digital": list(range(0, 20)),
+        "analog": {"A0": 14, "A1": 15, "A2": 16, "A3": 17, "A4": 18, "A5": 19, "A6": 20, "A7": 21},
+        "analog_only": [20, 21],
+        "serial": [0, 1],
+        "pcint": {"PCINT2_vect": range(0, 8), "PCINT0_vect": range(8, 14), "PCINT1_vect": range(14, 20)},
+        "spi": {"ss": 10, "mosi": 11, "miso": 12, "sck": 13},
+    },
+}
+
+# Estimación de la SRAM usada por el firmware sin contar los cultivos:
+# núcleo de Arduino (millis, vectores), objetos LiquidCrystal y Keypad, estado
+# global y las String temporales que arma el menú en el heap
+BASE_SRAM_BYTES = 420
+SERIAL_SRAM_BYTES = 157   # Buffers de recepción y transmisión de HardwareSerial
+CROP_SRAM_BYTES = 18      # Puntero al nombre y 4 float por cultivo
+TARIFF_SRAM_BYTES = 8     # Inicio, fin y precio de cada ventana de tarifa
+SD_LOG_SRAM_BYTES = 91    # Registros pendientes y estado de la tarjeta SD
+LATENCY_SRAM_BYTES = 110  # Histograma de latencia del control, tiempo de muestreo y latencias del relé sin retirar
+ANOMALY_SRAM_BYTES = 320  # Estado del detector de anomalías (solo con "anomaly_detection")
+FORECAST_SRAM_BYTES = 70  # Ajuste del pronóstico de humedad
+STACK_RESERVE_BYTES = 512 # Margen mínimo que se deja libre para la pila
+
+# Buffers que solo existen cuando el entorno los habilita con build_flags
+OPTIONAL_SRAM_BYTES = {
+    "ENABLE_PROFILER": 256,   # Histograma del perfilador
+    "ENABLE_TRACE": 128,      # Buffer circular de trazas
+    "ENABLE_TELEMETRY": 70,   # Envío comprimido y estado del codificador
+}
+
+# Mapas de teclas habituales según las columnas del teclado
+DEFAULT_KEYMAPS = {
+    4: ["123A", "456B", "789C", "*0#D"],
+    3: ["123", "456", "789", "*0#"],
+}
+
+# Objetivo de latencia del control si la configuración no define "latency_slo"
+DEFAULT_LATENCY_PERCENTILE = 99
+DEFAULT_LATENCY_LIMIT_MS = 400
+
+HEADER = """// Archivo generado por scripts/gen_config.py a partir de {source}
+// No editar: los cambios se pierden en la siguiente compilación
+
+#ifndef BOARD_CONFIG_H
+#define BOARD_CONFIG_H
+
+#include <stdint.h>
+
+#include "crop_profile.h"
+#include "tariff.h"
+"""
+
+
+class ConfigError(Exception):
+    pass
+
+
+def resolve_pin(board, value, name):
+    """Convierte "A0" o un número en el número de pin de Arduino."""
+    if isinstance(value, str):
+        if value not in board["analog"]:
+            raise ConfigError("%s: el pin %s no existe en la placa" % (name, value))
+        return board["analog"][value]
+    if value not in board["digital"]:
+        raise ConfigError("%s: el pin %d no existe en la placa" % (name, value))
+    return value
+
+
+def collect_pins(board, config):
+    """Devuelve la lista (nombre, pin) de todos los pines usados."""
+    pins = config["pins"]
+    used = [
+        ("temperature_sensor", resolve_pin(board, pins["temperature_sensor"], "temperature_sensor")),
+        ("humidity_sensor", resolve_pin(board, pins["humidity_sensor"], "humidity_sensor")),
+        ("irrigation_motor", resolve_pin(board, pins["irrigation_motor"], "irrigation_motor")),
+    ]
+    for signal in ("rs", "enable", "d4", "d5", "d6", "d7"):
+        used.append(("lcd." + signal, resolve_pin(board, pins["lcd"][signal], "lcd." + signal)))
+    for kind in ("rows", "cols"):
+        for index, pin in enumerate(pins["keypad"][kind]):
+            name = "keypad.%s[%d]" % (kind, index)
+            used.append((name, resolve_pin(board, pin, name)))
+    if "probe_power" in config:
+        used.append(("probe_power", resolve_pin(board, config["probe_power"]["pin"], "probe_power")))
+    if "zero_cross" in config:
+        used.append(("zero_cross", resolve_pin(board, config["zero_cross"]["pin"], "zero_cross")))
+    if "sd_log" in config:
+        # El bus SPI usa pines fijos; SS debe quedar como salida aunque no sea el CS de la tarjeta
+        cs = resolve_pin(board, config["sd_log"]["cs"], "sd_log.cs")
+        used.append(("sd_log.cs", cs))
+        for signal in ("ss", "mosi", "miso", "sck"):
+            if board["spi"][signal] != cs:
+                used.append(("spi." + signal, board["spi"][signal]))
+    return used
+
+
+def validate(board, config, defines):
+    used = collect_pins(board, config)
+
+    owners = {}
+    for name, pin in used:
+        if pin in owners:
+            raise ConfigError("el pin %d está asignado a %s y a %s" % (pin, owners[pin], name))
+        owners[pin] = name
+
+    if config["serial"]["enabled"]:
+        for pin in board["serial"]:
+            if pin in owners:
+                raise ConfigError("el puerto serie está habilitado pero el pin %d lo usa %s" % (pin, owners[pin]))
+
+    # Los sensores deben estar en un canal del ADC
+    analog_pins = set(board["analog"].values())
+    for name in ("temperature_sensor", "humidity_sensor"):
+        pin = dict(used)[name]
+        if pin not in analog_pins:
+            raise ConfigError("%s: el pin %d no tiene canal del ADC" % (name, pin))
+
+    # Los pines solo analógicos (A6/A7 del Nano) no sirven como salida ni para el teclado o la pantalla
+    for name, pin in used:
+        if pin in board["analog_only"] and not name.endswith("_sensor"):
+            raise ConfigError("%s: el pin %d solo es entrada analógica" % (name, pin))
+
+    crops = config["crops"]
+    if not crops:
+        raise ConfigError("no hay cultivos configurados")
+    if len(crops) > 9:
+        raise ConfigError("el teclado solo permite elegir entre 9 cultivos")
+    for crop in crops:
+        # La ROM del HD44780 no tiene tildes ni ñ: en UTF-8 se verían como otros símbolos
+        # y cada letra ocuparía dos lugares de la pantalla
+        if not crop["name"] or any(not " " <= char <= "~" for char in crop["name"]):
+            raise ConfigError("%r: el nombre solo puede tener letras sin tildes, números y signos ASCII" % crop["name"])
+        if crop["min_temp"] > crop["max_temp"] or crop["min_humidity"] > crop["max_humidity"]:
+            raise ConfigError("%s: el mínimo es mayor que el máximo" % crop["name"])
+        if len(crop["name"]) > 16:
+            raise ConfigError("%s: el nombre no cabe en una línea de la pantalla" % crop["name"])
+
+    fixed_crop_index(config)
+    temperature_reference(config)
+    tariff_windows(config)
+    latency_slo(config)
+    probe_power(config)
+    if zero_cross(config) is not None:
+        pcint_vector(board, dict(used)["zero_cross"])
+    sd_log(config)
+    anomaly_detection(config)
+    keymap(config)
+
+    sram = estimate_sram(config, defines)
+    if sram + STACK_RESERVE_BYTES > board["sram"]:
+        raise ConfigError("SRAM estimada %d bytes: no queda margen para la pila (%d bytes)" % (sram, board["sram"]))
+    return sram
+
+
+def parse_minute(text, name):
+    """Convierte "HH:MM" en minutos desde la medianoche (se admite "24:00")."""
+    try:
+        hours, minutes = (int(part) for part in text.split(":"))
+    except ValueError:
+        raise ConfigError("%s: hora inválida %r" % (name, text))
+    if hours < 0 or hours > 24 or minutes < 0 or minutes > 59 or (hours == 24 and minutes != 0):
+        raise ConfigError("%s: hora inválida %r" % (name, text))
+    return hours * 60 + minutes
+
+
+def tariff_windows(config):
+    """Lista (inicio, fin, precio) en minutos; deben cubrir el día completo en orden."""
+    windows = []
+    expected = 0
+    for index, window in enumerate(config.get("tariff", [])):
+        name = "tariff[%d]" % index
+        start = parse_minute(window["start"], name)
+        end = parse_minute(window["end"], name)
+        if start != expected or end <= start:
+            raise ConfigError("%s: las ventanas deben ir en orden y sin huecos desde las 00:00" % name)
+        if window["price"] < 0:
+            raise ConfigError("%s: precio negativo" % name)
+        windows.append((start, end, window["price"]))
+        expected = end
+    if windows and expected != 24 * 60:
+        raise ConfigError("tariff: las ventanas deben terminar a las 24:00")
+    return windows
+
+
+def temperature_reference(config):
+    """Voltaje de referencia del ADC para el TMP36 y si es la referencia interna."""
+    calibration = config["calibration"]
+    reference = calibration.get("temperature_reference", "vcc")
+    if reference == "vcc":
+        return calibration["vcc"], False
+    if reference != "internal":
+        raise ConfigError("calibration.temperature_reference: debe ser \"vcc\" o \"internal\"")
+
+    # La referencia de cada placa se aparta hasta un 9 % de 1.1 V: se exige el valor medido
+    if "internal_vref" not in calibration:
+        raise ConfigError("calibration.internal_vref: con la referencia interna hay que anotar la tensión medida en AREF")
+    vref = calibration["internal_vref"]
+    if vref < 1.0 or vref > 1.2:
+        raise ConfigError("calibration.internal_vref: la referencia interna está entre 1.0 y 1.2 V")
+    # Con 1.1 V el TMP36 satura en 1.1 V * 100 - 50 = 60 °C
+    ceiling = vref * 100 + calibration["temperature_offset"]
+    for crop in config["crops"]:
+        if crop["max_temp"] >= ceiling:
+            raise ConfigError("%s: con la referencia interna la temperatura satura en %.0f °C" % (crop["name"], ceiling))
+    return vref, True
+
+
+def latency_slo(config):
+    """(percentil, límite en ms) del objetivo de latencia entre la lectura y el relé."""
+    slo = config.get("latency_slo", {})
+    percentile = slo.get("percentile", DEFAULT_LATENCY_PERCENTILE)
+    limit_ms = slo.get("limit_ms", DEFAULT_LATENCY_LIMIT_MS)
+    if not isinstance(percentile, int) or percentile < 1 or percentile > 100:
+        raise ConfigError("latency_slo: el percentil debe ser un entero entre 1 y 100")
+    if limit_ms <= 0:
+        raise ConfigError("latency_slo: el límite debe ser positivo")
+    return percentile, limit_ms
+
+
+def probe_power(config):
+    """(espera, periodo, lecturas) de la sonda con alimentación conmutada, o None si está siempre alimentada."""
+    probe = config.get("probe_power")
+    if probe is None:
+        return None
+    settle_ms = probe.get("settle_ms", 10)
+    period_ms = probe.get("period_ms", 1000)
+    burst = probe.get("burst", 4)
+    if settle_ms < 1 or settle_ms > 250:
+        raise ConfigError("probe_power: la espera debe estar entre 1 y 250 ms")
+    if period_ms <= settle_ms or period_ms > 60000:
+        raise ConfigError("probe_power: el periodo debe ser mayor que la espera y de hasta 60 s")
+    if burst < 1 or burst > 64:
+        raise ConfigError("probe_power: entre 1 y 64 lecturas por encendido")
+    # Entre lecturas el valor envejece hasta un periodo completo antes de llegar al relé
+    _, limit_ms = latency_slo(config)
+    if period_ms >= limit_ms:
+        raise ConfigError("probe_power: con un periodo de %d ms la latencia nunca cumple el objetivo de %d ms (latency_slo)"
+                          % (period_ms, limit_ms))
+    return settle_ms, period_ms, burst
+
+
+def zero_cross(config):
+    """(semiperiodo, retardo) en us del relé sincronizado con la red, o None si conmuta directo."""
+    detector = config.get("zero_cross")
+    if detector is None:
+        return None
+    mains_hz = detector.get("mains_hz", 60)
+    operate_ms = detector.get("relay_operate_ms", 0)
+    if mains_hz not in (50, 60):
+        raise ConfigError("zero_cross: la frecuencia de la red debe ser 50 o 60 Hz")
+    if operate_ms < 0 or operate_ms > 20:
+        raise ConfigError("zero_cross: el tiempo de operación del relé debe estar entre 0 y 20 ms")
+    half_period_us = round(500000 / mains_hz)
+    # La bobina se energiza para que los contactos cierren justo en un cruce posterior
+    operate_us = round(operate_ms * 1000)
+    delay_us = (half_period_us - operate_us % half_period_us) % half_period_us
+    return half_period_us, delay_us
+
+
+def sd_log(config):
+    """(bloque inicial, bloques, intervalo en ms) del registro en la tarjeta SD, o None."""
+    log = config.get("sd_log")
+    if log is None:
+        return None
+    # Sin valores por defecto: la zona depende de cómo está particionada cada tarjeta
+    if "start_block" not in log or "blocks" not in log:
+        raise ConfigError("sd_log: start_block y blocks son obligatorios y la zona debe quedar fuera de las particiones")
+    start = log["start_block"]
+    blocks = log["blocks"]
+    interval_ms = log.get("interval_ms", 10000)
+    if start < 1 or blocks < 2 or start + blocks > 1 << 32:
+        raise ConfigError("sd_log: zona de la tarjeta inválida")
+    if interval_ms < 1000:
+        raise ConfigError("sd_log: el intervalo mínimo entre registros es 1000 ms")
+    return start, blocks, interval_ms
+
+
+def anomaly_detection(config):
+    """True si el firmware incluye el detector de anomalías (por defecto no)."""
+    enabled = config.get("anomaly_detection", False)
+    if not isinstance(enabled, bool):
+        raise ConfigError("anomaly_detection: debe ser true o false")
+    return enabled
+
+
+def keymap(config):
+    """Filas del mapa de teclas; por defecto el habitual para el número de columnas."""
+    keypad = config["pins"]["keypad"]
+    rows = len(keypad["rows"])
+    cols = len(keypad["cols"])
+    keys = keypad.get("keys", DEFAULT_KEYMAPS.get(cols))
+    if keys is None or len(keys) != rows or any(len(row) != cols for row in keys):
+        raise ConfigError("pins.keypad.keys: el mapa de teclas debe tener %d filas de %d teclas" % (rows, cols))
+    if any(digit not in "".join(keys) for digit in "0123456789"):
+        raise ConfigError("pins.keypad.keys: faltan dígitos para elegir el cultivo y la hora")
+    return keys
+
+
+def pcint_vector(board, pin):
+    for vector, pins in board["pcint"].items():
+        if pin in pins:
+            return vector
+    raise ConfigError("zero_cross: el pin %d no tiene interrupción por cambio de nivel" % pin)
+
+
+def fixed_crop_index(config):
+    """Índice (desde 1) del cultivo fijo, o None si se elige en el menú."""
+    name = config.get("fixed_crop")
+    if name is None:
+        return None
+    for index, crop in enumerate(config["crops"]):
+        if crop["name"] == name:
+            return index + 1
+    raise ConfigError("fixed_crop: el cultivo %s no está en la lista" % name)
+
+
+def estimate_sram(config, defines):
+    crops = config["crops"]
+    sram = BASE_SRAM_BYTES + LATENCY_SRAM_BYTES + FORECAST_SRAM_BYTES
+    sram += CROP_SRAM_BYTES * len(crops)
+    sram += sum(len(crop["name"]) + 1 for crop in crops)
+    sram += TARIFF_SRAM_BYTES * len(config.get("tariff", []))
+    if config["serial"]["enabled"]:
+        sram += SERIAL_SRAM_BYTES
+    if "sd_log" in config:
+        sram += SD_LOG_SRAM_BYTES
+    if anomaly_detection(config):
+        sram += ANOMALY_SRAM_BYTES
+    for name, size in OPTIONAL_SRAM_BYTES.items():
+        if name in defines:
+            sram += size
+    return sram
+
+
+def build_defines(flags):
+    """Nombres definidos con -D en una lista de opciones del compilador."""
+    defines = set()
+    tokens = []
+    for flag in flags:
+        tokens.extend(str(flag).split())
+    for index, token in enumerate(tokens):
+        if token == "-D" and index + 1 < len(tokens):
+            token = "-D" + tokens[index + 1]
+        if token.startswith("-D") and len(token) > 2:
+            defines.add(token[2:].split("=", 1)[0])
+    return defines
+
+
+def c_float(value):
+    return "%sf" % repr(float(value))
+
+
+def c_string(text):
+    """Literal de C entre comillas; también sirve en comentarios, donde una \\ final uniría la línea siguiente."""
+    return '"%s"' % text.replace("\\", "\\\\").replace('"', '\\"')
+
+
+def render(config, board, source, sram, defines):
+    pins = config["pins"]
+    used = dict(collect_pins(board, config))
+    delays = config["delays_ms"]
+    calibration = config["calibration"]
+    crops = config["crops"]
+
+    out = [HEADER.format(source=source)]
+
+    out.append("// ========= CONFIGURACIÓN DE HARDWARE =========")
+    optional = sorted(name for name in OPTIONAL_SRAM_BYTES if name in defines)
+    out.append("// Placa: %s, SRAM estimada: %d de %d bytes (%s)" % (
+        config["board"], sram, board["sram"], "con " + ", ".join(optional) if optional else "sin perfilador, trazas ni telemetría"))
+    out.append("")
+    out.append("// Pines analógicos para sensores")
+    out.append("constexpr uint8_t TMP_SENSOR = %d; // %s" % (used["temperature_sensor"], pins["temperature_sensor"]))
+    out.append("constexpr uint8_t HUM_SENSOR = %d; // %s" % (used["humidity_sensor"], pins["humidity_sensor"]))
+    out.append("")
+    out.append("// Pines digitales para actuadores")
+    out.append("constexpr uint8_t IRRIGATION_MOTOR = %d; // %s" % (used["irrigation_motor"], pins["irrigation_motor"]))
+    out.append("")
+    out.append("// Pantalla LCD en modo 4 bits")
+    for signal in ("rs", "enable", "d4", "d5", "d6", "d7"):
+        out.append("constexpr uint8_t LCD_%s = %d;" % (signal.upper(), used["lcd." + signal]))
+    out.append("")
+    out.append("// Teclado matricial")
+    out.append("constexpr uint8_t ROWS = %d;" % len(pins["keypad"]["rows"]))
+    out.append("constexpr uint8_t COLS = %d;" % len(pins["keypad"]["cols"]))
+    out.append("#define KEYPAD_ROW_PINS {%s}" % ", ".join(str(used["keypad.rows[%d]" % i]) for i in range(len(pins["keypad"]["rows"]))))
+    out.append("#define KEYPAD_COL_PINS {%s}" % ", ".join(str(used["keypad.cols[%d]" % i]) for i in range(len(pins["keypad"]["cols"]))))
+    out.append("#define KEYPAD_KEYMAP {%s}" % ", ".join("{%s}" % ", ".join("'%s'" % key.replace("\\", "\\\\").replace("'", "\\'") for key in row) for row in keymap(config)))
+    out.append("")
+    out.append("// Puerto serie")
+    out.append("#define SERIAL_ENABLED %d" % (1 if config["serial"]["enabled"] else 0))
+    out.append("constexpr unsigned long SERIAL_BAUD = %dUL;" % config["serial"]["baud"])
+    out.append("")
+    out.append("// Tiempos de espera (ms)")
+    out.append("constexpr unsigned long DELAY_KEYPAD_MS = %dUL;   // Respuesta del teclado" % delays["keypad"])
+    out.append("constexpr unsigned long DELAY_STANDARD_MS = %dUL; // Entre lecturas de los sensores" % delays["standard"])
+    out.append("constexpr unsigned long DELAY_LONG_MS = %dUL;     // Mensajes en pantalla" % delays["long"])
+    out.append("")
+    out.append("// Calibración")
+    out.append("constexpr float TEMP_CALIBRATION_OFFSET = %s; // Ajuste del sensor TMP36" % c_float(calibration["temperature_offset"]))
+    out.append("constexpr int ADC_MAX_VALUE = %d; // Valor máximo del ADC" % calibration["adc_max"])
+    out.append("constexpr float VCC = %s; // Voltaje de alimentación" % c_float(calibration["vcc"]))
+    vref, internal = temperature_reference(config)
+    out.append("#define TEMP_INTERNAL_REFERENCE %d // Referencia del ADC para el TMP36: 1 interna, 0 AVcc" % (1 if internal else 0))
+    out.append("constexpr float TEMP_VREF = %s; // Voltaje de esa referencia" % c_float(vref))
+    out.append("")
+    out.append("// Ventanas de tarifa eléctrica (minutos desde la medianoche)")
+    windows = tariff_windows(config)
+    out.append("#define TARIFF_WINDOW_COUNT %d" % len(windows))
+    if windows:
+        out.append("constexpr TariffWindow TARIFF_WINDOWS[TARIFF_WINDOW_COUNT] = {")
+        for start, end, price in windows:
+            out.append("  {%d, %d, %s}," % (start, end, c_float(price)))
+        out.append("};")
+    out.append("")
+    out.append("// Alimentación de la sonda de humedad")
+    probe = probe_power(config)
+    if probe is None:
+        out.append("#define PROBE_POWER_ENABLED 0 // Siempre alimentada")
+    else:
+        settle_ms, period_ms, burst = probe
+        out.append("#define PROBE_POWER_ENABLED 1")
+        out.append("constexpr uint8_t PROBE_POWER_PIN = %d; // %s" % (used["probe_power"], config["probe_power"]["pin"]))
+        out.append("constexpr unsigned long PROBE_SETTLE_MS = %dUL; // Espera desde el encendido hasta leer" % settle_ms)
+        out.append("constexpr unsigned long PROBE_PERIOD_MS = %dUL; // Entre encendidos" % period_ms)
+        out.append("constexpr uint8_t PROBE_BURST = %d; // Lecturas promediadas por encendido" % burst)
+    out.append("")
+    out.append("// Conmutación del relé en el cruce por cero de la red")
+    crossing = zero_cross(config)
+    if crossing is None:
+        out.append("#define ZERO_CROSS_ENABLED 0 // El relé conmuta al recibir la orden")
+    else:
+        half_period_us, delay_us = crossing
+        out.append("#define ZERO_CROSS_ENABLED 1")
+        out.append("constexpr uint8_t ZERO_CROSS_PIN = %d; // %s" % (used["zero_cross"], config["zero_cross"]["pin"]))
+        out.append("#define ZERO_CROSS_VECTOR %s" % pcint_vector(board, used["zero_cross"]))
+        out.append("constexpr unsigned long MAINS_HALF_PERIOD_US = %dUL;" % half_period_us)
+        out.append("constexpr unsigned long RELAY_SWITCH_DELAY_US = %dUL; // Desde el cruce hasta energizar la bobina" % delay_us)
+    out.append("")
+    out.append("// Registro en la tarjeta SD (bloques de 512 bytes sin sistema de archivos)")
+    log = sd_log(config)
+    if log is None:
+        out.append("#define SD_LOG_ENABLED 0")
+    else:
+        start, blocks, interval_ms = log
+        out.append("#define SD_LOG_ENABLED 1")
+        out.append("constexpr uint8_t SD_CS_PIN = %d;" % used["sd_log.cs"])
+        out.append("constexpr uint32_t SD_LOG_START_BLOCK = %dUL; // Primer bloque de la zona del registro" % start)
+        out.append("constexpr uint32_t SD_LOG_BLOCKS = %dUL; // Tamaño de la zona en bloques" % blocks)
+        out.append("constexpr unsigned long SD_LOG_INTERVAL_MS = %dUL;" % interval_ms)
+    out.append("")
+    out.append("// Detector de anomalías de la sonda y del riego")
+    out.append("#define ANOMALY_DETECTION_ENABLED %d" % (1 if anomaly_detection(config) else 0))
+    out.append("")
+    out.append("// Objetivo de latencia entre la lectura de los sensores y la salida del relé")
+    percentile, limit_ms = latency_slo(config)
+    out.append("constexpr uint8_t LATENCY_SLO_PERCENTILE = %d;" % percentile)
+    out.append("constexpr unsigned long LATENCY_SLO_US = %dUL; // %s ms" % (round(limit_ms * 1000), limit_ms))
+    out.append("")
+    out.append("// ========= CULTIVOS =========")
+    out.append("constexpr uint8_t CROP_COUNT = %d;" % len(crops))
+    out.append("constexpr CropProfile CROP_PROFILES[CROP_COUNT] = {")
+    for crop in crops:
+        out.append("  {%s, %s, %s, %s, %s}," % (
+            c_string(crop["name"]), c_float(crop["min_temp"]), c_float(crop["max_temp"]),
+            c_float(crop["min_humidity"]), c_float(crop["max_humidity"])))
+    out.append("};")
+    out.append("")
+    out.append("// Umbrales de cada cultivo como constantes de compilación (índice desde 1, como en el menú)")
+    out.append("template <uint8_t Index> struct CropTraits;")
+    for index, crop in enumerate(crops):
+        out.append("template <> struct CropTraits<%d> { // %s" % (index + 1, c_string(crop["name"])))
+        out.append("  static constexpr float minTemp = %s;" % c_float(crop["min_temp"]))
+        out.append("  static constexpr float maxTemp = %s;" % c_float(crop["max_temp"]))
+        out.append("  static constexpr float minHumidity = %s;" % c_float(crop["min_humidity"]))
+        out.append("  static constexpr float maxHumidity = %s;" % c_float(crop["max_humidity"]))
+        out.append("};")
+    fixed = fixed_crop_index(config)
+    if fixed is not None:
+        out.append("")
+        out.append("// Firmware especializado para un solo cultivo: %s" % c_string(crops[fixed - 1]["name"]))
+        out.append("#define FIXED_CROP_INDEX %d" % fixed)
+        out.append("typedef CropTraits<FIXED_CROP_INDEX> FixedCrop;")
+    out.append("")
+    for index in range(len(crops)):
+        out.append("static_assert(CROP_PROFILES[%d].minTemp <= CROP_PROFILES[%d].maxTemp && "
+                   "CROP_PROFILES[%d].minHumidity <= CROP_PROFILES[%d].maxHumidity, \"Rango de cultivo invalido\");"
+                   % (index, index, index, index))
+    out.append("")
+    out.append("#endif")
+    return "\n".join(out) + "\n"
+
+
+def generate(config_path, output_path, flags=()):
+    with open(config_path, encoding="utf-8") as handle:
+        config = json.load(handle)
+
+    board_name = config.get("board", "uno")
+    if board_name not in BOARDS:
+        raise ConfigError("placa desconocida: %s" % board_name)
+    board = BOARDS[board_name]
+
+    defines = build_defines(flags)
+    sram = validate(board, config, defines)
+    text = render(config, board, os.path.basename(config_path), sram, defines)
+
+    # Solo se reescribe si cambia, para no recompilar todo en cada build
+    if os.path.exists(output_path):
+        with open(output_path, encoding="utf-8") as handle:
+            if handle.read() == text:
+                return
+    os.makedirs(os.path.dirname(output_path) or ".", exist_ok=True)
+    with open(output_path, "w", encoding="utf-8") as handle:
+        handle.write(text)
+
+
+def run_from_platformio(env):
+    project_dir = env.subst("$PROJECT_DIR")
+    config_path = os.path.join(project_dir, env.GetProjectOption("custom_board_config", "config/board.json"))
+    output_dir = os.path.join(env.subst("$BUILD_DIR"), "generated")
+    try:
+        # Las build_flags del entorno dicen qué buffers opcionales entran en la SRAM
+        generate(config_path, os.path.join(output_dir, "board_config.h"), env.get("BUILD_FLAGS", []))
+    except ConfigError as error:
+        sys.stderr.write("Error en %s: %s\n" % (config_path, error))
+        env.Exit(1)
+    env.Append(CPPPATH=[output_dir])
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit("uso: gen_config.py <config.json> <board_config.h> [-DENABLE_PROFILER ...]")
+    try:
+        generate(sys.argv[1], sys.argv[2], sys.argv[3:])
+    except ConfigError as error:
+        sys.exit("Error en %s: %s" % (sys.argv[1], error))
+
+
+if "Import" in globals():
+    # Ejecución como extra_script: SCons define Import y el entorno de construcción
+    Import("env")  # noqa: F821
+    run_from_platformio(env)  # noqa: F821
+elif __name__ == "__main__":
+    main()
@@ -0,0 +1,65 @@
+// Comparación del controlador en tiempo de ejecución contra el especializado al compilar
+// Se compila con: pio run -e uno_bench -t upload && pio device monitor
+// Pensado para una placa sin la pantalla conectada, porque usa el puerto serie.
+
+#include <Arduino.h>
+
+#include "board_config.h"
+#include "controller.h"
+
+const unsigned int ITERATIONS = 2000; // Llamadas por medición
+const byte SAMPLE_COUNT = 8;          // Lecturas distintas para no favorecer a la predicción de saltos
+
+// Lecturas de prueba que cubren todas las ramas de la regla
+volatile float sampleTemps[SAMPLE_COUNT] = {10.0, 15.0, 18.5, 22.0, 24.0, 30.0, 17.0, 21.0};
+volatile float sampleHums[SAMPLE_COUNT] = {20.0, 45.0, 55.0, 65.0, 85.0, 30.0, 75.0, 40.0};
+
+// Cultivo elegido en tiempo de ejecución, como el del menú: al leer el índice de una
+// variable volatile el compilador no puede plegar sus umbrales aunque use -flto
+volatile byte runtimeCropIndex = 0;
+
+volatile byte sink; // Evita que se eliminen las llamadas
+
+// Ciclos de reloj por llamada, descontando el costo del bucle y de leer las muestras
+template <typename Rule>
+unsigned long measureCycles(Rule rule)
+{
+  unsigned long start = micros();
+  for (unsigned int i = 0; i < ITERATIONS; i++)
+  {
+    byte index = i % SAMPLE_COUNT;
+    sink = rule(sampleTemps[index], sampleHums[index]);
+  }
+  unsigned long elapsed = micros() - start;
+
+  start = micros();
+  for (unsigned int i = 0; i < ITERATIONS; i++)
+  {
+    byte index = i % SAMPLE_COUNT;
+    sink = sampleTemps[index] > sampleHums[index];
+  }
+  unsigned long overhead = micros() - start;
+
+  unsigned long cyclesPerMicro = F_CPU / 1000000UL;
+  return elapsed > overhead ? (elapsed - overhead) * cyclesPerMicro / ITERATIONS : 0;
+}
+
+void setup()
+{
+  Serial.begin(SERIAL_BAUD);
+}
+
+void loop()
+{
+  unsigned long runtimeCycles = measureCycles([](float tmp, float hum) { return irrigationNeeded(CROP_PROFILES[runtimeCropIndex], tmp, hum); });
+  unsigned long fixedCycles = measureCycles([](float tmp, float hum) { return fixedIrrigationNeeded<CropTraits<1> >(tmp, hum); });
+
+  Serial.print(CROP_PROFILES[0].name);
+  Serial.print(": tiempo de ejecucion ");
+  Serial.print(runtimeCycles);
+  Serial.print(" ciclos, constante ");
+  Serial.print(fixedCycles);
+  Serial.println(" ciclos por llamada");
+
+  delay(DELAY_LONG_MS);
+}
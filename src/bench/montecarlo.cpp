@@ -0,0 +1,127 @@
+// Análisis de Monte Carlo de los cultivos y las políticas de riego en el computador
+// Se compila con: pio run -e native_montecarlo && .pio/build/native_montecarlo/program
+//
+// Sortea las realizaciones y simula cada candidato sobre todas (lib/SoilSim/src/montecarlo.h),
+// y muestra la distribución del uso de la bomba y del tiempo fuera del rango del cultivo.
+//
+// Variables de entorno:
+// - HOST_MC_RUNS: realizaciones por candidato (por defecto 1000)
+// - HOST_MC_DAYS: días simulados por realización (por defecto 7)
+// - HOST_MC_THREADS: hilos (por defecto los procesadores disponibles)
+// - HOST_MC_SEED: semilla (por defecto 1)
+// - HOST_MC_CSV: archivo donde se guarda el resultado de cada realización
+// - HOST_SIM_SOIL: suelo de referencia (archivo de tools/soil_fit.py)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "montecarlo.h"
+
+namespace {
+
+unsigned long envUnsigned(const char* name, unsigned long fallback)
+{
+  const char* value = getenv(name);
+  return value != nullptr ? strtoul(value, nullptr, 10) : fallback;
+}
+
+float percentile(std::vector<float> values, float fraction)
+{
+  std::sort(values.begin(), values.end());
+  size_t index = (size_t)(fraction * (values.size() - 1) + 0.5f);
+  return values[index];
+}
+
+float mean(const std::vector<float>& values)
+{
+  double total = 0;
+  for (float value : values)
+    total += value;
+  return total / values.size();
+}
+
+void printDistribution(const char* label, const std::vector<float>& values)
+{
+  printf("  %-16s media %8.2f  p5 %8.2f  p50 %8.2f  p95 %8.2f\n", label, mean(values), percentile(values, 0.05f),
+         percentile(values, 0.5f), percentile(values, 0.95f));
+}
+
+} // namespace
+
+int main()
+{
+  unsigned runs = envUnsigned("HOST_MC_RUNS", 1000);
+  unsigned days = envUnsigned("HOST_MC_DAYS", 7);
+  unsigned threads = envUnsigned("HOST_MC_THREADS", std::thread::hardware_concurrency());
+  uint64_t seed = envUnsigned("HOST_MC_SEED", 1);
+  if (runs == 0 || days == 0 || days > MAX_DAYS)
+  {
+    fprintf(stderr, "montecarlo: HOST_MC_RUNS debe ser mayor que 0 y HOST_MC_DAYS estar entre 1 y %u\n", MAX_DAYS);
+    return 1;
+  }
+  if (threads == 0)
+    threads = 1;
+
+  SoilParams reference;
+  const char* soil = getenv("HOST_SIM_SOIL");
+  if (soil != nullptr && soil[0] != '\0')
+    loadSoilParams(soil, reference);
+
+  std::vector<Candidate> candidates = allCandidates();
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<Outcome> results = runAll(candidates, runs, days, threads, seed, reference);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("Monte Carlo: %u realizaciones de %u días, semilla %llu, %u hilos, %.1f s (%.0f días de zona por segundo)\n", runs, days,
+         (unsigned long long)seed, threads, seconds, runs * days * candidates.size() / seconds);
+  for (size_t c = 0; c < candidates.size(); c++)
+  {
+    std::vector<float> pump, below, above, cost;
+    for (unsigned run = 0; run < runs; run++)
+    {
+      const Outcome& outcome = results[run * candidates.size() + c];
+      pump.push_back(outcome.pumpMinutesPerDay);
+      below.push_back(outcome.belowPercent);
+      above.push_back(outcome.abovePercent);
+      cost.push_back(outcome.costPerDay);
+    }
+    const CropProfile& crop = CROP_PROFILES[candidates[c].crop];
+    printf("%s (%.0f-%.0f %%), %s:\n", crop.name, crop.minHumidity, crop.maxHumidity,
+           candidates[c].tariff ? "planificador por tarifa" : "regla del cultivo");
+    printDistribution("bomba min/día", pump);
+    printDistribution("% debajo", below);
+    printDistribution("% encima", above);
+    if (TARIFF_WINDOW_COUNT > 0)
+      printDistribution("costo/día (1 kW)", cost);
+  }
+
+  const char* csvPath = getenv("HOST_MC_CSV");
+  if (csvPath != nullptr && csvPath[0] != '\0')
+  {
+    FILE* csv = fopen(csvPath, "w");
+    if (csv == nullptr)
+    {
+      fprintf(stderr, "montecarlo: no se pudo crear %s\n", csvPath);
+      return 1;
+    }
+    fprintf(csv, "realizacion,cultivo,tarifa,bomba_min_dia,pct_debajo,pct_encima,costo_dia\n");
+    for (unsigned run = 0; run < runs; run++)
+    {
+      for (size_t c = 0; c < candidates.size(); c++)
+      {
+        const Outcome& outcome = results[run * candidates.size() + c];
+        fprintf(csv, "%u,%s,%d,%.3f,%.3f,%.3f,%.5f\n", run, CROP_PROFILES[candidates[c].crop].name, candidates[c].tariff,
+                outcome.pumpMinutesPerDay, outcome.belowPercent, outcome.abovePercent, outcome.costPerDay);
+      }
+    }
+    fclose(csv);
+  }
+  return 0;
+}
@@ -0,0 +1,81 @@
+// Costo de la compresión de la telemetría en la placa: ciclos por byte sin comprimir y
+// relación de compresión con lecturas que cambian lentamente, como las del suelo
+// Se compila con: pio run -e uno_bench_telemetry -t upload && pio device monitor
+// Pensado para una placa sin la pantalla conectada, porque usa el puerto serie.
+
+#include <Arduino.h>
+
+#include "board_config.h"
+#include "telemetry.h"
+
+const byte RECORD_COUNT = 32;        // Registros de prueba (320 bytes de SRAM)
+const unsigned int ITERATIONS = 64;  // Pasadas por medición
+
+uint16_t records[RECORD_COUNT][TELEMETRY_FIELDS];
+uint8_t payload[TELEMETRY_FRAME_BYTES];
+
+// Caminata aleatoria: ruido de +-1 cuenta en la humedad, temperatura casi fija y
+// tiempo que avanza 12 lecturas del ADC por ciclo con algo de variación
+void fillRecords()
+{
+  uint16_t state = 0xACE1;
+  uint16_t time = 0;
+  uint16_t temperature = 600;
+  uint16_t humidity = 450;
+  for (byte i = 0; i < RECORD_COUNT; i++)
+  {
+    state ^= state << 7;
+    state ^= state >> 9;
+    state ^= state << 8;
+    time += 12 + ((state & 0x0F) == 0 ? 1 : 0);
+    humidity += (state >> 4) % 3 - 1;
+    if ((state >> 8 & 0x1F) == 0)
+      temperature++;
+    records[i][TELEMETRY_TIME] = time;
+    records[i][TELEMETRY_TEMPERATURE] = temperature;
+    records[i][TELEMETRY_HUMIDITY] = humidity;
+    records[i][TELEMETRY_STATUS] = 1 << 2;
+    records[i][TELEMETRY_RELAY] = 0;
+  }
+}
+
+void setup()
+{
+  Serial.begin(SERIAL_BAUD);
+  fillRecords();
+}
+
+void loop()
+{
+  TelemetryEncoder encoder(payload, TELEMETRY_FRAME_BYTES);
+  unsigned long outputBytes = 0;
+
+  unsigned long start = micros();
+  for (unsigned int pass = 0; pass < ITERATIONS; pass++)
+  {
+    for (byte i = 0; i < RECORD_COUNT; i++)
+    {
+      if (!encoder.push(records[i]))
+      {
+        encoder.finish();
+        outputBytes += encoder.size();
+        encoder.clear();
+        encoder.push(records[i]);
+      }
+    }
+  }
+  unsigned long elapsed = micros() - start;
+  encoder.finish();
+  outputBytes += encoder.size();
+
+  unsigned long inputBytes = (unsigned long)ITERATIONS * RECORD_COUNT * TELEMETRY_FIELDS * 2;
+  unsigned long cyclesPerMicro = F_CPU / 1000000UL;
+
+  Serial.print("Compresion ");
+  Serial.print((float)inputBytes / outputBytes);
+  Serial.print(":1, ");
+  Serial.print((float)elapsed * cyclesPerMicro / inputBytes);
+  Serial.println(" ciclos por byte");
+
+  delay(DELAY_LONG_MS);
+}
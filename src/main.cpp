@@ -8,38 +8,40 @@
 #include <Keypad.h> // Librería para el teclado matricial
 
 // ========= CONFIGURACIÓN DE HARDWARE =========
-// Definición de pines y parámetros del sistema
-
-// Pines analógicos para sensores
-#define TMP_SENSOR A0 // Pin del sensor de temperatura (TMP36)
-#define HUM_SENSOR A1 // Pin del sensor de humedad del suelo (YL-69)
-
-// Pines digitales para actuadores
-#define IRRIGATION_MOTOR A2 // Pin para controlar el motor/rele de riego
-#define DELAY_150_MS 150   // Delay de 150 ms para respuesta del teclado
-#define DELAY_1_SEG 1000   // Delay estándar de 1 segundo (en ms)
-#define DELAY_2_SEG 2000   // Delay largo de 2 segundos (en ms)
-
-#define TEMP_CALIBRATION_OFFSET -50 // Ajuste de calibración para el sensor TMP36
-#define ADC_MAX_VALUE 1023 // Valor máximo del ADC
-#define VCC 5.0 // Voltaje de alimentación
-
-// Configuración del teclado matricial 4x4
-#define ROWS 4 // Número de filas del teclado
-#define COLS 4 // Número de columnas del teclado
+// Pines, tiempos de espera, calibración y cultivos se definen en config/board.json
+// y scripts/gen_config.py los convierte en constantes al compilar
+#include "board_config.h"
+#include "controller.h" // Regla de activación del riego
+#include "moisture_forecaster.h" // Pronóstico de la humedad de la zona
+#include "pump_scheduler.h" // Riego en las ventanas de tarifa más baratas
+#include "latency_monitor.h" // Latencia entre la lectura de los sensores y el relé
+#include "anomaly_detector.h" // Sonda atascada, fugas y secado anormal
+#include "sensor_sampler.h" // Lectura de los sensores por interrupciones
+#include "relay_switch.h" // Relé sincronizado con el cruce por cero de la red
+#include "sd_log.h" // Registro de lecturas en la tarjeta SD
+#include "profiler.h" // Perfilador por muestreo (solo en el entorno uno_profile)
+#include "trace.h" // Trazas de tareas para Chrome/Perfetto (solo en el entorno uno_trace)
+#include "telemetry.h" // Telemetría comprimida por el puerto serie (solo en el entorno uno_telemetry)
 
 // Estructura para almacenar los datos del sensor
 // Contiene:
 // - temperature: Valor en °C leído del sensor TMP36
 // - humidity: Porcentaje de humedad leído del sensor YL-69
-// - update(): Método para actualizar los valores de los sensores
+// - rawHumidity: Lectura cruda de la humedad, para reconocer una sonda atascada
+// - sampleMicros: Instante de la conversión del ADC, para medir la latencia hasta el relé
+// - update(): Método para actualizar los valores con la última lectura de las interrupciones
 struct SensorData {
   float temperature;
   float humidity;
+  uint16_t rawHumidity;
+  unsigned long sampleMicros;
   
   void update() {
-      temperature = ((analogRead(TMP_SENSOR) * VCC / ADC_MAX_VALUE) * 100.0) + TEMP_CALIBRATION_OFFSET;
-      humidity = (analogRead(HUM_SENSOR) * VCC / ADC_MAX_VALUE) * 100.0;
+      SensorSnapshot reading = sensorSnapshot();
+      temperature = ((reading.rawTemperature * TEMP_VREF / ADC_MAX_VALUE) * 100.0) + TEMP_CALIBRATION_OFFSET;
+      humidity = (reading.rawHumidity * VCC / ADC_MAX_VALUE) * 100.0;
+      rawHumidity = reading.rawHumidity;
+      sampleMicros = reading.sampleMicros;
   }
 };
 
@@ -74,43 +76,57 @@ struct CropParameters {
 
 CropParameters cropParameters; // Variable para almacenar los parámetros del cultivo
 
-// Struct clave valor de los cultivos
+// Se obtiene el tamaño de la lista de cultivos de la configuración
+byte sizeCropList = CROP_COUNT;
 
-struct keyValue {
-  String crop;
-  byte structIndex;
-};
+// Percentiles de la latencia del control y alarma cuando no se cumple el objetivo
+LatencyMonitor latencyMonitor(LATENCY_SLO_PERCENTILE, LATENCY_SLO_US);
 
-// Se comporta como un diccionario clave valor, donde la clave es el nombre del cultivo y el valor es el indice del cultivo
-keyValue cropList [] = {
-  {"Cilantro", 0},
-  {"Fresa", 1},
-  // {"Arroz", 2}, // Descomentando estas líneas se puede agregar más cultivos
-  // {"Tomate", 3},
-  // {"Zanahoria", 4}
-};
+// Lecturas de los sensores fuera de rango desde el inicio (sensor desconectado o dañado)
+uint16_t sensorFaults = 0;
+
+#if ANOMALY_DETECTION_ENABLED
+// Anomalías de la sonda y del riego que se ven en las lecturas
+AnomalyDetector anomalyDetector(ADC_MAX_VALUE);
+#endif
+
+// Modelo de secado de la zona, ajustado con sus lecturas y el uso de la bomba
+MoistureForecaster moistureForecaster;
+
+#if TARIFF_WINDOW_COUNT > 0
+// Planificador de riego por tarifa y reloj del día: la placa no tiene reloj, así que
+// se ingresa la hora al iniciar y se avanza de a un minuto con millis()
+PumpScheduler pumpScheduler(TARIFF_WINDOWS, TARIFF_WINDOW_COUNT, moistureForecaster);
+uint16_t clockMinute = 0;        // Minuto del día (0-1439)
+unsigned long clockMinuteMs = 0; // millis() en que empezó clockMinute
+#endif
 
-// Se obtiene el tamaño de la lista de cultivos dividiendo el tamaño total del array cropList entre el tamaño del struct keyValue
-byte sizeCropList = sizeof(cropList) / sizeof(cropList[0]);
+#if SD_LOG_ENABLED
+// Guarda una lectura en la tarjeta SD cada SD_LOG_INTERVAL_MS
+void logReading();
+#endif
+
+#if TELEMETRY_ENABLED
+// Agrega la lectura del ciclo a la telemetría comprimida
+void recordTelemetry();
+
+// Envía el resumen del estado del firmware cada TELEMETRY_STATS_INTERVAL_MS
+void sendTelemetryStats();
+#endif
 
 // FIN ASIGNACIÓN DE VARIABLES
 
 // Asignación de pines de la pantalla lcd
               // RS E DB4 DB5 DB6 DB7 
-LiquidCrystal lcd(0, 1, 2, 3, 4, 5);
+LiquidCrystal lcd(LCD_RS, LCD_ENABLE, LCD_D4, LCD_D5, LCD_D6, LCD_D7);
 
 // Configuración del teclado matricial
-// Matriz de teclas
-const char keys[ROWS][COLS] = {
-  {'1', '2', '3', 'A'},
-  {'4', '5', '6', 'B'},
-  {'7', '8', '9', 'C'},
-  {'*', '0', '#', 'D'}
-};
+// Matriz de teclas (4x4 o 4x3 según la configuración)
+const char keys[ROWS][COLS] = KEYPAD_KEYMAP;
 
 // Pines de las filas y columnas
-byte rowPins[ROWS] = {13, 12, 11, 10}; 
-byte colPins[COLS] = {9, 8, 7, 6}; 
+byte rowPins[ROWS] = KEYPAD_ROW_PINS;
+byte colPins[COLS] = KEYPAD_COL_PINS;
 
 // Creación del teclado matricial
 Keypad key = Keypad(makeKeymap(keys), rowPins, colPins, ROWS, COLS);
@@ -125,21 +141,48 @@ void selectCrop();
 void addCropParameters(byte);
 float readTemperature();
 float readHumidity();
+uint8_t activeAnomalies();
+char anomalyLetter(uint8_t);
 void printData();
 bool receiveRange(float, float);
 void controlIrrigation(bool);
+void askCurrentTime();
+uint16_t minuteOfDay();
 
 // ======== CONFIGURACIÓN INICIAL ========
 void setup() {
 
+  // Empieza a muestrear el contador de programa si el perfilador está habilitado
+  profilerBegin();
+  traceBegin();
+  telemetryBegin();
+
   // Configuración de pines
   pinMode(TMP_SENSOR, INPUT); // Configuración del pin del sensor de temperatura como entrada
   pinMode(HUM_SENSOR, INPUT); // Configuración del pin del sensor de humedad como entrada
-  pinMode(IRRIGATION_MOTOR, OUTPUT); // Configuración del pin del motor de riego como salida
+  relayBegin(); // Configuración del pin del motor de riego como salida (y del detector de cruce por cero)
+
+  // Desde aquí el ADC lo manejan las interrupciones; no se usa analogRead()
+  sensorSamplerBegin();
+
+  // Busca en la tarjeta SD dónde seguir el registro (sin tarjeta no se registra)
+  SdLogStatus sdLog = sdLogBegin();
 
   // Llamada a la función initLCD
   initLCD();
 
+  // Con la zona sobre una partición el registro no arranca, para no borrar sus archivos
+  if (sdLog == SD_LOG_PARTITION)
+  {
+    showSelectionMessage("SD: zona sobre", "una particion");
+    delay(DELAY_LONG_MS);
+  }
+
+#ifdef FIXED_CROP_INDEX
+  // Firmware especializado para un solo cultivo: no se muestra el menú
+  systemState.selectedCrop = FIXED_CROP_INDEX;
+  processCropSelection(systemState.selectedCrop);
+#else
   // Se pregunta al usuario por el cultivo a regar mostrando un menú
   showMenu();
 
@@ -151,27 +194,73 @@ void setup() {
     selectCrop();
 
   } while (systemState.cropValid == false);
+#endif
 
   // Enviamos el parámetro seleccionado por el usuario
   addCropParameters(systemState.selectedCrop);
 
+#if TARIFF_WINDOW_COUNT > 0
+  // Con tarifas configuradas se necesita la hora para saber en qué ventana estamos
+  askCurrentTime();
+#endif
+
 }
 
 // ======== BUCLE PRINCIPAL ========
 void loop() {
 
+  profilerService(); // Envía el histograma del perfilador cuando corresponde
+
+  TRACE_BEGIN(TRACE_SENSE);
   systemState.sensorReadings.update(); // Se actualizan los datos del sensor
 
+#if ANOMALY_DETECTION_ENABLED
+  // Se revisan las lecturas con el estado de la bomba del ciclo anterior
+  anomalyDetector.update(systemState.sensorReadings.rawHumidity, systemState.sensorReadings.humidity,
+                         systemState.sensorReadings.temperature, systemState.motorActive, millis());
+#endif
+  moistureForecaster.observe(systemState.sensorReadings.humidity, systemState.sensorReadings.temperature,
+                             systemState.motorActive, millis());
+  TRACE_END(TRACE_SENSE);
+
+  TRACE_BEGIN(TRACE_CONTROL);
+
   // Se recibe el rango de la temperatura y la humedad, si es true se enciende el motor de riego de lo contrario se apaga
-  systemState.motorActive = receiveRange(systemState.sensorReadings.temperature, systemState.sensorReadings.humidity);
+  bool cropNeedsWater = receiveRange(systemState.sensorReadings.temperature, systemState.sensorReadings.humidity);
+
+#if TARIFF_WINDOW_COUNT > 0
+  // Si la humedad lo permite, el riego se pospone hasta una ventana de tarifa más barata
+  systemState.motorActive = pumpScheduler.shouldRun(cropNeedsWater, systemState.sensorReadings.humidity, systemState.sensorReadings.temperature,
+                                                    cropParameters.minHumidity, minuteOfDay());
+#else
+  systemState.motorActive = cropNeedsWater;
+#endif
+  TRACE_END(TRACE_CONTROL);
 
   // Impresión de los datos leídos en la pantalla lcd
   printData();
 
   // Se activa el motor de riego si se cumple la condición de la función receiveRange
+  TRACE_BEGIN(TRACE_CONTROL);
   controlIrrigation(systemState.motorActive);
+  TRACE_END(TRACE_CONTROL);
 
-  delay(DELAY_1_SEG); // Delay de 1 segundo antes de hacer la siguiente lectura
+#if SD_LOG_ENABLED
+  logReading();
+#endif
+  sdLogService(); // Escribe en la tarjeta sin esperar a que termine de grabar
+
+#if TELEMETRY_ENABLED
+  recordTelemetry();
+  sendTelemetryStats();
+#endif
+  telemetryFlush(); // Envía la telemetría sin bloquear cuando corresponde
+
+  traceFlush(); // Envía las trazas pendientes sin bloquear
+
+  TRACE_BEGIN(TRACE_DELAY);
+  delay(DELAY_STANDARD_MS); // Espera antes de hacer la siguiente lectura
+  TRACE_END(TRACE_DELAY);
 }
 
 // ======== FUNCIONES DE HARDWARE ========
@@ -180,22 +269,26 @@ void initLCD()
 {
   lcd.begin(16, 2);
   showSelectionMessage("Sistema de riego");
-  delay(DELAY_2_SEG);
+  delay(DELAY_LONG_MS);
   lcd.clear();
   showSelectionMessage("Iniciando...");
-  delay(DELAY_2_SEG);
+  delay(DELAY_LONG_MS);
   lcd.clear();
 }
 
 void showSelectionMessage(String message1, String message2, byte row1, byte row2)
 {
+  TRACE_BEGIN(TRACE_DISPLAY);
   lcd.clear();
   lcd.setCursor(0, row1);
   lcd.print(message1);
   lcd.setCursor(0, row2);
   lcd.print(message2);
+  TRACE_END(TRACE_DISPLAY);
 
-  delay(DELAY_150_MS);
+  TRACE_BEGIN(TRACE_DELAY);
+  delay(DELAY_KEYPAD_MS);
+  TRACE_END(TRACE_DELAY);
 }
 
 // ======== FUNCIONES DE LÓGICA ========
@@ -203,12 +296,12 @@ void showSelectionMessage(String message1, String message2, byte row1, byte row2
 void showMenu() {
 
   showSelectionMessage("Seleccione un", "cultivo");
-  delay(DELAY_2_SEG);
+  delay(DELAY_LONG_MS);
 
   for (byte i = 0; i < sizeCropList; i++) {
 
-    showSelectionMessage("Cultivo " + String(cropList[i].structIndex + 1), cropList[i].crop); // Se suma 1 para que el indice se muestre en 1 en lugar de 0
-    delay(DELAY_2_SEG);
+    showSelectionMessage("Cultivo " + String(i + 1), CROP_PROFILES[i].name); // Se suma 1 para que el indice se muestre en 1 en lugar de 0
+    delay(DELAY_LONG_MS);
     lcd.clear();
   }
 }
@@ -221,13 +314,13 @@ bool isValidCropSelection(byte selection)
 void processCropSelection(byte selection)
 {
     byte index = selection - 1;
-    showSelectionMessage("Ud selecciono: ", cropList[index].crop);
-    delay(DELAY_2_SEG);
+    showSelectionMessage("Ud selecciono: ", CROP_PROFILES[index].name);
+    delay(DELAY_LONG_MS);
 
     lcd.clear();
     
     showSelectionMessage("Cargando...");
-    delay(DELAY_2_SEG);
+    delay(DELAY_LONG_MS);
     
     lcd.clear();
     systemState.cropValid = true;
@@ -242,7 +335,10 @@ void selectCrop()
   {
   // Se muestra un mensaje en la pantalla
     showSelectionMessage("Seleccione un", "cultivo valido");
+    TRACE_BEGIN(TRACE_KEYPAD);
     option = key.getKey();
+    TRACE_END(TRACE_KEYPAD);
+    traceFlush();
     systemState.selectedCrop = (option - '0'); // Se resta el valor ASCII de '0' para obtener el valor numérico de la tecla presionada
     if (option != NO_KEY)
     {
@@ -263,72 +359,135 @@ void selectCrop()
       else
       {
         showSelectionMessage("Selecc invalida");
-        delay(DELAY_2_SEG);
+        delay(DELAY_LONG_MS);
       }
-      delay(DELAY_150_MS);
+      delay(DELAY_KEYPAD_MS);
     }
   }
 }
 
 // Agrega los parámetros del cultivo seleccionado
+// Los cultivos se agregan o eliminan en config/board.json
 
 void addCropParameters(byte option) {
-  switch (option) {
-    case 1: // Cilantro
-    cropParameters.minTemp = 15.0;
-    cropParameters.maxTemp = 24.0;
-    cropParameters.minHumidity = 40.0;
-    cropParameters.maxHumidity = 50.0;
-    break;
-
-    case 2: // Fresa
-    cropParameters.minTemp = 15.0;
-    cropParameters.maxTemp = 20.0;
-    cropParameters.minHumidity = 60.0;
-    cropParameters.maxHumidity = 80.0;
-    break;
-
-    // Descomentando estas líneas se pueden agregar más cultivos con sus respectivos parámetros
-    // Debe corresponder con el índice del cropList
-
-    // case 3: // Arroz
-    // cropParameters.minTemp = 10.0;
-    // cropParameters.maxTemp = 25.0;
-    // cropParameters.minHumidity = 10.0;
-    // cropParameters.maxHumidity = 100.0;
-    // break;
-
-    // case 4: // Tomate
-    // cropParameters.minTemp = 10.0;
-    // cropParameters.maxTemp = 25.0;
-    // cropParameters.minHumidity = 10.0;
-    // cropParameters.maxHumidity = 100.0;
-    // break;
-
-    // case 5: // Zanahoria
-    // cropParameters.minTemp = 15.0;
-    // cropParameters.maxTemp = 35.0;
-    // cropParameters.minHumidity = 35.0;
-    // cropParameters.maxHumidity = 100.0;
-    // break;
-
-    default:
-    break;
-  } 
+  if (!isValidCropSelection(option))
+    return;
+
+  const CropProfile& profile = CROP_PROFILES[option - 1];
+  cropParameters.minTemp = profile.minTemp;
+  cropParameters.maxTemp = profile.maxTemp;
+  cropParameters.minHumidity = profile.minHumidity;
+  cropParameters.maxHumidity = profile.maxHumidity;
+#ifdef ARDUINO_HOST
+  hostCropSelected(option); // El suelo simulado mide el tiempo fuera de este rango
+#endif
+}
+
+#if TARIFF_WINDOW_COUNT > 0
+// --- Hora del día ---
+// Pide la hora actual en cuatro dígitos (HH:MM, de 00:00 a 23:59)
+void askCurrentTime()
+{
+  char typed[] = "__:__";
+  const byte positions[4] = {0, 1, 3, 4}; // Lugar de cada dígito en typed
+  byte digits = 0;
+
+  while (digits < 4)
+  {
+    showSelectionMessage("Hora actual", typed);
+    TRACE_BEGIN(TRACE_KEYPAD);
+    char option = key.getKey();
+    TRACE_END(TRACE_KEYPAD);
+    traceFlush();
+
+    if (option >= '0' && option <= '9')
+    {
+      typed[positions[digits]] = option;
+      digits++;
+    }
+
+    // La hora se revisa apenas tiene sus dos dígitos y los minutos al completarse
+    bool badHour = digits >= 2 && (typed[0] - '0') * 10 + (typed[1] - '0') > 23;
+    bool badMinute = digits == 4 && typed[3] > '5';
+    if (badHour || badMinute)
+    {
+      showSelectionMessage("Hora invalida");
+      delay(DELAY_LONG_MS);
+      for (byte i = 0; i < 4; i++)
+        typed[positions[i]] = '_';
+      digits = 0;
+    }
+  }
+
+  clockMinute = ((typed[0] - '0') * 10 + (typed[1] - '0')) * 60 + (typed[3] - '0') * 10 + (typed[4] - '0');
+  clockMinuteMs = millis();
+  lcd.clear();
+}
+
+// Minuto del día desde la hora ingresada: avanza de a un minuto con la diferencia de
+// millis(), que sigue siendo correcta cuando millis() se desborda cada 49 días
+uint16_t minuteOfDay()
+{
+  while (millis() - clockMinuteMs >= 60000UL)
+  {
+    clockMinuteMs += 60000UL;
+    clockMinute = (clockMinute + 1) % MINUTES_PER_DAY;
+  }
+  return clockMinute;
 }
+#endif
 
 // ======== FUNCIONES DE SENSORES ========
 float readTemperature() {
-    return ((analogRead(TMP_SENSOR) * 5.0 / 1023.0) * 100.0) - 50; // Restándole 50 al resultado para coincidir en Tinkercad
+    return ((sensorSnapshot().rawTemperature * TEMP_VREF / ADC_MAX_VALUE) * 100.0) + TEMP_CALIBRATION_OFFSET; // El offset de -50 hace coincidir la lectura en Tinkercad
 }
 
 float readHumidity() {
-    return (analogRead(HUM_SENSOR) * 5.0 / 1023.0) * 100.0;
+    return (sensorSnapshot().rawHumidity * VCC / ADC_MAX_VALUE) * 100.0;
+}
+
+// Anomalías activas (bits de AnomalyDetector), 0 sin el detector en la configuración
+uint8_t activeAnomalies()
+{
+#if ANOMALY_DETECTION_ENABLED
+  return anomalyDetector.active();
+#else
+  return 0;
+#endif
+}
+
+// Letra de la anomalía más importante, 0 si no hay ninguna
+char anomalyLetter(uint8_t anomalies)
+{
+  if (anomalies & AnomalyDetector::STUCK)
+    return 'A';
+  if (anomalies & AnomalyDetector::LEAK)
+    return 'F';
+  if (anomalies & AnomalyDetector::DRIFT)
+    return 'D';
+  if (anomalies & AnomalyDetector::EVAPORATION)
+    return 'E';
+  return 0;
 }
 
 void printData()
 {
-  showSelectionMessage("Temp: " + (String(systemState.sensorReadings.temperature) + " C"), "Humedad: " + (String(systemState.sensorReadings.humidity) + " %"));
+  String temperatureLine = "Temp: " + (String(systemState.sensorReadings.temperature) + " C");
+
+  // Se marca con ! cuando la latencia del control no cumple el objetivo configurado
+  if (latencyMonitor.alarmActive())
+    temperatureLine += " !";
+
+  // Y con una letra cuando hay una anomalía: A sonda atascada, F fuga, D deriva, E evaporación
+  char anomaly = anomalyLetter(activeAnomalies());
+  if (anomaly != 0)
+  {
+    if (!latencyMonitor.alarmActive())
+      temperatureLine += " ";
+    temperatureLine += String(anomaly);
+  }
+
+  showSelectionMessage(temperatureLine, "Humedad: " + (String(systemState.sensorReadings.humidity) + " %"));
 }
 
 // ======== FUNCIONES DE CONTROL ========
@@ -336,33 +495,120 @@ bool receiveRange(float tmp ,float hum)
 {
   if (tmp < -20 || tmp > 100)
   {
+    sensorFaults++;
     showSelectionMessage("Rango de", "temp invalida");
-    delay(DELAY_2_SEG);
+    delay(DELAY_LONG_MS);
     return false; // Valores inválidos de los sensores
   }
 
   if (hum < 0 || hum > 100)
   {
+    sensorFaults++;
     showSelectionMessage("Rango de", "humedad invalida");
-    delay(DELAY_2_SEG);
+    delay(DELAY_LONG_MS);
     return false; // Valores inválidos de los sensores
   }
 
-  if ((tmp >= cropParameters.minTemp && tmp <= cropParameters.maxTemp) && (hum <= cropParameters.minHumidity))
-    return true;
+#ifdef FIXED_CROP_INDEX
+  return fixedIrrigationNeeded<FixedCrop>(tmp, hum); // Umbrales constantes del cultivo fijo
+#else
+  return irrigationNeeded(cropParameters, tmp, hum);
+#endif
+}
 
-  else if ((tmp >= cropParameters.minTemp && tmp <= cropParameters.maxTemp) && (hum <= cropParameters.maxHumidity))
-    return true;
+void controlIrrigation(bool shouldActivateMotor)
+{
+  // El relé conmuta en el próximo cruce por cero si hay detector configurado
+  relayCommand(shouldActivateMotor, systemState.sensorReadings.sampleMicros);
+
+  // Latencia desde la lectura de los sensores hasta que la orden llegó al pin del relé,
+  // con la espera del cruce por cero para las órdenes que quedaron en la cola
+  unsigned long latencyMicros;
+  while (relayNextLatency(latencyMicros))
+    latencyMonitor.record(latencyMicros);
+}
 
-  else
-    return false;
+#if SD_LOG_ENABLED
+// ======== REGISTRO EN LA TARJETA SD ========
+void logReading()
+{
+  static unsigned long lastLogMs = 0;
+  static bool logged = false;
+  if (logged && millis() - lastLogMs < SD_LOG_INTERVAL_MS)
+    return;
+  lastLogMs = millis();
+  logged = true;
+
+  // Se guardan los valores crudos del ADC; tools/sdlog_dump.py los convierte
+  SensorSnapshot snapshot = sensorSnapshot();
+  SdLogReading reading;
+  reading.millis = lastLogMs;
+  reading.rawTemperature = snapshot.rawTemperature;
+  reading.rawHumidity = snapshot.rawHumidity;
+  reading.samples = snapshot.samples;
+  reading.relayOperations = relayWear().operations;
+  reading.motorOn = systemState.motorActive;
+  reading.latencyAlarm = latencyMonitor.alarmActive();
+  reading.crop = systemState.selectedCrop;
+  reading.anomalies = activeAnomalies();
+  sdLogAppend(reading);
 }
+#endif
 
-void controlIrrigation(bool shouldActivateMotor)
+#if TELEMETRY_ENABLED
+// ======== TELEMETRÍA ========
+void recordTelemetry()
 {
-  if (shouldActivateMotor == true)
-    digitalWrite(IRRIGATION_MOTOR, HIGH);
+  SensorSnapshot snapshot = sensorSnapshot();
+  uint16_t values[TELEMETRY_FIELDS];
+  values[TELEMETRY_TIME] = snapshot.samples;
+  values[TELEMETRY_TEMPERATURE] = snapshot.rawTemperature;
+  values[TELEMETRY_HUMIDITY] = snapshot.rawHumidity;
+  values[TELEMETRY_STATUS] = (systemState.motorActive ? 0x01 : 0) | (latencyMonitor.alarmActive() ? 0x02 : 0) | (systemState.selectedCrop << 2);
+  values[TELEMETRY_RELAY] = relayWear().operations;
+  telemetryRecord(values);
+}
+
+void sendTelemetryStats()
+{
+  static unsigned long lastCallMs = 0;
+  static unsigned long lastStatsMs = 0;
+  static bool sent = false;
+
+  unsigned long now = millis();
+  uint16_t loopMillis = now - lastCallMs; // Se llama una vez por ciclo
+  lastCallMs = now;
+  if (sent && now - lastStatsMs < TELEMETRY_STATS_INTERVAL_MS)
+    return;
+
+  RelayWear wear = relayWear();
+  TelemetryStats stats;
+  stats.uptimeSeconds = now / 1000;
+  stats.loopMillis = loopMillis;
+  stats.latencyP50Micros = latencyMonitor.percentileMicros(50);
+  stats.latencyP99Micros = latencyMonitor.percentileMicros(99);
+  stats.latencyMaxMicros = latencyMonitor.maximum();
+  stats.latencyAlarm = latencyMonitor.alarmActive();
+  stats.relayOperations = wear.operations;
+  stats.relaySynchronized = wear.synchronized;
+  stats.relayUnsynchronized = wear.unsynchronized;
+  stats.relayDropped = wear.dropped;
+  stats.sensorFaults = sensorFaults;
+  stats.anomalies = activeAnomalies();
+  stats.dryMinutes = MoistureForecaster::NO_CROSSING;
+  stats.evaporationMilli = 0;
+  if (moistureForecaster.ready())
+  {
+    stats.dryMinutes = moistureForecaster.minutesUntil(systemState.sensorReadings.humidity, cropParameters.minHumidity,
+                                                       systemState.sensorReadings.temperature);
+    stats.evaporationMilli = moistureForecaster.evaporationCoeff() * 1000;
+  }
 
-  else
-    digitalWrite(IRRIGATION_MOTOR, LOW);
-}
\ No newline at end of file
+  // Si no cabe en el buffer de transmisión se reintenta en el próximo ciclo
+  if (telemetrySendStats(stats))
+  {
+    lastStatsMs = now;
+    sent = true;
+  }
+}
+#endif
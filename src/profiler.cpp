@@ -0,0 +1,135 @@
+// Implementación del perfilador por muestreo (solo AVR)
+
+#include "profiler.h"
+
+#if defined(ENABLE_PROFILER) && defined(__AVR__)
+
+#include <Arduino.h>
+#include <avr/interrupt.h>
+
+#include "board_config.h"
+
+#if !SERIAL_ENABLED
+#error "El perfilador envía el histograma por el puerto serie: habilítelo en la configuración (config/board_serial.json)"
+#endif
+
+// Frecuencia de muestreo: 16 MHz / 64 / (OCR1A + 1). Se evita un múltiplo exacto de
+// 1 kHz para no sincronizarse con la interrupción de millis()
+const uint16_t PROFILER_TIMER_TOP = 251; // ~992 Hz
+
+extern "C" {
+// Dirección (en palabras) de la instrucción interrumpida, la escribe el vector en ensamblador
+volatile uint8_t profilerPcLow;
+volatile uint8_t profilerPcHigh;
+
+// Parte en C de la interrupción; termina con reti al ser un manejador de señal
+void __vector_profiler_sample() __attribute__((signal, used, externally_visible));
+
+// Final del código en flash, definido por el script del enlazador
+extern char _etext;
+}
+
+static volatile uint16_t histogram[PROFILER_BUCKETS];
+static volatile uint32_t sampleCount = 0;
+static volatile uint16_t outOfRange = 0;
+static uint8_t bucketShift = 0;
+static unsigned long lastReport = 0;
+
+// Al entrar a la interrupción el contador de programa está en la pila (byte alto en SP+1,
+// bajo en SP+2). Tras guardar 3 registros quedan en SP+4 y SP+5. Ninguna de estas
+// instrucciones modifica SREG, así que no hace falta guardarlo aquí.
+ISR(TIMER1_COMPA_vect, ISR_NAKED)
+{
+  asm volatile(
+      "push r0\n\t"
+      "push r30\n\t"
+      "push r31\n\t"
+      "in r30, __SP_L__\n\t"
+      "in r31, __SP_H__\n\t"
+      "ldd r0, Z+4\n\t"
+      "sts profilerPcHigh, r0\n\t"
+      "ldd r0, Z+5\n\t"
+      "sts profilerPcLow, r0\n\t"
+      "pop r31\n\t"
+      "pop r30\n\t"
+      "pop r0\n\t"
+      "jmp __vector_profiler_sample\n\t");
+}
+
+void __vector_profiler_sample()
+{
+  uint16_t pc = ((uint16_t)profilerPcHigh << 8) | profilerPcLow;
+  uint16_t bucket = pc >> bucketShift;
+
+  if (bucket < PROFILER_BUCKETS)
+  {
+    if (histogram[bucket] != 0xFFFF)
+      histogram[bucket]++;
+  }
+  else if (outOfRange != 0xFFFF)
+  {
+    outOfRange++;
+  }
+  sampleCount++;
+}
+
+void profilerBegin()
+{
+  Serial.begin(SERIAL_BAUD);
+
+  // Casillas del menor tamaño (potencia de 2 en palabras) que cubran todo el código
+  uint16_t codeWords = (uint16_t)(uintptr_t)&_etext / 2;
+  while ((uint16_t)(codeWords >> bucketShift) >= PROFILER_BUCKETS)
+    bucketShift++;
+
+  cli();
+  TCCR1A = 0;
+  TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10); // CTC, prescaler 64
+  TCNT1 = 0;
+  OCR1A = PROFILER_TIMER_TOP;
+  TIMSK1 = _BV(OCIE1A);
+  sei();
+
+  lastReport = millis();
+}
+
+void profilerService()
+{
+  if (millis() - lastReport < PROFILER_REPORT_MS)
+    return;
+  lastReport = millis();
+
+  // Se detiene el muestreo mientras se copia el histograma para que el envío no se mida a sí mismo
+  TIMSK1 &= ~_BV(OCIE1A);
+  uint32_t samples = sampleCount;
+  uint16_t lost = outOfRange;
+
+  uint8_t checksum = 0;
+  Serial.write(FRAME_SYNC_1);
+  Serial.write(FRAME_SYNC_2);
+
+  uint8_t header[9] = {PROFILER_TAG, bucketShift, PROFILER_BUCKETS,
+                       (uint8_t)samples, (uint8_t)(samples >> 8), (uint8_t)(samples >> 16), (uint8_t)(samples >> 24),
+                       (uint8_t)lost, (uint8_t)(lost >> 8)};
+  for (uint8_t i = 0; i < sizeof(header); i++)
+  {
+    Serial.write(header[i]);
+    checksum += header[i];
+  }
+
+  for (uint8_t i = 0; i < PROFILER_BUCKETS; i++)
+  {
+    uint16_t count = histogram[i];
+    histogram[i] = 0;
+    Serial.write((uint8_t)count);
+    Serial.write((uint8_t)(count >> 8));
+    checksum += (uint8_t)count + (uint8_t)(count >> 8);
+  }
+  Serial.write(checksum);
+
+  sampleCount = 0;
+  outOfRange = 0;
+  TIMSK1 |= _BV(OCIE1A);
+}
+
+#endif
@@ -0,0 +1,260 @@
+// Implementación de la salida del relé sincronizada con la red
+
+#include "relay_switch.h"
+
+#include <Arduino.h>
+
+#ifdef __AVR__
+#include <avr/interrupt.h>
+#endif
+
+#include "board_config.h"
+#include "seqlock.h"
+
+static SeqLock<RelayWear> wear;
+static RelayWear counters = {0, 0, 0, 0}; // Copia de trabajo; solo la cambia quien aplica una orden
+static bool outputOn = false;
+
+// Latencias de las órdenes aplicadas: apply() escribe en latencyHead y loop() avanza latencyTail
+static volatile unsigned long latencies[RELAY_LATENCY_SLOTS];
+static volatile uint8_t latencyHead = 0;
+static volatile uint8_t latencyTail = 0;
+
+// Aplica una orden al pin, guarda su latencia y cuenta la conmutación
+// Se llama desde las interrupciones o desde loop() con las interrupciones deshabilitadas
+static void apply(bool on, bool synchronized, unsigned long sampleMicros)
+{
+  digitalWrite(IRRIGATION_MOTOR, on ? HIGH : LOW);
+  if ((uint8_t)(latencyHead - latencyTail) < RELAY_LATENCY_SLOTS)
+  {
+    latencies[latencyHead % RELAY_LATENCY_SLOTS] = micros() - sampleMicros;
+    latencyHead = latencyHead + 1;
+  }
+  if (on == outputOn)
+    return;
+
+  outputOn = on;
+  counters.operations++;
+  if (synchronized)
+    counters.synchronized++;
+  else
+    counters.unsynchronized++;
+  wear.write(counters);
+}
+
+#if ZERO_CROSS_ENABLED
+
+// Cola de órdenes: loop() escribe en queueHead y la interrupción avanza queueTail
+static volatile uint8_t commands[RELAY_QUEUE_SIZE];
+static volatile unsigned long sampleTimes[RELAY_QUEUE_SIZE]; // Instante de la lectura de cada orden
+static volatile uint8_t queueHead = 0;
+static volatile uint8_t queueTail = 0;
+static bool lastQueued = false; // Estado del relé después de aplicar toda la cola
+
+static volatile unsigned long lastCrossingMs = 0; // millis() del último cruce; lo escribe la interrupción
+
+static void applyNext(bool synchronized)
+{
+  if (queueHead == queueTail)
+    return;
+  uint8_t slot = queueTail % RELAY_QUEUE_SIZE;
+  queueTail = queueTail + 1;
+  apply(commands[slot], synchronized, sampleTimes[slot]);
+}
+
+// Sin cruces durante ZERO_CROSS_TIMEOUT_MS el detector no funciona
+// Se llama con las interrupciones deshabilitadas, porque lastCrossingMs ocupa 4 bytes
+static bool detectorTimedOut()
+{
+  return millis() - lastCrossingMs > ZERO_CROSS_TIMEOUT_MS;
+}
+
+// Aplica toda la cola sin esperar un cruce
+static void applyUnsynchronized()
+{
+  while (queueHead != queueTail)
+    applyNext(false);
+}
+
+static void stopSwitchTimer();
+static void watchDetector();
+static void onZeroCross();
+
+#ifdef __AVR__
+
+// Timer2 con prescaler 1024: 64 us por cuenta, hasta 16 ms. Cuenta el retardo entre el
+// cruce y la conmutación o, mientras quedan órdenes en la cola, periodos de 16 ms para
+// revisar el detector aunque loop() esté detenido en un delay()
+const uint8_t SWITCH_DELAY_COUNTS = RELAY_SWITCH_DELAY_US / 64;
+const uint8_t WATCHDOG_COUNTS = 255;
+static volatile bool switching = false; // El Timer2 cuenta el retardo de una conmutación
+
+static void startSwitchTimer(uint8_t counts)
+{
+  TCCR2B = 0;
+  TCNT2 = 0;
+  OCR2A = counts;
+  TIFR2 = _BV(OCF2A);
+  TIMSK2 = _BV(OCIE2A);
+  TCCR2B = _BV(CS22) | _BV(CS21) | _BV(CS20);
+}
+
+static void stopSwitchTimer()
+{
+  TCCR2B = 0;
+  TIMSK2 = 0;
+  switching = false;
+}
+
+// Si hay órdenes en la cola y el Timer2 está libre, lo usa para vigilar el detector
+static void watchDetector()
+{
+  if (queueHead != queueTail && TCCR2B == 0)
+    startSwitchTimer(WATCHDOG_COUNTS);
+}
+
+static void onZeroCross()
+{
+  lastCrossingMs = millis();
+  if (queueHead == queueTail || switching)
+    return;
+
+  if (SWITCH_DELAY_COUNTS == 0)
+  {
+    applyNext(true);
+    return;
+  }
+  switching = true;
+  startSwitchTimer(SWITCH_DELAY_COUNTS);
+}
+
+// El detector da un pulso alto alrededor de cada cruce; se usa el flanco de subida
+ISR(ZERO_CROSS_VECTOR)
+{
+  if (digitalRead(ZERO_CROSS_PIN) == HIGH)
+    onZeroCross();
+}
+
+ISR(TIMER2_COMPA_vect)
+{
+  if (switching)
+    applyNext(true);
+  else if (detectorTimedOut())
+    applyUnsynchronized();
+  stopSwitchTimer();
+  watchDetector();
+}
+
+static void startDetector()
+{
+  TCCR2A = 0;
+  stopSwitchTimer();
+  pinMode(ZERO_CROSS_PIN, INPUT);
+  *digitalPinToPCMSK(ZERO_CROSS_PIN) |= _BV(digitalPinToPCMSKbit(ZERO_CROSS_PIN));
+  *digitalPinToPCICR(ZERO_CROSS_PIN) |= _BV(digitalPinToPCICRbit(ZERO_CROSS_PIN));
+}
+
+#else
+
+// En el host la red se emula con el tick del reloj virtual y la orden se aplica en
+// el mismo cruce (no se emula el retardo del Timer2)
+static unsigned long nextCrossingMicros = 0;
+
+static void stopSwitchTimer() {}
+static void watchDetector() {}
+
+static void onZeroCross()
+{
+  lastCrossingMs = millis();
+  applyNext(true);
+}
+
+static void onTick()
+{
+  if ((long)(micros() - nextCrossingMicros) < 0)
+    return;
+  nextCrossingMicros += MAINS_HALF_PERIOD_US;
+  onZeroCross();
+}
+
+static void startDetector()
+{
+  nextCrossingMicros = micros();
+  hostOnTick(onTick);
+}
+
+#endif
+
+void relayBegin()
+{
+  pinMode(IRRIGATION_MOTOR, OUTPUT);
+  digitalWrite(IRRIGATION_MOTOR, LOW);
+  lastCrossingMs = millis();
+  startDetector();
+}
+
+void relayCommand(bool on, unsigned long sampleMicros)
+{
+  if (on != lastQueued)
+  {
+    if ((uint8_t)(queueHead - queueTail) >= RELAY_QUEUE_SIZE)
+    {
+      noInterrupts();
+      counters.dropped++;
+      wear.write(counters);
+      interrupts();
+      return;
+    }
+    commands[queueHead % RELAY_QUEUE_SIZE] = on;
+    sampleTimes[queueHead % RELAY_QUEUE_SIZE] = sampleMicros;
+    queueHead = queueHead + 1;
+    lastQueued = on;
+  }
+  else if (queueHead == queueTail)
+  {
+    // Sin órdenes pendientes el relé ya está como se pide: la orden llega al pin ahora
+    noInterrupts();
+    apply(on, false, sampleMicros);
+    interrupts();
+  }
+
+  // Con el detector caído la orden se aplica ya; si no, el Timer2 lo vigila hasta el cruce
+  noInterrupts();
+  if (detectorTimedOut())
+  {
+    stopSwitchTimer();
+    applyUnsynchronized();
+  }
+  else
+    watchDetector();
+  interrupts();
+}
+
+#else
+
+void relayBegin()
+{
+  pinMode(IRRIGATION_MOTOR, OUTPUT);
+  digitalWrite(IRRIGATION_MOTOR, LOW);
+}
+
+void relayCommand(bool on, unsigned long sampleMicros)
+{
+  apply(on, false, sampleMicros);
+}
+
+#endif
+
+bool relayNextLatency(unsigned long& latencyMicros)
+{
+  if (latencyHead == latencyTail)
+    return false;
+  latencyMicros = latencies[latencyTail % RELAY_LATENCY_SLOTS];
+  latencyTail = latencyTail + 1;
+  return true;
+}
+
+RelayWear relayWear()
+{
+  return wear.read();
+}
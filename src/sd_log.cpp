@@ -0,0 +1,368 @@
+// Implementación del registro en la tarjeta SD (protocolo SPI de las tarjetas SD)
+
+#include "sd_log.h"
+
+#if SD_LOG_ENABLED
+
+#include <Arduino.h>
+#include <SPI.h>
+
+const unsigned long SD_INIT_TIMEOUT_MS = 1000; // Máximo para salir del estado inactivo
+const unsigned long SD_READ_TIMEOUT_MS = 200;  // Máximo hasta el inicio de los datos de una lectura
+const uint8_t SD_DATA_TOKEN = 0xFE;            // Inicio de un bloque de datos
+const uint8_t SD_DATA_ACCEPTED = 0x05;         // Respuesta a un bloque escrito correctamente
+const uint16_t MBR_PARTITIONS = 446;           // Tabla de 4 particiones de 16 bytes y la firma 0x55AA
+
+// Estado de la tarjeta
+enum SdState : uint8_t {
+  SD_OFF,   // No respondió al iniciar o la zona está llena
+  SD_IDLE,  // Sin bloque abierto
+  SD_OPEN,  // Bloque abierto con CMD24, recibiendo registros
+  SD_BUSY,  // Grabando el bloque completo
+};
+
+static SdState state = SD_OFF;
+static bool highCapacity = false; // SDHC/SDXC se direccionan por bloque y no por byte
+static uint32_t nextBlock = 0;    // Bloque de la zona que se escribe ahora
+static uint8_t recordsInBlock = 0;
+static uint16_t boot = 0;
+static uint16_t lost = 0;       // Lecturas perdidas que todavía no anotó ningún bloque grabado
+static uint8_t lostInBlock = 0; // Las que anota la cabecera del bloque abierto
+
+static uint8_t queue[SD_LOG_QUEUE][SD_RECORD_SIZE];
+static uint8_t queueHead = 0;
+static uint8_t queueCount = 0;
+
+static const SPISettings SD_INIT_SPEED(250000, MSBFIRST, SPI_MODE0);
+static const SPISettings SD_SPEED(4000000, MSBFIRST, SPI_MODE0);
+
+// ======== BUS ========
+static uint8_t spi(uint8_t data)
+{
+  return SPI.transfer(data);
+}
+
+static void select()
+{
+  SPI.beginTransaction(SD_SPEED);
+  digitalWrite(SD_CS_PIN, LOW);
+}
+
+static void deselect()
+{
+  digitalWrite(SD_CS_PIN, HIGH);
+  spi(0xFF); // La tarjeta suelta MISO con un ciclo más
+  SPI.endTransaction();
+}
+
+// Envía un comando y devuelve la respuesta R1 (0xFF si no responde)
+static uint8_t command(uint8_t index, uint32_t argument)
+{
+  spi(0xFF);
+  spi(0x40 | index);
+  spi(argument >> 24);
+  spi(argument >> 16);
+  spi(argument >> 8);
+  spi(argument);
+  // El CRC solo se comprueba en CMD0 y CMD8 mientras la tarjeta está en modo SPI
+  spi(index == 0 ? 0x95 : (index == 8 ? 0x87 : 0x01));
+
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    uint8_t response = spi(0xFF);
+    if ((response & 0x80) == 0)
+      return response;
+  }
+  return 0xFF;
+}
+
+static uint32_t address(uint32_t cardBlock)
+{
+  return highCapacity ? cardBlock : cardBlock * SD_BLOCK_SIZE;
+}
+
+// ======== REGISTROS ========
+static void seal(uint8_t* record)
+{
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < SD_RECORD_SIZE - 1; i++)
+    sum += record[i];
+  record[SD_RECORD_SIZE - 1] = sum;
+}
+
+static bool sealed(const uint8_t* record)
+{
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < SD_RECORD_SIZE - 1; i++)
+    sum += record[i];
+  return record[SD_RECORD_SIZE - 1] == sum;
+}
+
+static void put16(uint8_t* at, uint16_t value)
+{
+  at[0] = value;
+  at[1] = value >> 8;
+}
+
+static void put32(uint8_t* at, uint32_t value)
+{
+  put16(at, value);
+  put16(at + 2, value >> 16);
+}
+
+static uint32_t get32(const uint8_t* at)
+{
+  return at[0] | ((uint32_t)at[1] << 8) | ((uint32_t)at[2] << 16) | ((uint32_t)at[3] << 24);
+}
+
+// Lee length bytes desde offset de un bloque de la tarjeta, sin guardar el resto
+static bool readBytes(uint32_t cardBlock, uint16_t offset, uint8_t* data, uint8_t length)
+{
+  select();
+  bool read = false;
+  if (command(17, address(cardBlock)) == 0)
+  {
+    unsigned long start = millis();
+    uint8_t token;
+    do
+      token = spi(0xFF);
+    while (token == 0xFF && millis() - start < SD_READ_TIMEOUT_MS);
+
+    if (token == SD_DATA_TOKEN)
+    {
+      for (uint16_t i = 0; i < SD_BLOCK_SIZE + 2; i++) // Bloque y CRC
+      {
+        uint8_t value = spi(0xFF);
+        if (i >= offset && i - offset < length)
+          data[i - offset] = value;
+      }
+      read = true;
+    }
+  }
+  deselect();
+  return read;
+}
+
+// Lee la cabecera de un bloque de la zona; devuelve false si no es un bloque del registro
+static bool readHeader(uint32_t block, uint8_t* header)
+{
+  return readBytes(SD_LOG_START_BLOCK + block, 0, header, SD_RECORD_SIZE) && header[0] == SD_HEADER_TAG &&
+         header[1] == SD_LOG_VERSION && sealed(header) && get32(header + 4) == block;
+}
+
+// Comprueba con la tabla de particiones del MBR (bloque 0) que la zona no pise ninguna.
+// Sin la firma 0x55AA la tarjeta no tiene particiones. Con la firma pero con entradas
+// inválidas el bloque 0 es el de un sistema de archivos que ocupa toda la tarjeta.
+static bool zoneOutsidePartitions()
+{
+  uint8_t table[66];
+  if (!readBytes(0, MBR_PARTITIONS, table, sizeof(table)))
+    return false;
+  if (table[64] != 0x55 || table[65] != 0xAA)
+    return true;
+
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    const uint8_t* entry = table + 16 * i;
+    if (entry[0] != 0x00 && entry[0] != 0x80)
+      return false;
+    uint32_t first = get32(entry + 8);
+    uint32_t count = get32(entry + 12);
+    if (entry[4] == 0 || count == 0)
+      continue;
+    // Restas en lugar de sumas: la partición de protección de GPT llega al final del espacio de 32 bits
+    bool overlaps = SD_LOG_START_BLOCK >= first ? SD_LOG_START_BLOCK - first < count : first - SD_LOG_START_BLOCK < SD_LOG_BLOCKS;
+    if (overlaps)
+      return false;
+  }
+  return true;
+}
+
+// ======== ESCRITURA ========
+static void countLost(uint8_t readings)
+{
+  lost = readings < 0xFFFF - lost ? lost + readings : 0xFFFF;
+}
+
+static bool openBlock()
+{
+  select();
+  if (command(24, address(SD_LOG_START_BLOCK + nextBlock)) != 0)
+  {
+    deselect();
+    return false;
+  }
+  spi(0xFF);
+  spi(SD_DATA_TOKEN);
+
+  uint8_t header[SD_RECORD_SIZE] = {SD_HEADER_TAG, SD_LOG_VERSION};
+  put16(header + 2, boot);
+  put32(header + 4, nextBlock);
+  put32(header + 8, millis());
+  put16(header + 12, (uint16_t)(TEMP_VREF * 1000 + 0.5f));
+  lostInBlock = lost < 0xFF ? lost : 0xFF;
+  header[14] = lostInBlock;
+  seal(header);
+  for (uint8_t i = 0; i < SD_RECORD_SIZE; i++)
+    spi(header[i]);
+
+  recordsInBlock = 1;
+  state = SD_OPEN;
+  return true;
+}
+
+// Termina el bloque; la tarjeta queda grabando y sdLogService() espera sin bloquear
+static void closeBlock()
+{
+  spi(0xFF); // CRC, no se comprueba en modo SPI
+  spi(0xFF);
+  uint8_t response = spi(0xFF) & 0x1F;
+  if (response != SD_DATA_ACCEPTED)
+  {
+    // Se reintenta el mismo bloque para que la zona siga sin huecos; sus lecturas ya
+    // salieron de la cola y se pierden
+    deselect();
+    countLost(SD_RECORDS_PER_BLOCK - 1);
+    state = SD_IDLE;
+    return;
+  }
+  lost -= lostInBlock; // Las anotó la cabecera de este bloque
+  lostInBlock = 0;
+  state = SD_BUSY;
+}
+
+SdLogStatus sdLogBegin()
+{
+  pinMode(SD_CS_PIN, OUTPUT);
+  digitalWrite(SD_CS_PIN, HIGH);
+  SPI.begin();
+
+  // Al menos 74 ciclos de reloj con CS en alto para entrar al modo nativo
+  SPI.beginTransaction(SD_INIT_SPEED);
+  for (uint8_t i = 0; i < 10; i++)
+    spi(0xFF);
+  digitalWrite(SD_CS_PIN, LOW);
+
+  bool ready = false;
+  if (command(0, 0) == 0x01)
+  {
+    // CMD8 solo lo aceptan las tarjetas de la versión 2 (las únicas que pueden ser SDHC)
+    bool version2 = command(8, 0x1AA) == 0x01;
+    uint8_t echo = 0;
+    for (uint8_t i = 0; version2 && i < 4; i++)
+      echo = spi(0xFF);
+
+    if (!version2 || echo == 0xAA)
+    {
+      unsigned long start = millis();
+      uint8_t response;
+      do
+      {
+        command(55, 0);
+        response = command(41, version2 ? 0x40000000UL : 0);
+      } while (response != 0 && millis() - start < SD_INIT_TIMEOUT_MS);
+
+      if (response == 0 && version2 && command(58, 0) == 0)
+      {
+        highCapacity = (spi(0xFF) & 0x40) != 0;
+        for (uint8_t i = 0; i < 3; i++)
+          spi(0xFF);
+        ready = true;
+      }
+      else if (response == 0 && !version2)
+      {
+        ready = command(16, SD_BLOCK_SIZE) == 0;
+      }
+    }
+  }
+  digitalWrite(SD_CS_PIN, HIGH);
+  spi(0xFF);
+  SPI.endTransaction();
+
+  if (!ready)
+    return SD_LOG_NO_CARD;
+  if (!zoneOutsidePartitions())
+    return SD_LOG_PARTITION;
+
+  // Primer bloque sin cabecera válida: los bloques escritos están al inicio de la zona
+  uint32_t low = 0;
+  uint32_t high = SD_LOG_BLOCKS;
+  uint8_t header[SD_RECORD_SIZE];
+  while (low < high)
+  {
+    uint32_t middle = low + (high - low) / 2;
+    if (readHeader(middle, header))
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  nextBlock = low;
+
+  boot = 1;
+  if (nextBlock > 0 && readHeader(nextBlock - 1, header))
+    boot = (header[2] | (header[3] << 8)) + 1;
+
+  state = nextBlock < SD_LOG_BLOCKS ? SD_IDLE : SD_OFF;
+  return state == SD_IDLE ? SD_LOG_READY : SD_LOG_FULL;
+}
+
+void sdLogAppend(const SdLogReading& reading)
+{
+  if (state == SD_OFF)
+    return;
+  if (queueCount == SD_LOG_QUEUE)
+  {
+    countLost(1);
+    return;
+  }
+
+  uint8_t* record = queue[(queueHead + queueCount) % SD_LOG_QUEUE];
+  record[0] = SD_READING_TAG;
+  record[1] = (reading.motorOn ? 0x01 : 0) | (reading.latencyAlarm ? 0x02 : 0) | ((reading.anomalies & 0x0F) << 2);
+  put32(record + 2, reading.millis);
+  put16(record + 6, reading.rawTemperature);
+  put16(record + 8, reading.rawHumidity);
+  put16(record + 10, reading.samples);
+  put16(record + 12, reading.relayOperations);
+  record[14] = reading.crop;
+  seal(record);
+  queueCount++;
+}
+
+void sdLogService()
+{
+  while (state != SD_OFF)
+  {
+    if (state == SD_BUSY)
+    {
+      // La tarjeta mantiene MISO en bajo mientras graba
+      SPI.beginTransaction(SD_SPEED);
+      bool busy = spi(0xFF) == 0;
+      SPI.endTransaction();
+      if (busy)
+        return;
+
+      deselect();
+      nextBlock++;
+      state = nextBlock < SD_LOG_BLOCKS ? SD_IDLE : SD_OFF;
+      continue;
+    }
+
+    if (queueCount == 0)
+      return;
+
+    if (state == SD_IDLE && !openBlock())
+      return; // Se reintenta en la próxima llamada
+
+    const uint8_t* record = queue[queueHead];
+    for (uint8_t i = 0; i < SD_RECORD_SIZE; i++)
+      spi(record[i]);
+    queueHead = (queueHead + 1) % SD_LOG_QUEUE;
+    queueCount--;
+
+    if (++recordsInBlock == SD_RECORDS_PER_BLOCK)
+      closeBlock();
+  }
+}
+
+#endif
@@ -0,0 +1,243 @@
+// Implementación de la lectura de los sensores por interrupciones
+
+#include "sensor_sampler.h"
+
+#include <Arduino.h>
+
+#ifdef __AVR__
+#include <avr/interrupt.h>
+#endif
+
+#include "board_config.h"
+#include "seqlock.h"
+
+#if PROBE_POWER_ENABLED
+// La sonda se enciende cada PROBE_PERIOD_MS y se lee PROBE_BURST veces tras PROBE_SETTLE_MS
+const uint16_t PERIOD_TICKS = (PROBE_PERIOD_MS * 1000UL + SAMPLER_TICK_US - 1) / SAMPLER_TICK_US;
+const uint16_t PROBE_SETTLE_TICKS = (PROBE_SETTLE_MS * 1000UL + SAMPLER_TICK_US - 1) / SAMPLER_TICK_US;
+const uint8_t BURST = PROBE_BURST;
+#else
+const uint16_t PERIOD_TICKS = SAMPLE_PERIOD_TICKS;
+const uint16_t PROBE_SETTLE_TICKS = 0;
+const uint8_t BURST = 1;
+#endif
+
+#if TEMP_INTERNAL_REFERENCE
+// Al pasar de AVcc a 1.1 V el condensador de AREF (100 nF en el Uno) tarda unos
+// milisegundos en descargarse; antes de eso la conversión de temperatura sale alta
+const unsigned long REFERENCE_SETTLE_MS = 10;
+#else
+const unsigned long REFERENCE_SETTLE_MS = 0;
+#endif
+const uint16_t REFERENCE_SETTLE_TICKS = (REFERENCE_SETTLE_MS * 1000UL + SAMPLER_TICK_US - 1) / SAMPLER_TICK_US;
+
+// La sonda y la referencia se estabilizan a la vez al inicio de cada pasada
+const uint16_t SETTLE_TICKS = PROBE_SETTLE_TICKS > REFERENCE_SETTLE_TICKS ? PROBE_SETTLE_TICKS : REFERENCE_SETTLE_TICKS;
+
+// Paso de la secuencia de lectura
+enum SamplerStep : uint8_t {
+  STEP_IDLE,        // Esperando el próximo periodo
+  STEP_SETTLING,    // Esperando que se estabilicen la sonda y la referencia
+  STEP_TEMPERATURE, // Convirtiendo el canal de temperatura
+  STEP_HUMIDITY,    // Convirtiendo el canal de humedad
+};
+
+static SeqLock<SensorSnapshot> snapshot;
+static volatile uint8_t step = STEP_IDLE;
+static uint16_t ticks = 0; // Desde el inicio de la pasada
+static uint16_t pendingTemperature = 0;
+static uint16_t humiditySum = 0;
+static uint8_t humidityLeft = 0;
+static uint16_t samples = 0;
+
+static uint8_t channelPin = 0;          // Canal seleccionado
+static uint8_t channelReference = 0;    // Referencia seleccionada (DEFAULT o INTERNAL)
+static bool discardConversion = false;  // La primera conversión tras cambiar de referencia no es válida
+
+static void applyChannel();
+static void startConversion();
+static void startTimer();
+
+// Referencia del ADC para cada sensor: 1.1 V para el TMP36 si está configurada, AVcc para el resto
+static uint8_t referenceOf(uint8_t pin)
+{
+#if TEMP_INTERNAL_REFERENCE
+  if (pin == TMP_SENSOR)
+    return INTERNAL;
+#else
+  (void)pin;
+#endif
+  return DEFAULT;
+}
+
+// Selecciona el canal y su referencia sin convertir
+static void selectChannel(uint8_t pin)
+{
+  uint8_t reference = referenceOf(pin);
+  if (reference != channelReference)
+    discardConversion = true;
+  channelReference = reference;
+  channelPin = pin;
+  applyChannel();
+}
+
+// Publica una lectura completa para loop()
+static void publish(uint16_t rawTemperature, uint16_t rawHumidity)
+{
+  SensorSnapshot reading;
+  reading.rawTemperature = rawTemperature;
+  reading.rawHumidity = rawHumidity;
+  reading.sampleMicros = micros();
+  reading.samples = ++samples;
+  snapshot.write(reading);
+}
+
+// Resultado de una conversión, desde la interrupción del ADC
+static void onConversion(uint16_t value)
+{
+  if (discardConversion)
+  {
+    discardConversion = false;
+    startConversion();
+    return;
+  }
+
+  if (step == STEP_TEMPERATURE)
+  {
+    pendingTemperature = value;
+    humiditySum = 0;
+    humidityLeft = BURST;
+    step = STEP_HUMIDITY;
+    selectChannel(HUM_SENSOR);
+    startConversion();
+    return;
+  }
+
+  humiditySum += value;
+  if (--humidityLeft > 0)
+  {
+    startConversion();
+    return;
+  }
+
+#if PROBE_POWER_ENABLED
+  digitalWrite(PROBE_POWER_PIN, LOW);
+#endif
+  publish(pendingTemperature, (humiditySum + BURST / 2) / BURST);
+  step = STEP_IDLE;
+}
+
+// Tick del temporizador: al inicio de cada periodo enciende la sonda y cambia la
+// referencia, y lee los sensores cuando pasó la espera. Nunca bloquea.
+static void onTick()
+{
+  if (ticks < 0xFFFF)
+    ticks++;
+
+  if (step == STEP_SETTLING && ticks >= SETTLE_TICKS)
+  {
+    step = STEP_TEMPERATURE;
+    startConversion();
+    return;
+  }
+
+  if (step != STEP_IDLE || ticks < PERIOD_TICKS)
+    return;
+
+  ticks = 0;
+#if PROBE_POWER_ENABLED
+  digitalWrite(PROBE_POWER_PIN, HIGH);
+#endif
+  selectChannel(TMP_SENSOR);
+  if (SETTLE_TICKS > 0)
+  {
+    step = STEP_SETTLING;
+    return;
+  }
+  step = STEP_TEMPERATURE;
+  startConversion();
+}
+
+#ifdef __AVR__
+
+// Mismo formato que usa analogRead(): la referencia en REFS1:0 y el canal en MUX2:0
+static void applyChannel()
+{
+  uint8_t channel = channelPin >= A0 ? channelPin - A0 : channelPin;
+  ADMUX = (channelReference << 6) | (channel & 0x07);
+}
+
+static void startConversion()
+{
+  ADCSRA |= _BV(ADSC) | _BV(ADIE); // El núcleo de Arduino ya habilitó el ADC con prescaler 128
+}
+
+ISR(ADC_vect)
+{
+  onConversion(ADC);
+}
+
+ISR(TIMER0_COMPB_vect)
+{
+  onTick();
+}
+
+// El Timer0 ya cuenta para millis(); se usa su comparador B a mitad de cada vuelta
+static void startTimer()
+{
+  OCR0B = 128;
+  TIMSK0 |= _BV(OCIE0B);
+}
+
+#else
+
+// En el host la conversión termina de inmediato con el valor del pin emulado
+static void applyChannel()
+{
+  analogReference(channelReference);
+}
+
+static void startConversion()
+{
+  onConversion(analogRead(channelPin));
+}
+
+static void startTimer()
+{
+  hostOnTick(onTick);
+}
+
+#endif
+
+// Lectura bloqueante para el inicio; la primera conversión con la referencia nueva se descarta
+static uint16_t readBlocking(uint8_t pin)
+{
+  analogReference(referenceOf(pin));
+  analogRead(pin);
+  delay(REFERENCE_SETTLE_MS);
+  return analogRead(pin);
+}
+
+void sensorSamplerBegin()
+{
+  // Primera lectura con analogRead() para que loop() tenga valores desde el inicio
+#if PROBE_POWER_ENABLED
+  pinMode(PROBE_POWER_PIN, OUTPUT);
+  digitalWrite(PROBE_POWER_PIN, HIGH);
+  delay(PROBE_SETTLE_MS);
+#endif
+  uint16_t rawTemperature = readBlocking(TMP_SENSOR);
+  publish(rawTemperature, readBlocking(HUM_SENSOR));
+#if PROBE_POWER_ENABLED
+  digitalWrite(PROBE_POWER_PIN, LOW);
+#endif
+
+  channelPin = HUM_SENSOR;
+  channelReference = referenceOf(HUM_SENSOR);
+  startTimer();
+}
+
+SensorSnapshot sensorSnapshot()
+{
+  return snapshot.read();
+}
@@ -0,0 +1,114 @@
+// Implementación de la telemetría comprimida (solo AVR)
+
+#include "telemetry.h"
+
+#if defined(ENABLE_TELEMETRY) && defined(__AVR__)
+
+#include <Arduino.h>
+
+#include "board_config.h"
+
+#if !SERIAL_ENABLED
+#error "La telemetría se envía por el puerto serie: habilítelo en la configuración (config/board_serial.json)"
+#endif
+
+static uint8_t payload[TELEMETRY_FRAME_BYTES];
+static TelemetryEncoder encoder(payload, TELEMETRY_FRAME_BYTES);
+static uint8_t sequence = 0;
+static uint8_t dropped = 0;
+static uint16_t droppedTotal = 0;
+static bool full = false;
+static unsigned long firstRecordMs = 0;
+
+void telemetryBegin()
+{
+  Serial.begin(SERIAL_BAUD);
+}
+
+void telemetryRecord(const uint16_t* values)
+{
+  if (encoder.recordCount() == 0)
+    firstRecordMs = millis();
+
+  if (!encoder.push(values))
+  {
+    full = true;
+    if (dropped != 0xFF)
+      dropped++;
+    droppedTotal++;
+  }
+}
+
+void telemetryFlush()
+{
+  if (encoder.recordCount() == 0)
+    return;
+  if (!full && millis() - firstRecordMs < TELEMETRY_MAX_DELAY_MS)
+    return;
+
+  encoder.finish();
+  uint8_t length = encoder.size();
+
+  // Cabecera (6 bytes con la sincronización) y suma de comprobación
+  if (Serial.availableForWrite() < length + 7)
+    return;
+
+  uint8_t checksum = TELEMETRY_TAG + sequence + dropped + length;
+  Serial.write(FRAME_SYNC_1);
+  Serial.write(FRAME_SYNC_2);
+  Serial.write(TELEMETRY_TAG);
+  Serial.write(sequence);
+  Serial.write(dropped);
+  Serial.write(length);
+  Serial.write(payload, length);
+  for (uint8_t i = 0; i < length; i++)
+    checksum += payload[i];
+  Serial.write(checksum);
+
+  encoder.clear();
+  sequence++;
+  dropped = 0;
+  full = false;
+}
+
+// Escribe un valor en little endian y lo suma a la comprobación
+static void writeValue(uint32_t value, uint8_t bytes, uint8_t& checksum)
+{
+  for (uint8_t i = 0; i < bytes; i++)
+  {
+    uint8_t byte = (uint8_t)(value >> (8 * i));
+    Serial.write(byte);
+    checksum += byte;
+  }
+}
+
+bool telemetrySendStats(const TelemetryStats& stats)
+{
+  // Sincronización, letra, 42 bytes de campos y suma de comprobación
+  if (Serial.availableForWrite() < 46)
+    return false;
+
+  uint8_t checksum = TELEMETRY_STATS_TAG;
+  Serial.write(FRAME_SYNC_1);
+  Serial.write(FRAME_SYNC_2);
+  Serial.write(TELEMETRY_STATS_TAG);
+  writeValue(stats.uptimeSeconds, 4, checksum);
+  writeValue(stats.loopMillis, 2, checksum);
+  writeValue(stats.latencyP50Micros, 4, checksum);
+  writeValue(stats.latencyP99Micros, 4, checksum);
+  writeValue(stats.latencyMaxMicros, 4, checksum);
+  writeValue(stats.latencyAlarm ? 1 : 0, 1, checksum);
+  writeValue(stats.relayOperations, 4, checksum);
+  writeValue(stats.relaySynchronized, 4, checksum);
+  writeValue(stats.relayUnsynchronized, 4, checksum);
+  writeValue(stats.relayDropped, 2, checksum);
+  writeValue(stats.sensorFaults, 2, checksum);
+  writeValue(droppedTotal, 2, checksum);
+  writeValue(stats.anomalies, 1, checksum);
+  writeValue(stats.dryMinutes, 2, checksum);
+  writeValue(stats.evaporationMilli, 2, checksum);
+  Serial.write(checksum);
+  return true;
+}
+
+#endif
@@ -0,0 +1,81 @@
+// Implementación de las trazas de eventos (solo AVR)
+
+#include "trace.h"
+
+#if defined(ENABLE_TRACE) && defined(__AVR__)
+
+#include <Arduino.h>
+
+#include "board_config.h"
+
+#if !SERIAL_ENABLED
+#error "Las trazas se envían por el puerto serie: habilítelo en la configuración (config/board_serial.json)"
+#endif
+
+static uint8_t events[TRACE_BUFFER_EVENTS][4];
+static uint8_t head = 0;  // Próxima posición a escribir
+static uint8_t count = 0; // Eventos pendientes de envío
+static uint8_t dropped = 0;
+
+void traceBegin()
+{
+  Serial.begin(SERIAL_BAUD);
+}
+
+void traceEvent(uint8_t id, bool end)
+{
+  if (count == TRACE_BUFFER_EVENTS)
+  {
+    if (dropped != 0xFF)
+      dropped++;
+    return;
+  }
+
+  uint32_t ticks = micros() >> 2;
+  uint8_t* event = events[head];
+  event[0] = (id << 1) | (end ? 1 : 0);
+  event[1] = (uint8_t)ticks;
+  event[2] = (uint8_t)(ticks >> 8);
+  event[3] = (uint8_t)(ticks >> 16);
+
+  head = (head + 1) % TRACE_BUFFER_EVENTS;
+  count++;
+}
+
+void traceFlush()
+{
+  while (count > 0)
+  {
+    // Cabecera (5 bytes con la sincronización) y suma de comprobación
+    int room = (Serial.availableForWrite() - 6) / 4;
+    if (room <= 0)
+      return;
+
+    uint8_t batch = count;
+    if (batch > TRACE_FRAME_EVENTS)
+      batch = TRACE_FRAME_EVENTS;
+    if (batch > room)
+      batch = room;
+
+    uint8_t tail = (head + TRACE_BUFFER_EVENTS - count) % TRACE_BUFFER_EVENTS;
+    uint8_t checksum = TRACE_TAG + batch + dropped;
+
+    Serial.write(FRAME_SYNC_1);
+    Serial.write(FRAME_SYNC_2);
+    Serial.write(TRACE_TAG);
+    Serial.write(batch);
+    Serial.write(dropped);
+    for (uint8_t i = 0; i < batch; i++)
+    {
+      const uint8_t* event = events[(tail + i) % TRACE_BUFFER_EVENTS];
+      Serial.write(event, 4);
+      checksum += event[0] + event[1] + event[2] + event[3];
+    }
+    Serial.write(checksum);
+
+    count -= batch;
+    dropped = 0;
+  }
+}
+
+#endif
@@ -0,0 +1,203 @@
+// Detector de anomalías con una cama simulada con soilStep()
+// La cama se riega con una histéresis sobre la lectura de la sonda, como el firmware, y
+// cada prueba provoca una falla a una hora dada: sin fallas no tiene que marcar nada, y
+// con cada falla tiene que marcar la suya en pocas horas. El rango alto riega por encima
+// de la capacidad de campo (60 %), donde el suelo además drena.
+
+#include <unity.h>
+
+#include <stdint.h>
+
+#include "anomaly_detector.h"
+#include "soil_model.h"
+
+const uint16_t ADC_MAX = 1023;
+const unsigned long CYCLE_MS = 1000;
+const float FAULT_HOUR = 20;
+
+enum Fault { NONE, EVAPORATION_FAULT, DRIFT_FAULT, LEAK_FAULT, STUCK_FAULT };
+
+struct Range {
+  float low;
+  float high;
+};
+
+const Range BELOW_FIELD_CAPACITY = {40, 55};
+const Range ABOVE_FIELD_CAPACITY = {62, 78};
+const Range ACROSS_FIELD_CAPACITY = {55, 70};
+
+struct Climate {
+  float mean;
+  float swing;
+};
+
+const Climate WARM = {24, 8};
+const Climate COOL = {14, 6};
+const Climate COLD = {10, 8}; // Noches cerca de 0 °C: casi todo el secado es drenaje
+
+struct Run {
+  uint8_t flags = 0;       // Todas las anomalías marcadas desde el aprendizaje
+  float firstHour[4] = {}; // Hora en que se marcó cada una por primera vez (0 si nunca)
+  float baseline = 0;
+};
+
+static int bit(uint8_t flag)
+{
+  int index = 0;
+  while ((flag >> index) != 1)
+    index++;
+  return index;
+}
+
+// Simula la cama y le pasa cada ciclo al detector
+static Run simulate(Range range, Climate climate, Fault fault, float hours)
+{
+  SoilParams params;
+  SoilState state;
+  state.moisture = state.probe = (range.low + range.high) / 2;
+  AnomalyDetector detector(ADC_MAX);
+  Run run;
+  bool pumpOn = false;
+  uint32_t noise = 12345;
+  uint16_t frozen = 0;
+
+  unsigned long cycles = (unsigned long)(hours * 3600000 / CYCLE_MS);
+  for (unsigned long cycle = 0; cycle < cycles; cycle++)
+  {
+    unsigned long nowMs = cycle * CYCLE_MS;
+    float hour = nowMs / 3600000.0f;
+    bool faulty = hour >= FAULT_HOUR;
+    float temperature = diurnalTemperature(climate.mean, climate.swing, hour);
+
+    SoilParams active = params;
+    if (faulty && fault == EVAPORATION_FAULT)
+      active.evaporationCoeff *= 3;
+    if (faulty && fault == LEAK_FAULT)
+      active.pumpGain = 0;
+    soilStep(active, state, CYCLE_MS / 1000.0f, temperature, pumpOn, 0);
+
+    // Sonda con el ruido de una cuenta del ADC
+    noise = noise * 1103515245u + 12345u;
+    float probe = state.probe;
+    if (faulty && fault == DRIFT_FAULT)
+      probe += hour - FAULT_HOUR;
+    int raw = (int)(probe / 100 * ADC_MAX + 0.5f) + (int)((noise >> 16) % 3) - 1;
+    if (faulty && fault == STUCK_FAULT)
+      raw = frozen;
+    frozen = raw;
+    float humidity = raw * 100.0f / ADC_MAX;
+
+    detector.update(raw, humidity, temperature, pumpOn, nowMs);
+    for (uint8_t flag = AnomalyDetector::STUCK; flag <= AnomalyDetector::DRIFT; flag <<= 1)
+    {
+      if ((detector.active() & flag) && run.firstHour[bit(flag)] == 0)
+        run.firstHour[bit(flag)] = hour;
+    }
+    run.flags |= detector.active();
+
+    if (humidity < range.low)
+      pumpOn = true;
+    else if (humidity > range.high)
+      pumpOn = false;
+  }
+  run.baseline = detector.dryingPerDegree();
+  return run;
+}
+
+static void assertClean(Range range, Climate climate)
+{
+  Run run = simulate(range, climate, NONE, 48);
+  TEST_ASSERT_EQUAL_UINT8(0, run.flags);
+}
+
+// La falla se marca dentro de las horas dadas desde que empieza
+static void assertDetected(Range range, Climate climate, Fault fault, uint8_t flag, float withinHours)
+{
+  Run run = simulate(range, climate, fault, FAULT_HOUR + withinHours);
+  float first = run.firstHour[bit(flag)];
+  TEST_ASSERT_TRUE_MESSAGE(first >= FAULT_HOUR, "la anomalía no se marcó o se marcó antes de la falla");
+  TEST_ASSERT_LESS_OR_EQUAL(FAULT_HOUR + withinHours, first);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_no_flags_below_field_capacity() { assertClean(BELOW_FIELD_CAPACITY, WARM); }
+void test_no_flags_below_field_capacity_cool() { assertClean(BELOW_FIELD_CAPACITY, COOL); }
+// El caso que marcaba deriva y evaporación: drenaje en días frescos
+void test_no_flags_with_drainage() { assertClean(ABOVE_FIELD_CAPACITY, WARM); }
+void test_no_flags_with_drainage_cool() { assertClean(ABOVE_FIELD_CAPACITY, COOL); }
+// El drenaje empieza y termina dentro de una misma franja
+void test_no_flags_across_field_capacity_cold() { assertClean(ACROSS_FIELD_CAPACITY, COLD); }
+
+void test_learns_drying_coefficient()
+{
+  Run run = simulate(BELOW_FIELD_CAPACITY, WARM, NONE, 24);
+  // Sin drenaje el secado es evaporationCoeff · 100 / fieldCapacity
+  float expected = SoilParams().evaporationCoeff * 100 / SoilParams().fieldCapacity;
+  TEST_ASSERT_FLOAT_WITHIN(expected * 0.15f, expected, run.baseline);
+}
+
+void test_detects_fast_evaporation()
+{
+  assertDetected(BELOW_FIELD_CAPACITY, WARM, EVAPORATION_FAULT, AnomalyDetector::EVAPORATION, 6);
+  assertDetected(ABOVE_FIELD_CAPACITY, COOL, EVAPORATION_FAULT, AnomalyDetector::EVAPORATION, 12);
+}
+
+void test_detects_probe_drift()
+{
+  assertDetected(BELOW_FIELD_CAPACITY, WARM, DRIFT_FAULT, AnomalyDetector::DRIFT, 6);
+  assertDetected(ABOVE_FIELD_CAPACITY, COOL, DRIFT_FAULT, AnomalyDetector::DRIFT, 12);
+}
+
+void test_detects_leak()
+{
+  assertDetected(BELOW_FIELD_CAPACITY, WARM, LEAK_FAULT, AnomalyDetector::LEAK, 6);
+  assertDetected(ABOVE_FIELD_CAPACITY, COOL, LEAK_FAULT, AnomalyDetector::LEAK, 12);
+}
+
+void test_detects_stuck_probe()
+{
+  Run run = simulate(BELOW_FIELD_CAPACITY, WARM, STUCK_FAULT, FAULT_HOUR + 1);
+  float first = run.firstHour[bit(AnomalyDetector::STUCK)];
+  // Media hora con la misma lectura
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, FAULT_HOUR + 0.5f, first);
+}
+
+void test_probe_on_rail()
+{
+  AnomalyDetector detector(ADC_MAX);
+  unsigned long nowMs = 0;
+  for (int i = 0; i < 10; i++, nowMs += CYCLE_MS)
+    detector.update(400 + i % 2, 40, 20, false, nowMs);
+  TEST_ASSERT_EQUAL_UINT8(0, detector.active());
+  // Sonda desconectada: un minuto en el extremo del ADC
+  unsigned long railStart = nowMs;
+  for (; nowMs - railStart < AnomalyDetector::RAIL_MS; nowMs += CYCLE_MS)
+  {
+    detector.update(ADC_MAX, 100, 20, false, nowMs);
+    TEST_ASSERT_EQUAL_UINT8(0, detector.active());
+  }
+  detector.update(ADC_MAX, 100, 20, false, nowMs);
+  TEST_ASSERT_EQUAL_UINT8(AnomalyDetector::STUCK, detector.active());
+  // Al volver a leer valores distintos se borra
+  detector.update(401, 40, 20, false, nowMs + CYCLE_MS);
+  TEST_ASSERT_EQUAL_UINT8(0, detector.active());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_no_flags_below_field_capacity);
+  RUN_TEST(test_no_flags_below_field_capacity_cool);
+  RUN_TEST(test_no_flags_with_drainage);
+  RUN_TEST(test_no_flags_with_drainage_cool);
+  RUN_TEST(test_no_flags_across_field_capacity_cold);
+  RUN_TEST(test_learns_drying_coefficient);
+  RUN_TEST(test_detects_fast_evaporation);
+  RUN_TEST(test_detects_probe_drift);
+  RUN_TEST(test_detects_leak);
+  RUN_TEST(test_detects_stuck_probe);
+  RUN_TEST(test_probe_on_rail);
+  return UNITY_END();
+}
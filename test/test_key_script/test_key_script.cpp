@@ -0,0 +1,170 @@
+// Guion de pulsaciones del teclado emulado y filtrado de rebotes de Keypad
+// El guion se prueba con instancias propias; Keypad lee siempre el guion global, así que
+// esas pruebas le añaden eventos en instantes posteriores al reloj virtual.
+
+#include <unity.h>
+
+#include <Arduino.h>
+#include <Keypad.h>
+
+const char KEYMAP[4][3] = {{'1', '2', '3'}, {'4', '5', '6'}, {'7', '8', '9'}, {'*', '0', '#'}};
+byte rowPins[4] = {2, 3, 4, 5};
+byte colPins[3] = {6, 7, 8};
+
+// Llama a getKey() cada milisegundo hasta untilMs y cuenta las veces que devuelve la tecla
+static unsigned int pollUntil(Keypad& keypad, unsigned long untilMs, char expected)
+{
+  unsigned int count = 0;
+  while (millis() < untilMs)
+  {
+    if (keypad.getKey() == expected)
+      count++;
+    delay(1);
+  }
+  return count;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_absolute_and_relative_times()
+{
+  KeyScript script;
+  TEST_ASSERT_TRUE(script.parse("@1000 1; +500 2 hold=200\n+0 #"));
+  const std::vector<KeyEvent>& events = script.events();
+  TEST_ASSERT_EQUAL_UINT32(3, events.size());
+  TEST_ASSERT_EQUAL('1', events[0].key);
+  TEST_ASSERT_EQUAL_UINT32(1000, events[0].pressMs);
+  TEST_ASSERT_EQUAL_UINT32(100, events[0].holdMs); // Valor por omisión
+  // + cuenta desde que se soltó la tecla anterior
+  TEST_ASSERT_EQUAL_UINT32(1600, events[1].pressMs);
+  TEST_ASSERT_EQUAL_UINT32(200, events[1].holdMs);
+  TEST_ASSERT_EQUAL('#', events[2].key);
+  TEST_ASSERT_EQUAL_UINT32(1800, events[2].pressMs);
+
+  // Un guion nuevo sigue contando desde el último evento del anterior
+  TEST_ASSERT_TRUE(script.parse("+100 5"));
+  TEST_ASSERT_EQUAL_UINT32(2000, script.events()[3].pressMs);
+}
+
+void test_bounce_options()
+{
+  KeyScript script;
+  TEST_ASSERT_TRUE(script.parse("@100 7 hold=50 bounce=4 period=3; +10 8 bounce=2 period=0"));
+  const KeyEvent& bouncy = script.events()[0];
+  TEST_ASSERT_EQUAL_UINT8(4, bouncy.bounces);
+  TEST_ASSERT_EQUAL_UINT32(3, bouncy.bouncePeriodMs);
+  TEST_ASSERT_EQUAL_UINT32(100 + 50 + 4 * 3, bouncy.endMs());
+  TEST_ASSERT_EQUAL_UINT32(bouncy.endMs() + 10, script.events()[1].pressMs);
+  TEST_ASSERT_EQUAL_UINT32(1, script.events()[1].bouncePeriodMs); // period=0 se toma como 1
+
+  // Al cerrar alterna cada 3 ms, queda cerrado hasta soltarse y vuelve a alternar al abrir
+  TEST_ASSERT_FALSE(bouncy.closedAt(99));
+  TEST_ASSERT_TRUE(bouncy.closedAt(100));
+  TEST_ASSERT_FALSE(bouncy.closedAt(103));
+  TEST_ASSERT_TRUE(bouncy.closedAt(106));
+  TEST_ASSERT_FALSE(bouncy.closedAt(109));
+  TEST_ASSERT_TRUE(bouncy.closedAt(112));
+  TEST_ASSERT_TRUE(bouncy.closedAt(149));
+  TEST_ASSERT_FALSE(bouncy.closedAt(150));
+  TEST_ASSERT_TRUE(bouncy.closedAt(153));
+  TEST_ASSERT_FALSE(bouncy.closedAt(bouncy.endMs()));
+  TEST_ASSERT_TRUE(script.isClosed('7', 120));
+  TEST_ASSERT_FALSE(script.isClosed('8', 120));
+}
+
+void test_comments_and_blank_lines()
+{
+  KeyScript script;
+  TEST_ASSERT_TRUE(script.parse("# menú\n\n@10 1 # primer cultivo; @20 2\r\n;;\n@30 3\n"));
+  // Lo que sigue a # hasta el fin de línea no cuenta, ni siquiera después de un ;
+  TEST_ASSERT_EQUAL_UINT32(2, script.events().size());
+  TEST_ASSERT_EQUAL('3', script.events()[1].key);
+
+  // En el lugar de la tecla, # es la tecla del teclado y no un comentario
+  TEST_ASSERT_TRUE(script.parse("@40 # hold=20 # numeral; @50 1\n\t#@60 2"));
+  TEST_ASSERT_EQUAL_UINT32(3, script.events().size());
+  TEST_ASSERT_EQUAL('#', script.events()[2].key);
+  TEST_ASSERT_EQUAL_UINT32(20, script.events()[2].holdMs);
+}
+
+void test_malformed_scripts_add_nothing()
+{
+  const char* const malformed[] = {
+    "1000 1",               // Sin @ ni +
+    "@1000",                // Sin tecla
+    "@1000 12",             // Tecla de más de un carácter
+    "@ 1",                  // Sin tiempo
+    "@1s 1",                // Tiempo con unidades
+    "+-5 1",                // Tiempo negativo
+    "@10 1 hold",           // Opción sin valor
+    "@10 1 hold=",          // Valor vacío
+    "@10 1 hold=abc",       // Valor que no es un número
+    "@10 1 bounce=300",     // Más rebotes de los que entran en un byte
+    "@10 1 repeat=2",       // Opción desconocida
+    "@10 1; @20 2 hold=x",  // El error en el segundo evento descarta también el primero
+  };
+  for (const char* text : malformed)
+  {
+    KeyScript script;
+    TEST_ASSERT_FALSE_MESSAGE(script.parse(text), text);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, script.events().size(), text);
+  }
+}
+
+void test_delivery_attributed_to_last_started_event()
+{
+  KeyScript script;
+  TEST_ASSERT_TRUE(script.parse("@100 1; @500 1; @300 2"));
+  script.delivered('1', 120);
+  script.delivered('1', 130);
+  script.delivered('1', 520);
+  script.delivered('2', 50); // Antes de cualquier pulsación de esa tecla
+  TEST_ASSERT_EQUAL_UINT32(2, script.events()[0].deliveries);
+  TEST_ASSERT_EQUAL_INT32(120, script.events()[0].firstDeliveryMs);
+  TEST_ASSERT_EQUAL_UINT32(1, script.events()[1].deliveries);
+  TEST_ASSERT_EQUAL_UINT32(0, script.events()[2].deliveries);
+  TEST_ASSERT_EQUAL_INT32(-1, script.events()[2].firstDeliveryMs);
+}
+
+void test_keypad_filters_short_bounces()
+{
+  Keypad keypad(makeKeymap(KEYMAP), rowPins, colPins, 4, 3);
+  KeyScript& script = KeyScript::instance();
+  unsigned long start = millis() + 100;
+
+  // Rebotes de 3 ms con el debounce de 10 ms de la librería: una sola pulsación
+  char text[64];
+  snprintf(text, sizeof(text), "@%lu 5 hold=200 bounce=6 period=3", start);
+  TEST_ASSERT_TRUE(script.parse(text));
+  const size_t index = script.events().size() - 1;
+  TEST_ASSERT_EQUAL_UINT(1, pollUntil(keypad, script.events()[index].endMs() + 50, '5'));
+  TEST_ASSERT_EQUAL_UINT(1, script.events()[index].deliveries);
+  TEST_ASSERT_TRUE(script.events()[index].firstDeliveryMs >= (long)start);
+}
+
+void test_keypad_repeats_long_bounces()
+{
+  // Rebotes más largos que el debounce llegan como pulsaciones repetidas, igual que en el hardware
+  Keypad keypad(makeKeymap(KEYMAP), rowPins, colPins, 4, 3);
+  KeyScript& script = KeyScript::instance();
+  char text[64];
+  snprintf(text, sizeof(text), "@%lu 9 hold=200 bounce=4 period=25", millis() + 100);
+  TEST_ASSERT_TRUE(script.parse(text));
+  const size_t index = script.events().size() - 1;
+  TEST_ASSERT_TRUE(pollUntil(keypad, script.events()[index].endMs() + 50, '9') > 1);
+  TEST_ASSERT_TRUE(script.events()[index].deliveries > 1);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_absolute_and_relative_times);
+  RUN_TEST(test_bounce_options);
+  RUN_TEST(test_comments_and_blank_lines);
+  RUN_TEST(test_malformed_scripts_add_nothing);
+  RUN_TEST(test_delivery_attributed_to_last_started_event);
+  RUN_TEST(test_keypad_filters_short_bounces);
+  RUN_TEST(test_keypad_repeats_long_bounces);
+  return UNITY_END();
+}
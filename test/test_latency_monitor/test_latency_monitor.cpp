@@ -0,0 +1,121 @@
+// Percentiles del histograma de latencia y división a la mitad de las casillas
+// Los valores esperados salen de las casillas: 4 por potencia de 2 desde 1024 us, y
+// el percentil devuelve el límite superior de la suya acotado por el máximo medido.
+
+#include <unity.h>
+
+#include "latency_monitor.h"
+
+const unsigned long FAST_MICROS = 2000;   // Casilla [1792, 2048)
+const unsigned long SLOW_MICROS = 20000;  // Casilla [16384, 20480)
+
+void setUp() {}
+void tearDown() {}
+
+void test_empty_monitor_reports_zero()
+{
+  LatencyMonitor monitor(95, 5000);
+  TEST_ASSERT_EQUAL_UINT32(0, monitor.percentileMicros(50));
+  TEST_ASSERT_EQUAL_UINT32(0, monitor.maximum());
+  TEST_ASSERT_FALSE(monitor.alarmActive());
+}
+
+void test_percentiles_of_two_groups()
+{
+  LatencyMonitor monitor(95, 5000);
+  for (int i = 0; i < 90; i++)
+    monitor.record(FAST_MICROS);
+  for (int i = 0; i < 10; i++)
+    monitor.record(SLOW_MICROS);
+
+  TEST_ASSERT_EQUAL_UINT32(2048, monitor.percentileMicros(50));
+  TEST_ASSERT_EQUAL_UINT32(2048, monitor.percentileMicros(90));
+  // La casilla lenta llega hasta 20480, pero el máximo medido es exacto
+  TEST_ASSERT_EQUAL_UINT32(SLOW_MICROS, monitor.percentileMicros(91));
+  TEST_ASSERT_EQUAL_UINT32(SLOW_MICROS, monitor.percentileMicros(100));
+  TEST_ASSERT_EQUAL_UINT32(SLOW_MICROS, monitor.maximum());
+  TEST_ASSERT_TRUE(monitor.alarmActive());
+}
+
+void test_short_latencies_share_first_bucket()
+{
+  LatencyMonitor monitor(50, 5000);
+  monitor.record(10);
+  monitor.record(900);
+  TEST_ASSERT_EQUAL_UINT32(900, monitor.percentileMicros(50));
+}
+
+void test_percentile_error_is_below_a_quarter()
+{
+  for (unsigned long value = 1024; value < 4000000UL; value += value / 7 + 1)
+  {
+    LatencyMonitor monitor(50, 5000);
+    for (int i = 0; i < 9; i++)
+      monitor.record(value);
+    monitor.record(8000000UL); // El máximo no acota la casilla de value
+    unsigned long p50 = monitor.percentileMicros(50);
+    TEST_ASSERT_GREATER_THAN(value, p50);
+    TEST_ASSERT_LESS_OR_EQUAL(value + value / 4, p50);
+  }
+}
+
+void test_alarm_waits_for_min_samples()
+{
+  LatencyMonitor monitor(95, 5000);
+  for (uint8_t i = 0; i < LatencyMonitor::MIN_SAMPLES; i++)
+    monitor.record(SLOW_MICROS);
+  TEST_ASSERT_FALSE(monitor.alarmActive());
+  monitor.record(SLOW_MICROS);
+  TEST_ASSERT_TRUE(monitor.alarmActive());
+}
+
+void test_halving_keeps_proportions()
+{
+  LatencyMonitor monitor(95, 5000);
+  for (int i = 0; i < 20; i++)
+    monitor.record(SLOW_MICROS);
+  for (int i = 0; i < 255; i++)
+    monitor.record(FAST_MICROS);
+  // 255 rápidas y 20 lentas: el 93 % cae en la casilla lenta
+  TEST_ASSERT_EQUAL_UINT32(SLOW_MICROS, monitor.percentileMicros(93));
+
+  // La casilla rápida está llena: la siguiente divide todas a la mitad (128 y 10)
+  monitor.record(FAST_MICROS);
+  TEST_ASSERT_EQUAL_UINT32(2048, monitor.percentileMicros(92));
+  TEST_ASSERT_EQUAL_UINT32(SLOW_MICROS, monitor.percentileMicros(93));
+}
+
+void test_alarm_clears_after_recovery()
+{
+  LatencyMonitor monitor(95, 5000);
+  for (int i = 0; i < 64; i++)
+    monitor.record(SLOW_MICROS);
+  TEST_ASSERT_TRUE(monitor.alarmActive());
+
+  // Sin dividir harían falta 64 * 19 = 1216 mediciones rápidas para que las lentas
+  // bajen del 5 %; al dividir, las lentas pierden peso cada 255 rápidas
+  int fast = 0;
+  while (monitor.alarmActive() && fast < 1216)
+  {
+    monitor.record(FAST_MICROS);
+    fast++;
+  }
+  TEST_ASSERT_FALSE(monitor.alarmActive());
+  TEST_ASSERT_LESS_THAN(1216, fast);
+  TEST_ASSERT_EQUAL_UINT32(2048, monitor.percentileMicros(95));
+  // El máximo no se divide: sigue siendo el peor caso desde el arranque
+  TEST_ASSERT_EQUAL_UINT32(SLOW_MICROS, monitor.maximum());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_monitor_reports_zero);
+  RUN_TEST(test_percentiles_of_two_groups);
+  RUN_TEST(test_short_latencies_share_first_bucket);
+  RUN_TEST(test_percentile_error_is_below_a_quarter);
+  RUN_TEST(test_alarm_waits_for_min_samples);
+  RUN_TEST(test_halving_keeps_proportions);
+  RUN_TEST(test_alarm_clears_after_recovery);
+  return UNITY_END();
+}
@@ -0,0 +1,182 @@
+// Emulador de la pantalla HD44780 y sustituto de LiquidCrystal
+// Los comandos van directo al emulador con instantes elegidos para comprobar los
+// tiempos de ocupado del datasheet; con LiquidCrystal el reloj es el virtual de
+// HostArduino, que avanza con las esperas de la librería igual que en el firmware.
+
+#include <unity.h>
+
+#include <Arduino.h>
+#include <LiquidCrystal.h>
+
+#include <string>
+
+#include "Hd44780.h"
+
+// Pantalla encendida, sin cursor, en el estado en que la deja LiquidCrystal::begin()
+static Hd44780 readyDisplay()
+{
+  Hd44780 lcd;
+  lcd.command(0x28, 0);   // Function set: 4 bits, 2 líneas
+  lcd.command(0x0C, 100); // Display on
+  lcd.command(0x01, 200); // Clear
+  lcd.command(0x06, 200 + Hd44780::CLEAR_EXEC_US); // Entry mode: incremento, sin desplazamiento
+  return lcd;
+}
+
+static void print(Hd44780& lcd, const char* text, unsigned long long& now)
+{
+  for (; *text != '\0'; text++)
+  {
+    now += Hd44780::EXEC_US;
+    lcd.data((uint8_t)*text, now);
+  }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_clear_and_home_are_slow()
+{
+  Hd44780 lcd = readyDisplay();
+  TEST_ASSERT_EQUAL_UINT32(0, lcd.busStats().busyViolations);
+
+  // Un dato antes de los 1.52 ms del clear llega con el controlador ocupado
+  lcd.command(0x01, 10000);
+  lcd.data('a', 10000 + Hd44780::CLEAR_EXEC_US - 1);
+  TEST_ASSERT_EQUAL_UINT32(1, lcd.busStats().busyViolations);
+  TEST_ASSERT_EQUAL_UINT32(2, lcd.busStats().clears);
+
+  // Return home (0x02 y 0x03) también tarda 1.52 ms
+  lcd.command(0x02, 20000);
+  lcd.data('b', 20000 + Hd44780::CLEAR_EXEC_US);
+  lcd.command(0x03, 30000);
+  lcd.data('c', 30000 + Hd44780::EXEC_US);
+  TEST_ASSERT_EQUAL_UINT32(2, lcd.busStats().busyViolations);
+
+  // El resto de los comandos y los datos tardan 37 us
+  lcd.command(0x80, 40000);
+  lcd.data('d', 40000 + Hd44780::EXEC_US - 1);
+  lcd.data('e', 40000 + 2 * Hd44780::EXEC_US - 1);
+  TEST_ASSERT_EQUAL_UINT32(3, lcd.busStats().busyViolations);
+  lcd.data('f', 40000 + 3 * Hd44780::EXEC_US - 1);
+  TEST_ASSERT_EQUAL_UINT32(3, lcd.busStats().busyViolations);
+}
+
+void test_cursor_moves()
+{
+  Hd44780 lcd = readyDisplay();
+  unsigned long long now = 10000;
+  lcd.command(0x80 | 0x43, now); // Línea 2, columna 3
+  print(lcd, "ab", now);
+  TEST_ASSERT_EQUAL('a', lcd.cell(1, 3));
+  TEST_ASSERT_EQUAL('b', lcd.cell(1, 4));
+  Hd44780::Frame frame = lcd.snapshot(now);
+  TEST_ASSERT_EQUAL_UINT8(1, frame.cursorRow);
+  TEST_ASSERT_EQUAL_UINT8(5, frame.cursorCol);
+  TEST_ASSERT_FALSE(frame.cursorVisible);
+
+  // Cursor a la izquierda y sobrescritura; con el cursor visible se dibuja como _
+  lcd.command(0x10, now += 100);
+  print(lcd, "c", now);
+  lcd.command(0x0E, now += 100);
+  TEST_ASSERT_EQUAL_STRING("+----------------+\n"
+                           "|                |\n"
+                           "|   ac_          |\n"
+                           "+----------------+\n",
+                           lcd.render().c_str());
+
+  // Al pasar la posición 39 de la primera línea el contador sigue en la segunda
+  lcd.command(0x80 | 38, now += 100);
+  print(lcd, "xyz", now);
+  TEST_ASSERT_EQUAL('z', lcd.cell(1, 0));
+
+  // Desplazar la pantalla a la izquierda muestra la columna 16 en la 15
+  lcd.command(0x80 | 16, now += 100);
+  print(lcd, "q", now);
+  lcd.command(0x18, now += 100);
+  TEST_ASSERT_EQUAL('q', lcd.cell(0, 15));
+  lcd.command(0x02, now += 100); // Home deshace el desplazamiento
+  TEST_ASSERT_EQUAL(' ', lcd.cell(0, 15));
+}
+
+void test_cgram_glyphs()
+{
+  Hd44780 lcd = readyDisplay();
+  const uint8_t drop[8] = {0x04, 0x04, 0x0E, 0x0E, 0x1F, 0x1F, 0x0E, 0x00};
+  unsigned long long now = 10000;
+  lcd.command(0x40 | (2 << 3), now); // CGRAM, carácter 2
+  for (uint8_t row : drop)
+    lcd.data(row | 0xE0, now += Hd44780::EXEC_US); // Los 3 bits altos no se guardan
+  TEST_ASSERT_EQUAL_STRING("..#..\n"
+                           "..#..\n"
+                           ".###.\n"
+                           ".###.\n"
+                           "#####\n"
+                           "#####\n"
+                           ".###.\n"
+                           ".....\n",
+                           lcd.renderGlyph(2).c_str());
+
+  // Volver a la DDRAM y escribir el carácter 2; el texto lo muestra como #
+  lcd.command(0x80, now += 100);
+  lcd.data(2, now += Hd44780::EXEC_US);
+  lcd.data(0xDF, now += Hd44780::EXEC_US); // Símbolo de grado de la ROM, sin equivalente ASCII
+  TEST_ASSERT_EQUAL('#', lcd.cell(0, 0));
+  TEST_ASSERT_EQUAL('?', lcd.cell(0, 1));
+}
+
+void test_frames_record_stable_content()
+{
+  Hd44780 lcd = readyDisplay();
+  unsigned long long now = 10000;
+  print(lcd, "uno", now);
+  // Lo que cambia antes de STABLE_FRAME_US no se guarda como un frame aparte
+  lcd.command(0x01, now += 100);
+  now += Hd44780::CLEAR_EXEC_US;
+  print(lcd, "dos", now);
+  lcd.command(0x01, now += Hd44780::STABLE_FRAME_US);
+  now += Hd44780::CLEAR_EXEC_US;
+  print(lcd, "tres", now);
+  lcd.flush(now);
+
+  const std::vector<Hd44780::Frame>& frames = lcd.frames();
+  TEST_ASSERT_EQUAL_UINT32(2, frames.size());
+  TEST_ASSERT_EQUAL_STRING("dos             ", frames[0].lines[0].c_str());
+  TEST_ASSERT_EQUAL_STRING("tres            ", frames[1].lines[0].c_str());
+}
+
+void test_liquid_crystal_waits_like_the_library()
+{
+  LiquidCrystal lcd(0, 1, 2, 3, 4, 5);
+  lcd.begin(16, 2);
+  unsigned long start = micros();
+  lcd.clear();
+  TEST_ASSERT_GREATER_OR_EQUAL(start + LiquidCrystal::CLEAR_DELAY_US, micros());
+  lcd.setCursor(0, 1);
+  lcd.print("Humedad: ");
+  lcd.print(45.5);
+  lcd.home();
+  lcd.print('H');
+
+  // La librería espera lo suficiente: ninguna escritura llega con la pantalla ocupada
+  const Hd44780::BusStats& stats = lcd.emulator().busStats();
+  TEST_ASSERT_EQUAL_UINT32(0, stats.busyViolations);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.clears);
+  TEST_ASSERT_EQUAL_UINT32(15, stats.dataWrites);
+  TEST_ASSERT_EQUAL_STRING("+----------------+\n"
+                           "|H               |\n"
+                           "|Humedad: 45.50  |\n"
+                           "+----------------+\n",
+                           lcd.emulator().render().c_str());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_clear_and_home_are_slow);
+  RUN_TEST(test_cursor_moves);
+  RUN_TEST(test_cgram_glyphs);
+  RUN_TEST(test_frames_record_stable_content);
+  RUN_TEST(test_liquid_crystal_waits_like_the_library);
+  return UNITY_END();
+}
@@ -0,0 +1,131 @@
+// Ajuste del pronóstico de humedad contra el modelo del suelo de la simulación
+// Por debajo de la capacidad de campo soilStep() sigue el mismo balance que supone el
+// pronóstico, con evaporación = evaporationCoeff · 100 / fieldCapacity, así que el
+// ajuste tiene que recuperar los coeficientes de la cama a partir de lo que ve la sonda.
+
+#include <unity.h>
+
+#include "moisture_forecaster.h"
+#include "soil_model.h"
+
+const float STEP_SECONDS = 1.0f;
+const float PUMP_ON_BELOW = 30.0f;   // Histéresis del riego, lejos de la capacidad de campo
+const float PUMP_OFF_ABOVE = 45.0f;
+
+struct Bed {
+  SoilParams params;
+  SoilState state;
+  MoistureForecaster forecaster;
+  bool pumpOn = false;
+  unsigned long nowMs = 0;
+
+  Bed()
+  {
+    state.moisture = state.probe = 40.0f;
+  }
+
+  float temperature() const { return diurnalTemperature(22.0f, 8.0f, nowMs / 3600000.0f); }
+
+  // Avanza la cama con el riego por histéresis y le pasa cada lectura al pronóstico
+  void run(float hours)
+  {
+    unsigned long steps = (unsigned long)(hours * 3600 / STEP_SECONDS);
+    for (unsigned long i = 0; i < steps; i++)
+    {
+      bool wasOn = pumpOn;
+      float t = temperature();
+      soilStep(params, state, STEP_SECONDS, t, wasOn, 0);
+      nowMs += (unsigned long)(STEP_SECONDS * 1000);
+      forecaster.observe(state.probe, t, wasOn, nowMs);
+      if (state.probe < PUMP_ON_BELOW)
+        pumpOn = true;
+      else if (state.probe > PUMP_OFF_ABOVE)
+        pumpOn = false;
+    }
+  }
+
+  float expectedEvaporation() const { return params.evaporationCoeff * 100 / params.fieldCapacity; }
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_not_ready_before_min_samples()
+{
+  Bed bed;
+  bed.run(MoistureForecaster::SAMPLE_MS / 3600000.0f);
+  TEST_ASSERT_FALSE(bed.forecaster.ready());
+}
+
+void test_recovers_bed_coefficients()
+{
+  Bed bed;
+  bed.run(48);
+  TEST_ASSERT_TRUE(bed.forecaster.ready());
+  float evaporation = bed.expectedEvaporation();
+  TEST_ASSERT_FLOAT_WITHIN(evaporation * 0.05f, evaporation, bed.forecaster.evaporationCoeff());
+  TEST_ASSERT_FLOAT_WITHIN(bed.params.pumpGain * 0.1f, bed.params.pumpGain, bed.forecaster.pumpGain());
+}
+
+void test_recovers_other_soil()
+{
+  Bed bed;
+  bed.params.fieldCapacity = 55.0f;
+  bed.params.evaporationCoeff = 0.12f;
+  bed.params.pumpGain = 18.0f;
+  bed.run(48);
+  float evaporation = bed.expectedEvaporation();
+  TEST_ASSERT_FLOAT_WITHIN(evaporation * 0.05f, evaporation, bed.forecaster.evaporationCoeff());
+  TEST_ASSERT_FLOAT_WITHIN(bed.params.pumpGain * 0.1f, bed.params.pumpGain, bed.forecaster.pumpGain());
+}
+
+void test_follows_bed_changes()
+{
+  Bed bed;
+  bed.run(24);
+  // La cama empieza a secarse más rápido (más sol, suelo más suelto)
+  bed.params.evaporationCoeff = 0.35f;
+  bed.run(24);
+  float evaporation = bed.expectedEvaporation();
+  TEST_ASSERT_FLOAT_WITHIN(evaporation * 0.05f, evaporation, bed.forecaster.evaporationCoeff());
+}
+
+void test_prediction_matches_dry_down()
+{
+  Bed bed;
+  bed.run(48);
+  // Sin regar, a temperatura constante
+  bed.state.moisture = bed.state.probe = 45.0f;
+  const float temperature = 25.0f;
+  SoilState state = bed.state;
+  for (int i = 0; i < 3 * 3600; i++)
+    soilStep(bed.params, state, 1.0f, temperature, false, 0);
+  float predicted = bed.forecaster.predict(45.0f, temperature, 180);
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, state.moisture, predicted);
+
+  // El cruce con un umbral es el de la misma curva
+  uint16_t minutes = bed.forecaster.minutesUntil(45.0f, state.moisture, temperature);
+  TEST_ASSERT_FLOAT_WITHIN(10, 180, minutes);
+}
+
+void test_crossing_limits()
+{
+  Bed bed;
+  bed.run(48);
+  TEST_ASSERT_EQUAL_UINT16(0, bed.forecaster.minutesUntil(30.0f, 35.0f, 25.0f));
+  // Sin calor no se seca, y un umbral muy bajo queda fuera del horizonte
+  TEST_ASSERT_EQUAL_UINT16(MoistureForecaster::NO_CROSSING, bed.forecaster.minutesUntil(45.0f, 30.0f, 0.0f));
+  TEST_ASSERT_EQUAL_UINT16(MoistureForecaster::NO_CROSSING, bed.forecaster.minutesUntil(45.0f, 0.01f, 25.0f));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_not_ready_before_min_samples);
+  RUN_TEST(test_recovers_bed_coefficients);
+  RUN_TEST(test_recovers_other_soil);
+  RUN_TEST(test_follows_bed_changes);
+  RUN_TEST(test_prediction_matches_dry_down);
+  RUN_TEST(test_crossing_limits);
+  return UNITY_END();
+}
@@ -0,0 +1,68 @@
+// Reproducibilidad del análisis de Monte Carlo (montecarlo.h)
+// Cada realización depende solo de la semilla y de su número: con cualquier cantidad
+// de hilos el resultado tiene que ser el mismo, bit a bit.
+
+#include <unity.h>
+
+#include <string.h>
+
+#include "montecarlo.h"
+
+const unsigned RUNS = 6;
+const unsigned DAYS = 1;
+const uint64_t SEED = 7;
+
+static bool sameScenario(const Scenario& a, const Scenario& b)
+{
+  return memcmp(&a.soil, &b.soil, sizeof(SoilParams)) == 0 && a.temperatureMean == b.temperatureMean &&
+         a.temperatureSwing == b.temperatureSwing && a.startHour == b.startHour && a.humidity == b.humidity &&
+         a.probeNoise == b.probeNoise && a.probeBias == b.probeBias && a.noiseSeed == b.noiseSeed &&
+         a.days.size() == b.days.size() && memcmp(a.days.data(), b.days.data(), a.days.size() * sizeof(Day)) == 0;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_same_seed_draws_same_scenario()
+{
+  SoilParams reference;
+  Scenario first = drawScenario(streamSeed(SEED, 3), 5, reference);
+  Scenario again = drawScenario(streamSeed(SEED, 3), 5, reference);
+  TEST_ASSERT_TRUE(sameScenario(first, again));
+  TEST_ASSERT_EQUAL_UINT32(5, first.days.size());
+
+  // Otra realización o otra semilla sortean otro escenario
+  TEST_ASSERT_FALSE(sameScenario(first, drawScenario(streamSeed(SEED, 4), 5, reference)));
+  TEST_ASSERT_FALSE(sameScenario(first, drawScenario(streamSeed(SEED + 1, 3), 5, reference)));
+}
+
+void test_results_do_not_depend_on_threads()
+{
+  SoilParams reference;
+  std::vector<Candidate> candidates = allCandidates();
+  std::vector<Outcome> single = runAll(candidates, RUNS, DAYS, 1, SEED, reference);
+  std::vector<Outcome> parallel = runAll(candidates, RUNS, DAYS, 4, SEED, reference);
+  TEST_ASSERT_EQUAL_UINT32(RUNS * candidates.size(), single.size());
+  TEST_ASSERT_EQUAL_UINT32(single.size(), parallel.size());
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(single.data(), parallel.data(), single.size() * sizeof(Outcome),
+                                   "el resultado cambia con la cantidad de hilos");
+}
+
+void test_run_depends_only_on_its_index()
+{
+  // Las primeras realizaciones dan lo mismo aunque se pidan más, con más hilos que realizaciones
+  SoilParams reference;
+  std::vector<Candidate> candidates = allCandidates();
+  std::vector<Outcome> few = runAll(candidates, 2, DAYS, 3, SEED, reference);
+  std::vector<Outcome> more = runAll(candidates, RUNS, DAYS, 2, SEED, reference);
+  TEST_ASSERT_EQUAL_MEMORY(few.data(), more.data(), few.size() * sizeof(Outcome));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_same_seed_draws_same_scenario);
+  RUN_TEST(test_results_do_not_depend_on_threads);
+  RUN_TEST(test_run_depends_only_on_its_index);
+  return UNITY_END();
+}
@@ -0,0 +1,151 @@
+// Planificación del riego por tarifa con tres ventanas de precios distintos
+// Ninguna configuración del repositorio tiene tarifas, así que el firmware y el análisis
+// de Monte Carlo no pasan por PumpScheduler; aquí las ventanas se definen en la prueba.
+// El pronóstico se ajusta con un secado exponencial a temperatura fija, y la humedad de
+// cada caso se elige para que cruce el mínimo en una cantidad conocida de minutos.
+
+#include <unity.h>
+
+#include <math.h>
+
+#include "moisture_forecaster.h"
+#include "pump_scheduler.h"
+#include "tariff.h"
+
+// Noche barata, día caro y tarde intermedia; la tarde solo tiene una ventana más barata
+// después de la medianoche
+const TariffWindow WINDOWS[] = {
+  {0, 6 * 60, 0.10f},
+  {6 * 60, 18 * 60, 0.30f},
+  {18 * 60, 24 * 60, 0.20f},
+};
+const uint8_t WINDOW_COUNT = sizeof(WINDOWS) / sizeof(WINDOWS[0]);
+
+const float TEMPERATURE = 20.0f;
+const float MIN_HUMIDITY = 40.0f;
+const float EVAPORATION = 0.5f;        // Secado de la cama de prueba: 0.1 %/h por % a 20 °C
+
+const uint16_t NIGHT = 2 * 60;
+const uint16_t DAY = 10 * 60;          // 8 h hasta la tarde y 14 h hasta la noche
+const uint16_t LATE_EVENING = 23 * 60 + 55; // 5 min hasta la medianoche
+
+// Pronóstico ajustado con dos horas de la cama secándose sin regar
+static MoistureForecaster trainedForecaster()
+{
+  MoistureForecaster forecaster;
+  float humidity = 60.0f;
+  for (unsigned long ms = 0; ms <= 2 * 3600000UL; ms += 10000)
+  {
+    forecaster.observe(humidity, TEMPERATURE, false, ms);
+    humidity *= expf(-EVAPORATION * TEMPERATURE / 100 * 10 / 3600.0f);
+  }
+  return forecaster;
+}
+
+// Humedad que, según el pronóstico, baja del mínimo en minutes minutos
+static float humidityCrossingIn(const MoistureForecaster& forecaster, uint16_t minutes)
+{
+  float decay = forecaster.evaporationCoeff() * TEMPERATURE / 100;
+  return MIN_HUMIDITY * expf(decay * (minutes + 0.5f) / 60.0f);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_window_lookup()
+{
+  TEST_ASSERT_EQUAL_PTR(&WINDOWS[0], tariffAt(WINDOWS, WINDOW_COUNT, 0));
+  TEST_ASSERT_EQUAL_PTR(&WINDOWS[0], tariffAt(WINDOWS, WINDOW_COUNT, 6 * 60 - 1));
+  TEST_ASSERT_EQUAL_PTR(&WINDOWS[1], tariffAt(WINDOWS, WINDOW_COUNT, 6 * 60));
+  TEST_ASSERT_EQUAL_PTR(&WINDOWS[2], tariffAt(WINDOWS, WINDOW_COUNT, MINUTES_PER_DAY - 1));
+  TEST_ASSERT_NULL(tariffAt(WINDOWS, 0, NIGHT));
+}
+
+void test_minutes_until_cheaper()
+{
+  // En la ventana más barata no hay a dónde posponer
+  TEST_ASSERT_EQUAL_UINT16(NO_CHEAPER_WINDOW, minutesUntilCheaper(WINDOWS, WINDOW_COUNT, NIGHT));
+  TEST_ASSERT_EQUAL_UINT16(NO_CHEAPER_WINDOW, minutesUntilCheaper(WINDOWS, WINDOW_COUNT, 0));
+  // De día la más cercana de las dos más baratas es la tarde
+  TEST_ASSERT_EQUAL_UINT16(8 * 60, minutesUntilCheaper(WINDOWS, WINDOW_COUNT, DAY));
+  TEST_ASSERT_EQUAL_UINT16(1, minutesUntilCheaper(WINDOWS, WINDOW_COUNT, 18 * 60 - 1));
+  // De tarde la única más barata empieza después de la medianoche
+  TEST_ASSERT_EQUAL_UINT16(6 * 60, minutesUntilCheaper(WINDOWS, WINDOW_COUNT, 18 * 60));
+  TEST_ASSERT_EQUAL_UINT16(5, minutesUntilCheaper(WINDOWS, WINDOW_COUNT, LATE_EVENING));
+  TEST_ASSERT_EQUAL_UINT16(1, minutesUntilCheaper(WINDOWS, WINDOW_COUNT, MINUTES_PER_DAY - 1));
+}
+
+void test_forecaster_learns_drying()
+{
+  MoistureForecaster forecaster = trainedForecaster();
+  TEST_ASSERT_TRUE(forecaster.ready());
+  TEST_ASSERT_FLOAT_WITHIN(EVAPORATION * 0.02f, EVAPORATION, forecaster.evaporationCoeff());
+  const uint16_t minutes[] = {5, 8, PumpScheduler::GUARD_MINUTES, PumpScheduler::GUARD_MINUTES + 1, 60, 300};
+  for (uint16_t m : minutes)
+    TEST_ASSERT_EQUAL_UINT16(m, forecaster.minutesUntil(humidityCrossingIn(forecaster, m), MIN_HUMIDITY, TEMPERATURE));
+}
+
+void test_never_runs_when_not_needed()
+{
+  MoistureForecaster forecaster = trainedForecaster();
+  PumpScheduler scheduler(WINDOWS, WINDOW_COUNT, forecaster);
+  TEST_ASSERT_FALSE(scheduler.shouldRun(false, MIN_HUMIDITY - 5, TEMPERATURE, MIN_HUMIDITY, NIGHT));
+  TEST_ASSERT_FALSE(scheduler.shouldRun(false, MIN_HUMIDITY - 5, TEMPERATURE, MIN_HUMIDITY, DAY));
+}
+
+void test_cheapest_window_follows_crop_rule()
+{
+  // Aunque falten horas para llegar al mínimo, de noche se llena hasta el máximo
+  MoistureForecaster forecaster = trainedForecaster();
+  PumpScheduler scheduler(WINDOWS, WINDOW_COUNT, forecaster);
+  float humidity = humidityCrossingIn(forecaster, 300);
+  TEST_ASSERT_TRUE(scheduler.shouldRun(true, humidity, TEMPERATURE, MIN_HUMIDITY, NIGHT));
+  TEST_ASSERT_TRUE(scheduler.shouldRun(true, humidity, TEMPERATURE, MIN_HUMIDITY, 0));
+}
+
+void test_expensive_window_without_model_runs()
+{
+  MoistureForecaster untrained;
+  TEST_ASSERT_FALSE(untrained.ready());
+  PumpScheduler scheduler(WINDOWS, WINDOW_COUNT, untrained);
+  TEST_ASSERT_TRUE(scheduler.shouldRun(true, MIN_HUMIDITY + 10, TEMPERATURE, MIN_HUMIDITY, DAY));
+}
+
+void test_expensive_window_postpones_with_model()
+{
+  MoistureForecaster forecaster = trainedForecaster();
+  PumpScheduler scheduler(WINDOWS, WINDOW_COUNT, forecaster);
+  // Lejos del mínimo se espera a la tarde; dentro del horizonte de guarda se riega
+  TEST_ASSERT_FALSE(scheduler.shouldRun(true, humidityCrossingIn(forecaster, 60), TEMPERATURE, MIN_HUMIDITY, DAY));
+  TEST_ASSERT_FALSE(scheduler.shouldRun(true, humidityCrossingIn(forecaster, PumpScheduler::GUARD_MINUTES + 1), TEMPERATURE,
+                                        MIN_HUMIDITY, DAY));
+  TEST_ASSERT_TRUE(scheduler.shouldRun(true, humidityCrossingIn(forecaster, PumpScheduler::GUARD_MINUTES), TEMPERATURE,
+                                       MIN_HUMIDITY, DAY));
+  // En el mínimo o debajo no se espera aunque el pronóstico lo permita
+  TEST_ASSERT_TRUE(scheduler.shouldRun(true, MIN_HUMIDITY, TEMPERATURE, MIN_HUMIDITY, DAY));
+}
+
+void test_horizon_capped_by_cheaper_window()
+{
+  // A 5 minutos de la ventana barata alcanza con no bajar del mínimo hasta entonces
+  MoistureForecaster forecaster = trainedForecaster();
+  PumpScheduler scheduler(WINDOWS, WINDOW_COUNT, forecaster);
+  float humidity = humidityCrossingIn(forecaster, 8);
+  TEST_ASSERT_TRUE(scheduler.shouldRun(true, humidity, TEMPERATURE, MIN_HUMIDITY, DAY));
+  TEST_ASSERT_FALSE(scheduler.shouldRun(true, humidity, TEMPERATURE, MIN_HUMIDITY, LATE_EVENING));
+  TEST_ASSERT_TRUE(scheduler.shouldRun(true, humidityCrossingIn(forecaster, 5), TEMPERATURE, MIN_HUMIDITY, LATE_EVENING));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_window_lookup);
+  RUN_TEST(test_minutes_until_cheaper);
+  RUN_TEST(test_forecaster_learns_drying);
+  RUN_TEST(test_never_runs_when_not_needed);
+  RUN_TEST(test_cheapest_window_follows_crop_rule);
+  RUN_TEST(test_expensive_window_without_model_runs);
+  RUN_TEST(test_expensive_window_postpones_with_model);
+  RUN_TEST(test_horizon_capped_by_cheaper_window);
+  return UNITY_END();
+}
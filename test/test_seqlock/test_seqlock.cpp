@@ -0,0 +1,123 @@
+// SeqLock con un escritor y varios lectores en hilos distintos
+// Cada valor escrito tiene todos los campos derivados del mismo contador, así que un
+// lector que copie la mitad de una escritura y la mitad de otra ve campos distintos.
+// El entorno native_test compila con -fsanitize=thread, que además informa cualquier
+// acceso al valor o al contador que no esté ordenado.
+
+#include <unity.h>
+
+#include <stdint.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "seqlock.h"
+
+// Tamaño parecido a SensorSnapshot y RelayWear, con campos de distinto ancho
+struct Sample {
+  uint32_t counter;
+  uint16_t low;
+  uint16_t high;
+  uint8_t parity;
+  uint32_t inverted;
+  uint64_t squared;
+};
+
+static Sample makeSample(uint32_t counter)
+{
+  Sample sample;
+  sample.counter = counter;
+  sample.low = counter & 0xFFFF;
+  sample.high = counter >> 16;
+  sample.parity = counter & 1;
+  sample.inverted = ~counter;
+  sample.squared = (uint64_t)counter * counter;
+  return sample;
+}
+
+static bool consistent(const Sample& sample)
+{
+  Sample expected = makeSample(sample.counter);
+  return sample.low == expected.low && sample.high == expected.high && sample.parity == expected.parity &&
+         sample.inverted == expected.inverted && sample.squared == expected.squared;
+}
+
+const uint32_t WRITES = 200000;
+const unsigned READERS = 3;
+
+void setUp() {}
+void tearDown() {}
+
+void test_initial_value_is_zero()
+{
+  SeqLock<Sample> lock;
+  Sample sample = lock.read();
+  TEST_ASSERT_EQUAL_UINT32(0, sample.counter);
+  TEST_ASSERT_EQUAL_UINT32(0, sample.inverted);
+  TEST_ASSERT_EQUAL_UINT8(0, lock.version());
+}
+
+void test_version_changes_on_each_write()
+{
+  SeqLock<Sample> lock;
+  uint8_t before = lock.version();
+  lock.write(makeSample(1));
+  TEST_ASSERT_TRUE(lock.version() != before);
+  TEST_ASSERT_EQUAL_UINT8(0, lock.version() & 1);
+  TEST_ASSERT_EQUAL_UINT32(1, lock.read().counter);
+}
+
+void test_concurrent_readers_see_whole_writes()
+{
+  SeqLock<Sample> lock;
+  lock.write(makeSample(0)); // El valor inicial (todo en cero) no sigue la regla de los campos
+  std::atomic<bool> done(false);
+  std::atomic<uint32_t> torn(0);
+  std::atomic<uint32_t> backwards(0);
+  std::atomic<uint32_t> reads(0);
+
+  std::vector<std::thread> readers;
+  for (unsigned r = 0; r < READERS; r++)
+  {
+    readers.emplace_back([&]() {
+      uint32_t last = 0, count = 0;
+      while (!done.load(std::memory_order_acquire))
+      {
+        Sample sample = lock.read();
+        if (!consistent(sample))
+          torn++;
+        // Un solo escritor que solo avanza: un lector nunca ve un valor anterior
+        if (sample.counter < last)
+          backwards++;
+        last = sample.counter;
+        count++;
+      }
+      reads += count;
+    });
+  }
+
+  std::thread writer([&]() {
+    for (uint32_t i = 1; i <= WRITES; i++)
+      lock.write(makeSample(i));
+    done.store(true, std::memory_order_release);
+  });
+
+  writer.join();
+  for (std::thread& reader : readers)
+    reader.join();
+
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, torn.load(), "un lector copió una escritura a medias");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, backwards.load(), "un lector vio un valor anterior al que ya había leído");
+  TEST_ASSERT_TRUE(reads.load() > 0);
+  TEST_ASSERT_EQUAL_UINT32(WRITES, lock.read().counter);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_initial_value_is_zero);
+  RUN_TEST(test_version_changes_on_each_write);
+  RUN_TEST(test_concurrent_readers_see_whole_writes);
+  return UNITY_END();
+}
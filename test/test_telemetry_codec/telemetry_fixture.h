@@ -0,0 +1,257 @@
+// Registros de prueba y los envíos que arma TelemetryEncoder con ellos
+// Lo usan test_telemetry_codec.cpp, que comprueba que el codificador arma los mismos
+// envíos, y test_telemetry_decode.py, que comprueba que tools/telemetry_decode.py los
+// vuelve a convertir en los mismos registros. Si cambia el formato cambian los dos lados.
+//
+// Cada línea "r" es un registro (tiempo, temperatura, humedad, estado, relé) y cada
+// línea "f" el contenido de un envío en hexadecimal. Se cierra un envío cada 50
+// registros o antes si el siguiente no cabe en TELEMETRY_FRAME_BYTES. Los registros
+// incluyen la vuelta del tiempo en 65535, un paso de tiempo irregular, saltos de humedad
+// de más de un byte de varint, repeticiones más largas que MAX_RUN y un registro
+// completo cada KEYFRAME_INTERVAL.
+
+#ifndef TELEMETRY_FIXTURE_H
+#define TELEMETRY_FIXTURE_H
+
+static const char TELEMETRY_FIXTURE[] = R"(
+r 65500 512 301 5 0
+r 65501 512 300 5 0
+r 65502 512 300 5 0
+r 65503 512 301 5 0
+r 65504 512 300 5 0
+r 65505 512 300 5 0
+r 65506 512 301 5 0
+r 65507 512 300 4 1
+r 65508 512 300 4 1
+r 65509 512 301 4 1
+r 65510 512 300 4 1
+r 65511 512 300 4 1
+r 65512 512 301 4 1
+r 65513 512 300 4 1
+r 65514 512 300 4 1
+r 65515 512 301 4 1
+r 65516 512 300 4 1
+r 65517 512 300 4 1
+r 65518 512 301 4 1
+r 65519 512 300 4 1
+r 65522 512 300 4 1
+r 65523 512 301 4 1
+r 65524 512 300 5 2
+r 65525 512 300 5 2
+r 65526 512 301 5 2
+r 65527 512 300 5 2
+r 65528 512 300 5 2
+r 65529 512 301 5 2
+r 65530 512 300 5 2
+r 65531 512 300 5 2
+r 65532 512 301 5 2
+r 65533 512 300 5 2
+r 65534 512 300 5 2
+r 65535 512 301 5 2
+r 0 512 300 5 2
+r 1 512 300 5 2
+r 2 512 301 5 2
+r 3 512 300 4 3
+r 4 512 300 4 3
+r 5 512 301 4 3
+r 6 509 300 4 3
+r 7 509 300 4 3
+r 8 509 301 4 3
+r 9 509 300 4 3
+r 10 509 300 4 3
+r 11 509 301 4 3
+r 12 509 300 4 3
+r 13 509 300 4 3
+r 14 509 301 4 3
+r 15 509 300 4 3
+r 16 509 700 4 3
+r 17 509 701 4 3
+r 18 509 700 5 4
+r 19 509 700 5 4
+r 20 509 701 5 4
+r 21 509 300 5 4
+r 22 509 300 5 4
+r 23 509 301 5 4
+r 24 509 300 5 4
+r 25 509 300 5 4
+r 26 509 300 5 4
+r 27 509 300 5 4
+r 28 509 300 5 4
+r 29 509 300 5 4
+r 30 509 300 5 4
+r 31 509 300 5 4
+r 32 509 300 5 4
+r 33 509 300 5 4
+r 34 509 300 5 4
+r 35 509 300 5 4
+r 36 509 300 5 4
+r 37 509 300 5 4
+r 38 509 300 5 4
+r 39 509 300 5 4
+r 40 509 300 5 4
+r 41 509 300 5 4
+r 42 509 300 5 4
+r 43 509 300 5 4
+r 44 509 300 5 4
+r 45 509 300 5 4
+r 46 509 300 5 4
+r 47 509 300 5 4
+r 48 509 300 5 4
+r 49 509 300 5 4
+r 50 509 300 5 4
+r 51 509 300 5 4
+r 52 509 300 5 4
+r 53 509 300 5 4
+r 54 509 300 5 4
+r 55 509 300 5 4
+r 56 509 300 5 4
+r 57 509 300 5 4
+r 58 509 300 5 4
+r 59 509 300 5 4
+r 60 509 300 5 4
+r 61 509 300 5 4
+r 62 509 300 5 4
+r 63 509 300 5 4
+r 64 509 300 5 4
+r 65 509 300 5 4
+r 66 509 300 5 4
+r 67 509 300 5 4
+r 68 509 300 5 4
+r 69 509 300 5 4
+r 70 509 300 5 4
+r 71 509 300 5 4
+r 72 509 300 5 4
+r 73 509 300 5 4
+r 74 509 300 5 4
+r 75 509 300 5 4
+r 76 509 300 5 4
+r 77 509 300 5 4
+r 78 509 300 5 4
+r 79 509 300 5 4
+r 80 509 300 5 4
+r 81 509 300 5 4
+r 82 509 300 5 4
+r 83 509 300 5 4
+r 84 509 300 5 4
+r 85 509 300 5 4
+r 86 509 300 5 4
+r 87 509 300 5 4
+r 88 509 300 5 4
+r 89 509 300 5 4
+r 90 509 300 5 4
+r 91 509 300 5 4
+r 92 509 300 5 4
+r 93 509 300 5 4
+r 94 509 300 5 4
+r 95 509 300 5 4
+r 96 509 300 5 4
+r 97 509 300 5 4
+r 98 509 300 5 4
+r 99 509 300 5 4
+r 100 509 300 5 4
+r 101 509 300 5 4
+r 102 509 300 5 4
+r 103 509 300 5 4
+r 104 509 300 5 4
+r 105 509 300 5 4
+r 106 509 300 5 4
+r 107 509 300 5 4
+r 108 509 300 5 4
+r 109 509 300 5 4
+r 110 509 300 5 4
+r 111 509 300 5 4
+r 112 509 300 5 4
+r 113 509 300 5 4
+r 114 509 300 5 4
+r 115 509 300 5 4
+r 116 509 300 5 4
+r 117 509 300 5 4
+r 118 509 300 5 4
+r 119 509 300 5 4
+r 120 509 300 5 4
+r 121 509 300 5 4
+r 122 509 300 5 4
+r 123 509 300 5 4
+r 124 509 300 5 4
+r 125 509 300 5 4
+r 126 509 300 5 4
+r 127 509 300 5 4
+r 128 509 300 5 4
+r 129 509 300 5 4
+r 130 509 300 5 4
+r 131 509 300 5 4
+r 132 509 300 5 4
+r 133 509 300 5 4
+r 134 509 300 5 4
+r 135 509 300 5 4
+r 136 509 300 5 4
+r 137 509 300 5 4
+r 138 509 300 5 4
+r 139 509 300 5 4
+r 140 509 300 5 4
+r 141 509 300 5 4
+r 142 509 300 5 4
+r 143 509 300 5 4
+r 144 509 300 5 4
+r 145 509 300 5 4
+r 146 509 300 5 4
+r 147 509 300 5 4
+r 148 509 300 5 4
+r 149 509 300 5 4
+r 150 509 300 5 4
+r 151 509 300 5 4
+r 152 509 300 5 4
+r 153 509 300 5 4
+r 154 509 300 5 4
+r 155 509 300 5 4
+r 156 509 300 5 4
+r 157 509 300 5 4
+r 158 509 300 5 4
+r 159 509 300 5 4
+r 160 509 300 5 4
+r 161 509 300 5 4
+r 162 509 300 5 4
+r 163 509 300 5 4
+r 164 509 300 5 4
+r 165 509 300 5 4
+r 166 509 300 9 4
+r 167 509 300 9 4
+r 168 509 300 9 4
+r 169 509 300 9 4
+r 170 509 300 9 4
+r 40171 509 300 9 4
+r 40172 509 300 9 4
+r 40173 509 300 9 4
+r 40174 509 300 9 4
+r 40175 509 300 9 4
+r 40176 509 300 9 4
+r 40177 509 300 9 4
+r 40178 509 300 9 4
+r 40179 509 300 9 4
+r 40180 509 300 9 4
+r 40181 509 300 9 4
+r 40182 509 300 9 4
+r 40183 509 300 9 4
+r 40184 509 300 9 4
+r 40185 509 300 9 4
+r 40186 509 300 9 4
+r 40187 509 300 9 4
+r 40188 509 300 9 4
+r 40189 509 300 9 4
+r 40190 509 300 9 4
+r 40191 509 300 9 4
+r 40192 509 300 9 4
+r 40193 509 300 9 4
+r 40194 509 300 9 4
+r 40195 509 300 9 4
+f ffdcff038004ad02050005020181040204018104021c0101028104020401810402
+f 04018104020401810402040101040503021c01020281040204018104020401810402
+f 040181040204018104021c01010281040206050181040204018104020401810402
+f 0401
+f 04a00604021c01020281040204a106810402040185ff1efd03ac0205040102a2
+f 9cff5efd03ac020504010294
+f aaff9e01fd03ac020504010286
+f 08088401ff8e0301808f0397
+)";
+
+#endif
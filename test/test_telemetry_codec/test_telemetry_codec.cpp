@@ -0,0 +1,163 @@
+// Codificador de la telemetría: envíos esperados y límites del buffer
+// Los envíos de telemetry_fixture.h son los que descomprime test_telemetry_decode.py,
+// así que entre las dos pruebas cubren el camino completo del firmware a la herramienta.
+
+#include <unity.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "telemetry.h"
+#include "telemetry_codec.h"
+#include "telemetry_fixture.h"
+
+const unsigned FLUSH_RECORDS = 50; // Como en telemetry_fixture.h
+
+struct Record {
+  uint16_t values[TELEMETRY_FIELDS];
+};
+
+static std::vector<Record> records;
+static std::vector<std::string> frames;
+
+static void loadFixture()
+{
+  records.clear();
+  frames.clear();
+  const char* line = TELEMETRY_FIXTURE;
+  while (*line != '\0')
+  {
+    const char* end = strchr(line, '\n');
+    std::string text(line, end != NULL ? end - line : strlen(line));
+    if (text.compare(0, 2, "r ") == 0)
+    {
+      Record record;
+      unsigned v[TELEMETRY_FIELDS];
+      TEST_ASSERT_EQUAL_INT(TELEMETRY_FIELDS, sscanf(text.c_str() + 2, "%u %u %u %u %u", &v[0], &v[1], &v[2], &v[3], &v[4]));
+      for (uint8_t i = 0; i < TELEMETRY_FIELDS; i++)
+        record.values[i] = v[i];
+      records.push_back(record);
+    }
+    else if (text.compare(0, 2, "f ") == 0)
+      frames.push_back(text.substr(2));
+    line = end != NULL ? end + 1 : line + text.size();
+  }
+}
+
+static std::string hex(const uint8_t* data, uint8_t length)
+{
+  std::string text;
+  char digits[3];
+  for (uint8_t i = 0; i < length; i++)
+  {
+    snprintf(digits, sizeof(digits), "%02x", data[i]);
+    text += digits;
+  }
+  return text;
+}
+
+void setUp() { loadFixture(); }
+void tearDown() {}
+
+void test_fixture_covers_the_codes()
+{
+  TEST_ASSERT_GREATER_THAN(2 * TelemetryEncoder::KEYFRAME_INTERVAL, records.size());
+  TEST_ASSERT_GREATER_THAN(1, frames.size());
+}
+
+void test_encoder_builds_fixture_frames()
+{
+  uint8_t payload[TELEMETRY_FRAME_BYTES];
+  TelemetryEncoder encoder(payload, TELEMETRY_FRAME_BYTES);
+  std::vector<std::string> built;
+  unsigned count = 0;
+  for (const Record& record : records)
+  {
+    if (!encoder.push(record.values))
+    {
+      encoder.finish();
+      built.push_back(hex(payload, encoder.size()));
+      encoder.clear();
+      TEST_ASSERT_TRUE(encoder.push(record.values));
+    }
+    if (++count % FLUSH_RECORDS == 0)
+    {
+      encoder.finish();
+      built.push_back(hex(payload, encoder.size()));
+      encoder.clear();
+    }
+  }
+  encoder.finish();
+  built.push_back(hex(payload, encoder.size()));
+
+  TEST_ASSERT_EQUAL_size_t(frames.size(), built.size());
+  for (size_t i = 0; i < frames.size(); i++)
+    TEST_ASSERT_EQUAL_STRING(frames[i].c_str(), built[i].c_str());
+}
+
+void test_first_record_is_keyframe()
+{
+  uint8_t payload[TELEMETRY_FRAME_BYTES];
+  TelemetryEncoder encoder(payload, TELEMETRY_FRAME_BYTES);
+  const uint16_t values[TELEMETRY_FIELDS] = {1, 0x7F, 0x80, 0x3FFF, 0xFFFF};
+  TEST_ASSERT_TRUE(encoder.push(values));
+  // Varint de 1, 1, 2, 2 y 3 bytes
+  TEST_ASSERT_EQUAL_STRING("ff017f8001ff7fffff03", hex(payload, encoder.size()).c_str());
+}
+
+void test_unchanged_records_become_one_run()
+{
+  uint8_t payload[TELEMETRY_FRAME_BYTES];
+  TelemetryEncoder encoder(payload, TELEMETRY_FRAME_BYTES);
+  uint16_t values[TELEMETRY_FIELDS] = {10, 500, 300, 1, 0};
+  TEST_ASSERT_TRUE(encoder.push(values));
+  uint8_t keyframe = encoder.size();
+  // El tiempo avanza de a uno: solo el primer paso cambia su delta
+  for (int i = 0; i < 5; i++)
+  {
+    values[TELEMETRY_TIME]++;
+    TEST_ASSERT_TRUE(encoder.push(values));
+  }
+  encoder.finish();
+  TEST_ASSERT_EQUAL_UINT8(keyframe + 3, encoder.size());
+  TEST_ASSERT_EQUAL_STRING("010284", hex(payload + keyframe, 3).c_str());
+  TEST_ASSERT_EQUAL_UINT16(6, encoder.recordCount());
+}
+
+void test_full_buffer_rejects_record()
+{
+  uint8_t payload[TELEMETRY_FRAME_BYTES];
+  TelemetryEncoder encoder(payload, TELEMETRY_FRAME_BYTES);
+  uint16_t values[TELEMETRY_FIELDS] = {0, 0, 0, 0, 0};
+  int pushed = 0;
+  // Cambios grandes en todos los campos: cada registro ocupa el máximo
+  while (encoder.push(values))
+  {
+    pushed++;
+    for (uint8_t i = 0; i < TELEMETRY_FIELDS; i++)
+      values[i] += 0x5555;
+  }
+  TEST_ASSERT_GREATER_THAN(0, pushed);
+  uint8_t size = encoder.size();
+  uint16_t count = encoder.recordCount();
+  TEST_ASSERT_LESS_OR_EQUAL(TELEMETRY_FRAME_BYTES - 1, size);
+  // Rechazado sin tocar el buffer: la repetición pendiente aún cabe al cerrar
+  encoder.finish();
+  TEST_ASSERT_EQUAL_UINT8(size, encoder.size());
+  TEST_ASSERT_EQUAL_UINT16(count, encoder.recordCount());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_fixture_covers_the_codes);
+  RUN_TEST(test_encoder_builds_fixture_frames);
+  RUN_TEST(test_first_record_is_keyframe);
+  RUN_TEST(test_unchanged_records_become_one_run);
+  RUN_TEST(test_full_buffer_rejects_record);
+  return UNITY_END();
+}
@@ -0,0 +1,150 @@
+"""Descompresión de tools/telemetry_decode.py con los envíos de telemetry_fixture.h.
+
+Los envíos los arma TelemetryEncoder (test_telemetry_codec.cpp lo comprueba), así que
+esta prueba cierra el camino del firmware a la herramienta sin la placa.
+
+Uso:
+    python test/test_telemetry_codec/test_telemetry_decode.py
+"""
+
+import os
+import re
+import sys
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, "..", "..", "tools"))
+
+import telemetry_decode  # noqa: E402
+
+
+def load_fixture():
+    """Registros y envíos de telemetry_fixture.h."""
+    with open(os.path.join(HERE, "telemetry_fixture.h")) as handle:
+        text = handle.read()
+    body = text[text.index('R"(') + 3:text.index(')"')]
+    records = []
+    frames = []
+    for line in body.splitlines():
+        if line.startswith("r "):
+            records.append([int(value) for value in line[2:].split()])
+        elif line.startswith("f "):
+            frames.append(bytes.fromhex(line[2:]))
+    return records, frames
+
+
+def frame_bytes(sequence, payload, dropped=0):
+    """Envío completo como lo escribe telemetryFlush() en src/telemetry.cpp."""
+    body = bytes([telemetry_decode.TAG]) + telemetry_decode.HEADER.pack(sequence, dropped, len(payload)) + payload
+    return telemetry_decode.SYNC + body + bytes([sum(body) & 0xFF])
+
+
+class DecoderTest(unittest.TestCase):
+    def setUp(self):
+        self.records, self.frames = load_fixture()
+
+    def test_round_trip(self):
+        decoder = telemetry_decode.Decoder()
+        decoded = []
+        for payload in self.frames:
+            decoded += decoder.decode(payload)
+        self.assertEqual(self.records, decoded)
+
+    def test_lost_frame_waits_for_keyframe(self):
+        decoder = telemetry_decode.Decoder()
+        decoded = decoder.decode(self.frames[0])
+        decoder.lose_sync()
+        after = []
+        for payload in self.frames[2:]:
+            after += decoder.decode(payload)
+        # Lo que llega después es el final de los registros, desde un registro completo
+        self.assertTrue(after)
+        self.assertEqual(self.records[-len(after):], after)
+        self.assertLess(len(decoded) + len(after), len(self.records))
+
+    def test_ingest_reads_serial_stream(self):
+        stream = b"\x00\xa5basura"
+        for sequence, payload in enumerate(self.frames):
+            stream += frame_bytes(sequence, payload)
+        stream += telemetry_decode.SYNC + bytes([telemetry_decode.STATS_TAG])  # Resumen incompleto
+
+        frames, consumed = telemetry_decode.read_frames(stream)
+        self.assertEqual(len(self.frames), len(frames))
+        self.assertEqual(len(stream) - 3, consumed)
+
+        ingest = telemetry_decode.Ingest()
+        rows = ingest.add(frames)
+        self.assertEqual(self.records, [row[1:] for row in rows])
+        self.assertEqual(0, ingest.lost)
+        self.assertGreater(ingest.ratio(), 1)
+        # El tiempo de la primera columna avanza aunque el contador dé la vuelta
+        seconds = [row[0] for row in rows]
+        self.assertEqual(sorted(seconds), seconds)
+
+    def test_bad_checksum_counts_as_lost(self):
+        stream = frame_bytes(0, self.frames[0])
+        damaged = bytearray(frame_bytes(1, self.frames[1]))
+        damaged[-2] ^= 0x01
+        stream += bytes(damaged) + frame_bytes(2, self.frames[2])
+
+        frames, _ = telemetry_decode.read_frames(stream)
+        ingest = telemetry_decode.Ingest()
+        ingest.add(frames)
+        self.assertEqual(2, ingest.frames)
+        self.assertEqual(1, ingest.lost)
+
+
+
+def stats_body(**values):
+    """Resumen de telemetría (TelemetryStats) con los campos dados y el resto en 0."""
+    return telemetry_decode.STATS.pack(*[values.get(field, 0) for field in telemetry_decode.STATS_FIELDS])
+
+
+# Línea de muestra del formato de texto de Prometheus 0.0.4
+SAMPLE = re.compile(r'^riego_[a-z_]+\{(?:[a-z_]+="[^"]*",?)+\} (?:[-+]?[0-9.e+-]+|\+Inf|-Inf|NaN)$')
+
+
+class MetricsTest(unittest.TestCase):
+    def render(self, **values):
+        ingest = telemetry_decode.Ingest()
+        ingest.add([(telemetry_decode.STATS_TAG, stats_body(**values))])
+        metrics = telemetry_decode.Metrics("zona 1", telemetry_decode.Calibration(None))
+        metrics.render(ingest)
+        return metrics.text.decode().splitlines()
+
+    def samples(self, lines, name):
+        return {line.split("{")[1].split("}")[0]: line.split()[-1] for line in lines if line.startswith(name + "{")}
+
+    def test_exposition_format(self):
+        lines = self.render(latency_p50=2000, latency_p99=150000, latency_max=400000, evaporation_milli=250,
+                            dry_minutes=90)
+        types = {}
+        for line in lines:
+            if line.startswith("# TYPE "):
+                _, _, name, kind = line.split()
+                types[name] = kind
+            elif not line.startswith("# HELP "):
+                self.assertRegex(line, SAMPLE)
+        # La etiqueta quantile solo va en los summary, que además llevan _sum y _count
+        for line in lines:
+            if 'quantile="' in line:
+                self.assertEqual(types[line.split("{")[0]], "summary")
+        self.assertEqual(types["riego_control_latency_seconds"], "gauge")
+        self.assertEqual(self.samples(lines, "riego_control_latency_seconds"),
+                         {'controller="zona 1",percentile="50"': "0.002",
+                          'controller="zona 1",percentile="99"': "0.15",
+                          'controller="zona 1",percentile="100"': "0.4"})
+        self.assertEqual(self.samples(lines, "riego_forecast_dry_seconds"), {'controller="zona 1"': "5400.0"})
+
+    def test_no_crossing_is_positive_infinity(self):
+        lines = self.render(evaporation_milli=250, dry_minutes=telemetry_decode.NO_CROSSING)
+        self.assertEqual(self.samples(lines, "riego_forecast_dry_seconds"), {'controller="zona 1"': "+Inf"})
+
+    def test_sample_values(self):
+        self.assertEqual(telemetry_decode.sample_value(float("-inf")), "-Inf")
+        self.assertEqual(telemetry_decode.sample_value(float("nan")), "NaN")
+        self.assertEqual(telemetry_decode.sample_value(3), "3.0")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,99 @@
+// Pantallas del menú de cultivos con config/board.json, comparadas con una copia dorada
+// La prueba corre el firmware (src/) sobre HostArduino: setup() muestra el menú y espera
+// la tecla del guion. Las pantallas se comparan en el mismo formato de HOST_LCD_SNAPSHOT,
+// así que las nuevas se pueden copiar de una corrida con el mismo guion:
+//   HOST_RUN_MS=15000 HOST_KEYS="@11000 1 hold=400" HOST_LCD_SNAPSHOT=lcd.txt .pio/build/native/program
+
+#include <unity.h>
+
+#include <Arduino.h>
+#include <KeyScript.h>
+#include <LiquidCrystal.h>
+
+#include <stdio.h>
+#include <string>
+
+extern LiquidCrystal lcd;
+
+// Se elige el cultivo 1 mientras se pide un cultivo válido
+const char* const KEYS = "@11000 1 hold=400";
+
+const char* const GOLDEN_MENU =
+  "@69 ms\n"
+  "+----------------+\n"
+  "|Sistema de riego|\n"
+  "|                |\n"
+  "+----------------+\n"
+  "@2227 ms\n"
+  "+----------------+\n"
+  "|Iniciando...    |\n"
+  "|                |\n"
+  "+----------------+\n"
+  "@4387 ms\n"
+  "+----------------+\n"
+  "|Seleccione un   |\n"
+  "|cultivo         |\n"
+  "+----------------+\n"
+  "@6545 ms\n"
+  "+----------------+\n"
+  "|Cultivo 1       |\n"
+  "|Cilantro        |\n"
+  "+----------------+\n"
+  "@8704 ms\n"
+  "+----------------+\n"
+  "|Cultivo 2       |\n"
+  "|Fresa           |\n"
+  "+----------------+\n"
+  "@10866 ms\n"
+  "+----------------+\n"
+  "|Seleccione un   |\n"
+  "|cultivo valido  |\n"
+  "+----------------+\n"
+  "@11025 ms\n"
+  "+----------------+\n"
+  "|Ud selecciono:  |\n"
+  "|Cilantro        |\n"
+  "+----------------+\n"
+  "@13183 ms\n"
+  "+----------------+\n"
+  "|Cargando...     |\n"
+  "|                |\n"
+  "+----------------+\n"
+  // setup() termina con la pantalla borrada, antes de la primera lectura
+  "@15335 ms\n"
+  "+----------------+\n"
+  "|                |\n"
+  "|                |\n"
+  "+----------------+\n";
+
+static std::string snapshot(Hd44780& display)
+{
+  display.flush(micros());
+  std::string text;
+  for (const Hd44780::Frame& frame : display.frames())
+  {
+    char header[32];
+    snprintf(header, sizeof(header), "@%llu ms\n", frame.atMicros / 1000);
+    text += header + Hd44780::renderFrame(frame);
+  }
+  return text;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_menu_matches_golden()
+{
+  TEST_ASSERT_TRUE(KeyScript::instance().parse(KEYS));
+  setup();
+
+  TEST_ASSERT_EQUAL_STRING(GOLDEN_MENU, snapshot(lcd.emulator()).c_str());
+  TEST_ASSERT_EQUAL_UINT32(0, lcd.emulator().busStats().busyViolations);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_menu_matches_golden);
+  return UNITY_END();
+}
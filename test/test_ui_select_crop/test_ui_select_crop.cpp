@@ -0,0 +1,65 @@
+// Selección del cultivo con el teclado emulado, pasando por selectCrop() del firmware
+// Primero se pulsa una tecla que no es un cultivo y después la del cultivo 2 con un
+// contacto que rebota; el firmware tiene que rechazar la primera y recibir la segunda
+// una sola vez.
+
+#include <unity.h>
+
+#include <Arduino.h>
+#include <KeyScript.h>
+#include <LiquidCrystal.h>
+
+#include <string>
+
+extern LiquidCrystal lcd;
+
+const char* const KEYS = "@11000 9 hold=400\n"
+                         "@16000 2 hold=400 bounce=8 period=2";
+
+uint8_t selectedCrop = 0;
+unsigned int selections = 0;
+
+// Devuelve true si alguna pantalla mostró esas dos líneas
+static bool shown(const char* line1, const char* line2)
+{
+  for (const Hd44780::Frame& frame : lcd.emulator().frames())
+  {
+    if (frame.lines[0].compare(0, strlen(line1), line1) == 0 && frame.lines[1].compare(0, strlen(line2), line2) == 0)
+      return true;
+  }
+  return false;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_bounced_key_selects_crop_once()
+{
+  hostOnCropSelected([](uint8_t crop) {
+    selectedCrop = crop;
+    selections++;
+  });
+  TEST_ASSERT_TRUE(KeyScript::instance().parse(KEYS));
+  setup();
+  lcd.emulator().flush(micros());
+
+  const std::vector<KeyEvent>& events = KeyScript::instance().events();
+  TEST_ASSERT_EQUAL_UINT32(2, events.size());
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, events[0].deliveries, "la tecla 9 no llegó una vez");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, events[1].deliveries, "la tecla 2 con rebotes no llegó una vez");
+
+  TEST_ASSERT_TRUE(shown("Selecc invalida", ""));
+  TEST_ASSERT_TRUE(shown("Ud selecciono:", "Fresa"));
+  TEST_ASSERT_FALSE(shown("Ud selecciono:", "Cilantro"));
+
+  // setup() vuelve a cargar los parámetros del cultivo elegido en selectCrop()
+  TEST_ASSERT_EQUAL_UINT8(2, selectedCrop);
+  TEST_ASSERT_EQUAL_UINT32(2, selections);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_bounced_key_selects_crop_once);
+  return UNITY_END();
+}
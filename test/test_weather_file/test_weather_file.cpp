@@ -0,0 +1,283 @@
+// Lectura de los archivos de clima (EPW y CSV) de la simulación
+// Cada prueba escribe un archivo chico en el directorio temporal y lo abre con WeatherFile.
+
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "weather_file.h"
+
+static std::string path;
+
+// Hora de una fecha, como la calcula WeatherFile: 2021-03-01 00:00
+const double MARCH_1_2021 = 18687 * 24.0;
+
+static void writeFile(const std::string& text)
+{
+  FILE* file = fopen(path.c_str(), "wb");
+  TEST_ASSERT_TRUE(file != NULL);
+  fwrite(text.data(), 1, text.size(), file);
+  fclose(file);
+}
+
+// Registro EPW con la temperatura de bulbo seco (campo 6) y la lluvia (campo 33)
+static std::string epwRecord(unsigned year, unsigned month, unsigned day, unsigned hour, const char* temperature, const char* rain)
+{
+  char text[64];
+  snprintf(text, sizeof(text), "%u,%u,%u,%u,60,?9?9?9,%s", year, month, day, hour, temperature);
+  std::string record = text;
+  for (int field = 7; field < 33; field++)
+    record += ",0";
+  record += ",";
+  record += rain;
+  record += ",1.0\n";
+  return record;
+}
+
+static std::string epwHeader(unsigned perHour)
+{
+  char periods[64];
+  snprintf(periods, sizeof(periods), "DATA PERIODS,1,%u,Data,Sunday, 1/ 1,12/31\n", perHour);
+  return "LOCATION,Buenos Aires,BA,ARG,IWEC,875760,-34.82,-58.53,-3.0,20.0\n"
+         "DESIGN CONDITIONS,0\n"
+         "TYPICAL/EXTREME PERIODS,0\n"
+         "GROUND TEMPERATURES,0\n"
+         "HOLIDAYS/DAYLIGHT SAVINGS,No,0,0,0\n"
+         "COMMENTS 1,prueba\n"
+         "COMMENTS 2,prueba\n" +
+         std::string(periods);
+}
+
+// Tres días horarios desde el 1 de marzo; la temperatura es la hora del archivo / 10
+static std::string epwThreeDays()
+{
+  std::string text = epwHeader(1);
+  for (unsigned i = 0; i < 72; i++)
+  {
+    char temperature[16];
+    snprintf(temperature, sizeof(temperature), "%.1f", i / 10.0);
+    // Los años típicos mezclan años: solo cuenta la fecha del primer registro
+    text += epwRecord(i < 24 ? 2021 : 1999, 3, 1 + i / 24, i % 24 + 1, temperature, "0");
+  }
+  return text;
+}
+
+void setUp()
+{
+  char name[] = "/tmp/weather_XXXXXX";
+  int descriptor = mkstemp(name);
+  TEST_ASSERT_TRUE(descriptor >= 0);
+  close(descriptor);
+  path = name;
+}
+
+void tearDown() { remove(path.c_str()); }
+
+void test_csv_interpolates_temperature()
+{
+  writeFile("fecha,temperatura,lluvia\n"
+            "2021-03-01 00:00,10.0,0\n"
+            "2021-03-01 01:00,14.0,0\n"
+            "2021-03-01 03:00,12.0,4.0\n");
+  WeatherFile weather;
+  TEST_ASSERT_TRUE(weather.open(path.c_str()));
+  TEST_ASSERT_FLOAT_WITHIN(1e-9, MARCH_1_2021, weather.firstHour());
+
+  float temperature, rain;
+  TEST_ASSERT_TRUE(weather.sample(MARCH_1_2021, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 10.0f, temperature);
+  TEST_ASSERT_TRUE(weather.sample(MARCH_1_2021 + 0.25, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 11.0f, temperature);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0f, rain);
+  // 4 mm en las 2 horas que terminan en el registro: 2 mm/h
+  TEST_ASSERT_TRUE(weather.sample(MARCH_1_2021 + 2, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 13.0f, temperature);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 2.0f, rain);
+}
+
+void test_csv_past_last_record_repeats_temperature()
+{
+  writeFile("time,temperature\n"
+            "2021-03-01T00:00:00,10\n"
+            "2021-03-01T01:00:00,12.5\n");
+  WeatherFile weather;
+  TEST_ASSERT_TRUE(weather.open(path.c_str()));
+  float temperature, rain;
+  TEST_ASSERT_FALSE(weather.sample(MARCH_1_2021 + 5, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 12.5f, temperature);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0f, rain);
+}
+
+void test_csv_semicolon_and_decimal_comma()
+{
+  // Marca de UTF-8, columnas entre comillas y en otro orden, fin de línea de Windows
+  writeFile("\xEF\xBB\xBF\"Lluvia\";\"Temperatura\";\"Fecha\"\r\n"
+            "0;-2,5;2021-03-01 00:00\r\n"
+            "1,5;3,5;2021-03-01 00:30\r\n");
+  WeatherFile weather;
+  TEST_ASSERT_TRUE(weather.open(path.c_str()));
+  float temperature, rain;
+  TEST_ASSERT_TRUE(weather.sample(MARCH_1_2021 + 0.25, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.5f, temperature);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 3.0f, rain);
+}
+
+void test_csv_skips_invalid_rows()
+{
+  writeFile("fecha,temperatura\n"
+            "2021-03-01 00:00,10\n"
+            "2021-03-01 02:00,20\n"
+            "2021-03-01 01:00,99\n"  // Fuera de orden
+            "no es una fecha,99\n"
+            "2021-03-01 04:00,\n"    // Sin temperatura: repite la anterior
+            "2021-03-01 06:00,30\n");
+  WeatherFile weather;
+  TEST_ASSERT_TRUE(weather.open(path.c_str()));
+  float temperature, rain;
+  TEST_ASSERT_TRUE(weather.sample(MARCH_1_2021 + 1, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 15.0f, temperature);
+  TEST_ASSERT_TRUE(weather.sample(MARCH_1_2021 + 3, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 20.0f, temperature);
+  TEST_ASSERT_TRUE(weather.sample(MARCH_1_2021 + 5, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 25.0f, temperature);
+}
+
+void test_csv_without_temperature_column_fails()
+{
+  writeFile("fecha,humedad\n2021-03-01 00:00,50\n");
+  WeatherFile weather;
+  TEST_ASSERT_FALSE(weather.open(path.c_str()));
+}
+
+void test_missing_file_fails()
+{
+  WeatherFile weather;
+  TEST_ASSERT_FALSE(weather.open("/nonexistent/clima.csv"));
+}
+
+void test_epw_reads_records()
+{
+  writeFile(epwThreeDays());
+  WeatherFile weather;
+  TEST_ASSERT_TRUE(weather.open(path.c_str()));
+  // El registro de la hora 1 cubre de 00:00 a 01:00 y se fecha al final
+  TEST_ASSERT_FLOAT_WITHIN(1e-9, MARCH_1_2021 + 1, weather.firstHour());
+
+  float temperature, rain;
+  TEST_ASSERT_TRUE(weather.sample(MARCH_1_2021 + 1.5, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.05f, temperature);
+  // Después del 1 de marzo los registros dicen 1999, pero siguen avanzando de a una hora
+  TEST_ASSERT_TRUE(weather.sample(MARCH_1_2021 + 30, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 2.9f, temperature);
+}
+
+void test_epw_missing_values()
+{
+  std::string text = epwHeader(1);
+  text += epwRecord(2021, 3, 1, 1, "10.0", "2.0");
+  text += epwRecord(2021, 3, 1, 2, "99.9", "999");  // Faltantes
+  text += epwRecord(2021, 3, 1, 3, "14.0", "999");
+  text += epwRecord(2021, 3, 1, 4, "16.0", "1.0");
+  writeFile(text);
+  WeatherFile weather;
+  TEST_ASSERT_TRUE(weather.open(path.c_str()));
+
+  float temperature, rain;
+  // La temperatura faltante repite la anterior y la lluvia faltante es 0
+  TEST_ASSERT_TRUE(weather.sample(MARCH_1_2021 + 2, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 10.0f, temperature);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0f, rain);
+  TEST_ASSERT_TRUE(weather.sample(MARCH_1_2021 + 2.5, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 12.0f, temperature);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0f, rain);
+  TEST_ASSERT_TRUE(weather.sample(MARCH_1_2021 + 3.5, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 15.0f, temperature);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 1.0f, rain);
+}
+
+void test_epw_sub_hourly_interval()
+{
+  std::string text = epwHeader(4);
+  const char* temperatures[] = {"8.0", "9.0", "10.0", "11.0", "12.0"};
+  for (unsigned i = 0; i < 5; i++)
+  {
+    char record[32];
+    snprintf(record, sizeof(record), "2021,3,1,%u,%u,", 1 + i / 4, (i % 4 + 1) * 15);
+    std::string line = epwRecord(2021, 3, 1, 1, temperatures[i], "0.5");
+    text += record + line.substr(line.find("?9"));
+  }
+  writeFile(text);
+  WeatherFile weather;
+  TEST_ASSERT_TRUE(weather.open(path.c_str()));
+  TEST_ASSERT_FLOAT_WITHIN(1e-9, MARCH_1_2021 + 0.25, weather.firstHour());
+  float temperature, rain;
+  TEST_ASSERT_TRUE(weather.sample(MARCH_1_2021 + 0.625, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 9.5f, temperature);
+  // 0.5 mm cada 15 minutos
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 2.0f, rain);
+}
+
+void test_epw_skip_to_later_day_matches_sequential_read()
+{
+  writeFile(epwThreeDays());
+  WeatherFile sequential;
+  TEST_ASSERT_TRUE(sequential.open(path.c_str()));
+  float expected = 0, rain;
+  for (double hour = MARCH_1_2021 + 1; hour <= MARCH_1_2021 + 50.5; hour += 0.5)
+    TEST_ASSERT_TRUE(sequential.sample(hour, expected, rain));
+
+  // Saltar directo al segundo día cuenta líneas sin leer los registros intermedios
+  WeatherFile skipped;
+  TEST_ASSERT_TRUE(skipped.open(path.c_str()));
+  float temperature;
+  TEST_ASSERT_TRUE(skipped.sample(MARCH_1_2021 + 50.5, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, expected, temperature);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 4.95f, temperature);
+  // Y sigue leyendo normalmente después del salto
+  TEST_ASSERT_TRUE(skipped.sample(MARCH_1_2021 + 60, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 5.9f, temperature);
+  TEST_ASSERT_FALSE(skipped.sample(MARCH_1_2021 + 80, temperature, rain));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 7.1f, temperature);
+}
+
+void test_epw_without_data_periods_fails()
+{
+  writeFile("LOCATION,Buenos Aires\n" + epwRecord(2021, 3, 1, 1, "10", "0"));
+  WeatherFile weather;
+  TEST_ASSERT_FALSE(weather.open(path.c_str()));
+}
+
+void test_format_hour()
+{
+  char text[32];
+  WeatherFile::formatHour(MARCH_1_2021 + 13.5, text, sizeof(text));
+  TEST_ASSERT_EQUAL_STRING("2021-03-01 13:30", text);
+  // Año bisiesto y redondeo al minuto que pasa a otro día
+  WeatherFile::formatHour(MARCH_1_2021 - 24 + 23.9999, text, sizeof(text));
+  TEST_ASSERT_EQUAL_STRING("2021-03-01 00:00", text);
+  WeatherFile::formatHour(18321 * 24.0, text, sizeof(text));
+  TEST_ASSERT_EQUAL_STRING("2020-02-29 00:00", text);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_csv_interpolates_temperature);
+  RUN_TEST(test_csv_past_last_record_repeats_temperature);
+  RUN_TEST(test_csv_semicolon_and_decimal_comma);
+  RUN_TEST(test_csv_skips_invalid_rows);
+  RUN_TEST(test_csv_without_temperature_column_fails);
+  RUN_TEST(test_missing_file_fails);
+  RUN_TEST(test_epw_reads_records);
+  RUN_TEST(test_epw_missing_values);
+  RUN_TEST(test_epw_sub_hourly_interval);
+  RUN_TEST(test_epw_skip_to_later_day_matches_sequential_read);
+  RUN_TEST(test_epw_without_data_periods_fails);
+  RUN_TEST(test_format_hour);
+  return UNITY_END();
+}
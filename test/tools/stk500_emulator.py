@@ -0,0 +1,121 @@
+"""Placa con Optiboot emulada para probar tools/delta_flash.py sin hardware.
+
+Optiboot (STK500v1) se emula con la parte del protocolo que usa delta_flash.py:
+GET_SYNC, ENTER/LEAVE_PROGMODE, LOAD_ADDRESS (en palabras), PROG_PAGE y READ_PAGE
+de la flash. Responde INSYNC ... OK a cada comando completo terminado en CRC_EOP y nada a
+los mal formados, como el bootloader real, que espera al watchdog.
+
+El objeto se usa en lugar del puerto serie de pyserial (write, read,
+reset_input_buffer, close). Para probar los errores se puede pedir que ignore los
+primeros sincronismos (la placa todavía reiniciándose) o que dañe un byte al escribir
+una página.
+"""
+
+FLASH_SIZE = 32768       # ATmega328P, con el bootloader en los últimos 512 bytes
+BOOTLOADER_START = FLASH_SIZE - 512
+PAGE_SIZE = 128
+
+STK_OK = 0x10
+STK_FAILED = 0x11
+STK_INSYNC = 0x14
+CRC_EOP = 0x20
+STK_GET_SYNC = 0x30
+STK_ENTER_PROGMODE = 0x50
+STK_LEAVE_PROGMODE = 0x51
+STK_LOAD_ADDRESS = 0x55
+STK_PROG_PAGE = 0x64
+STK_READ_PAGE = 0x74
+
+
+class Stk500Board:
+    def __init__(self, flash=None, ignore_syncs=0, corrupt_address=None):
+        self.flash = bytearray(b"\xff" * FLASH_SIZE)
+        if flash is not None:
+            self.flash[:len(flash)] = flash
+        self.ignore_syncs = ignore_syncs
+        self.corrupt_address = corrupt_address  # Byte que queda mal escrito
+        self.address = 0                      # En bytes
+        self.programming = False
+        self.pages_written = []
+        self.closed = False
+        self.dtr = True
+        self.received = bytearray()
+        self.output = bytearray()
+
+    # --- Interfaz de serial.Serial ---
+    def write(self, data):
+        self.received += data
+        while self._command():
+            pass
+        return len(data)
+
+    def read(self, size):
+        # Sin más bytes el puerto real espera el timeout y devuelve lo que llegó
+        reply, self.output = bytes(self.output[:size]), self.output[size:]
+        return reply
+
+    def reset_input_buffer(self):
+        self.output = bytearray()
+
+    def close(self):
+        self.closed = True
+
+    # --- Bootloader ---
+    def _command(self):
+        """Atiende el primer comando completo de lo recibido; False si falta algo."""
+        data = self.received
+        if not data:
+            return False
+        lengths = {STK_GET_SYNC: 2, STK_ENTER_PROGMODE: 2, STK_LEAVE_PROGMODE: 2, STK_LOAD_ADDRESS: 4}
+        code = data[0]
+        if code in lengths:
+            size = lengths[code]
+        elif code in (STK_PROG_PAGE, STK_READ_PAGE):
+            if len(data) < 4:
+                return False
+            size = 5 + (data[1] << 8 | data[2] if code == STK_PROG_PAGE else 0)
+        else:
+            # Comando desconocido: se descarta el byte, sin respuesta
+            del data[0]
+            return True
+        if len(data) < size:
+            return False
+        command, self.received = bytes(data[:size]), data[size:]
+        if command[-1] != CRC_EOP:
+            return True
+        self._reply(command)
+        return True
+
+    def _reply(self, command):
+        code = command[0]
+        body = b""
+        status = STK_OK
+        if code == STK_GET_SYNC and self.ignore_syncs:
+            self.ignore_syncs -= 1
+            return
+        if code == STK_ENTER_PROGMODE:
+            self.programming = True
+        elif code == STK_LEAVE_PROGMODE:
+            self.programming = False
+        elif code == STK_LOAD_ADDRESS:
+            self.address = (command[1] | command[2] << 8) * 2
+        elif code == STK_PROG_PAGE:
+            length = command[1] << 8 | command[2]
+            data = bytearray(command[4:4 + length])
+            if (not self.programming or command[3] != ord("F") or length > PAGE_SIZE
+                    or self.address % PAGE_SIZE or self.address + length > BOOTLOADER_START):
+                status = STK_FAILED
+            else:
+                if self.corrupt_address is not None and 0 <= self.corrupt_address - self.address < length:
+                    data[self.corrupt_address - self.address] ^= 0x01
+                # Optiboot borra la página entera y escribe lo recibido
+                self.flash[self.address:self.address + PAGE_SIZE] = b"\xff" * PAGE_SIZE
+                self.flash[self.address:self.address + length] = data
+                self.pages_written.append(self.address)
+        elif code == STK_READ_PAGE:
+            length = command[1] << 8 | command[2]
+            if command[3] != ord("F") or self.address + length > FLASH_SIZE:
+                status = STK_FAILED
+            else:
+                body = bytes(self.flash[self.address:self.address + length])
+        self.output += bytes([STK_INSYNC]) + body + bytes([status])
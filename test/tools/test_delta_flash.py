@@ -0,0 +1,231 @@
+"""Actualización por páginas de la flash con tools/delta_flash.py.
+
+Arma archivos Intel HEX para probar la lectura de la imagen (direcciones extendidas,
+imágenes que no caben, registros dañados) y la comparación de páginas, y escribe en la
+placa emulada de stk500_emulator.py para probar el protocolo del bootloader y la
+actualización completa, con la comprobación de la imagen base y de lo escrito.
+
+Uso:
+    python test/tools/test_delta_flash.py
+"""
+
+import contextlib
+import io
+import os
+import sys
+import tempfile
+import unittest
+from unittest import mock
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, HERE)
+sys.path.insert(0, os.path.join(HERE, "..", "..", "tools"))
+
+import delta_flash  # noqa: E402
+from stk500_emulator import Stk500Board  # noqa: E402
+
+PAGE = delta_flash.PAGE_SIZE
+
+
+def record(kind, address, data):
+    body = bytes([len(data), address >> 8, address & 0xFF, kind]) + bytes(data)
+    return ":" + (body + bytes([-sum(body) & 0xFF])).hex().upper()
+
+
+def data_records(image, start=0, width=16):
+    return [record(0x00, start + offset, image[offset:offset + width]) for offset in range(0, len(image), width)]
+
+
+def program(size, seed=0):
+    """Bytes de un programa de prueba, distintos para cada semilla."""
+    return bytes((index * 7 + seed * 13 + index // 251) & 0xFF for index in range(size))
+
+
+class HexTestCase(unittest.TestCase):
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+        self.addCleanup(self.directory.cleanup)
+
+    def write_hex(self, lines, name="imagen.hex"):
+        path = os.path.join(self.directory.name, name)
+        with open(path, "w") as handle:
+            handle.write("\n".join(lines + [record(0x01, 0, b"")]) + "\n")
+        return path
+
+    def assertExits(self, lines, message):
+        with self.assertRaises(SystemExit) as raised:
+            delta_flash.read_hex(self.write_hex(lines))
+        self.assertIn(message, str(raised.exception))
+
+
+class ReadHexTest(HexTestCase):
+    def test_data_records(self):
+        image, used = delta_flash.read_hex(self.write_hex(data_records(program(40))))
+        self.assertEqual(used, 40)
+        self.assertEqual(image[:40], program(40))
+        self.assertEqual(image[40:], b"\xff" * (delta_flash.FLASH_SIZE - 40))
+
+    def test_gap_filled_and_records_after_end_ignored(self):
+        path = self.write_hex([record(0x00, 0x100, b"\x01\x02"), record(0x01, 0, b""), record(0x00, 0, b"\x55")])
+        image, used = delta_flash.read_hex(path)
+        self.assertEqual(used, 0x102)
+        self.assertEqual(image[0], 0xFF)
+        self.assertEqual(image[0x100:0x102], b"\x01\x02")
+
+    def test_extended_segment_address(self):
+        # 0x02: la base es el segmento por 16
+        image, used = delta_flash.read_hex(self.write_hex([record(0x02, 0, b"\x01\x00"), record(0x00, 0x20, b"\xaa\xbb")]))
+        self.assertEqual(image[0x1020:0x1022], b"\xaa\xbb")
+        self.assertEqual(used, 0x1022)
+
+    def test_extended_linear_address(self):
+        # 0x04 con 0 vuelve a la base; con 1 la dirección pasa de 64 KB y no cabe
+        image, _ = delta_flash.read_hex(self.write_hex([record(0x02, 0, b"\x01\x00"), record(0x04, 0, b"\x00\x00"),
+                                                        record(0x00, 0x10, b"\xcc")]))
+        self.assertEqual(image[0x10], 0xCC)
+        self.assertExits([record(0x04, 0, b"\x00\x01"), record(0x00, 0, b"\x00")], "no cabe")
+
+    def test_overflow_past_application_flash(self):
+        end = delta_flash.FLASH_SIZE
+        image, used = delta_flash.read_hex(self.write_hex([record(0x00, end - 4, b"\x01\x02\x03\x04")]))
+        self.assertEqual(used, end)
+        # Un registro que cruza el límite, o uno en la zona de Optiboot
+        self.assertExits([record(0x00, end - 4, b"\x01\x02\x03\x04\x05")], "no cabe")
+        self.assertExits([record(0x00, end, b"\x01")], "no cabe")
+
+    def test_checksum_error(self):
+        line = record(0x00, 0x40, b"\x10\x20\x30")
+        damaged = line[:-2] + "%02X" % (int(line[-2:], 16) ^ 0x01)
+        self.assertExits([record(0x00, 0, b"\x00"), damaged], "imagen.hex:2: suma de comprobación incorrecta")
+
+    def test_malformed_lines(self):
+        self.assertExits(["00000001FF"], "no es un archivo Intel HEX")
+        self.assertExits([":0300000001020"], "no es un archivo Intel HEX")
+        # Tres bytes anunciados y dos presentes, con una suma que igual da 0
+        short = bytes([0x03, 0x00, 0x00, 0x00, 0x01, 0x02])
+        self.assertExits([":" + (short + bytes([-sum(short) & 0xFF])).hex()], "el largo del registro")
+
+
+class ChangedPagesTest(unittest.TestCase):
+    def image(self, data):
+        image = bytearray(b"\xff" * delta_flash.FLASH_SIZE)
+        image[:len(data)] = data
+        return image
+
+    def test_same_image(self):
+        base = self.image(program(5 * PAGE))
+        self.assertEqual(delta_flash.changed_pages(base, bytearray(base), 5 * PAGE), [])
+
+    def test_single_byte_and_partial_last_page(self):
+        base = self.image(program(3 * PAGE + 10))
+        new = bytearray(base)
+        new[PAGE + 5] ^= 0xFF
+        new[3 * PAGE + 12] = 0x00  # Después del final de la base, en su última página
+        self.assertEqual(delta_flash.changed_pages(base, new, 3 * PAGE + 13), [PAGE, 3 * PAGE])
+
+    def test_new_image_shorter_than_base(self):
+        # Las páginas que solo tenía la base se escriben borradas
+        base = self.image(program(6 * PAGE))
+        new = self.image(program(2 * PAGE + 30))
+        self.assertEqual(delta_flash.changed_pages(base, new, 2 * PAGE + 30), [2 * PAGE])
+        pages = delta_flash.changed_pages(base, new, 6 * PAGE)
+        self.assertEqual(pages, [2 * PAGE, 3 * PAGE, 4 * PAGE, 5 * PAGE])
+        self.assertEqual(new[5 * PAGE:6 * PAGE], b"\xff" * PAGE)
+
+
+class BootloaderTest(unittest.TestCase):
+    def test_write_and_read_back(self):
+        board = Stk500Board()
+        data = program(PAGE, seed=3)
+        with delta_flash.Bootloader(board) as loader:
+            self.assertTrue(board.programming)
+            loader.write_page(0x1E80, data)
+            self.assertEqual(loader.read_page(0x1E80), data)
+            self.assertEqual(loader.read_page(0x1E00), b"\xff" * PAGE)
+        self.assertEqual(board.pages_written, [0x1E80])
+        self.assertEqual(board.flash[0x1E80:0x1F00], data)
+        self.assertFalse(board.programming)
+        self.assertTrue(board.closed)
+
+    def test_short_page_erases_rest(self):
+        board = Stk500Board(flash=program(PAGE))
+        with delta_flash.Bootloader(board) as loader:
+            loader.write_page(0, b"\x01\x02")
+            self.assertEqual(loader.read_page(0), b"\x01\x02" + b"\xff" * (PAGE - 2))
+
+    def test_sync_retries_while_board_resets(self):
+        board = Stk500Board(ignore_syncs=3)
+        with delta_flash.Bootloader(board) as loader:
+            self.assertEqual(loader.read_page(0), b"\xff" * PAGE)
+
+    def test_no_bootloader(self):
+        board = Stk500Board(ignore_syncs=100)
+        with self.assertRaises(IOError):
+            with delta_flash.Bootloader(board):
+                pass
+
+    def test_rejected_write(self):
+        # Optiboot no escribe sobre sí mismo: responde FAILED
+        board = Stk500Board()
+        with delta_flash.Bootloader(board) as loader:
+            with self.assertRaises(IOError):
+                loader.write_page(delta_flash.FLASH_SIZE, program(PAGE))
+        self.assertEqual(board.pages_written, [])
+
+
+class MainTest(HexTestCase):
+    def run_main(self, board, *flags):
+        base = self.write_hex(data_records(self.base), "base.hex")
+        new = self.write_hex(data_records(self.new), "nueva.hex")
+        output = io.StringIO()
+        with mock.patch.object(sys, "argv", ["delta_flash.py", base, new] + list(flags)), \
+                mock.patch.object(delta_flash, "open_port", return_value=board) as open_port, \
+                contextlib.redirect_stdout(output):
+            delta_flash.main()
+        if board is not None:
+            open_port.assert_called_once_with("/dev/placa", 115200)
+        return output.getvalue()
+
+    def setUp(self):
+        super().setUp()
+        self.base = program(8 * PAGE + 40)
+        new = bytearray(self.base)
+        new[3 * PAGE + 1] ^= 0x5A
+        new[8 * PAGE + 39] ^= 0x01
+        self.new = bytes(new)
+
+    def test_dry_run(self):
+        output = self.run_main(None, "--dry-run")
+        self.assertIn("2 de 9 páginas cambiaron", output)
+
+    def test_update_writes_changed_pages(self):
+        board = Stk500Board(flash=self.base)
+        output = self.run_main(board, "--port", "/dev/placa", "--verify-base")
+        self.assertEqual(board.pages_written, [3 * PAGE, 8 * PAGE])
+        self.assertEqual(board.flash[:len(self.new)], self.new)
+        self.assertIn("2 páginas escritas y comprobadas", output)
+
+    def test_shorter_image_erases_old_tail(self):
+        self.new = self.base[:2 * PAGE]
+        board = Stk500Board(flash=self.base)
+        output = self.run_main(board, "--port", "/dev/placa")
+        self.assertIn("7 de 9 páginas cambiaron", output)
+        self.assertEqual(board.flash[:2 * PAGE], self.new)
+        self.assertEqual(board.flash[2 * PAGE:delta_flash.FLASH_SIZE], b"\xff" * (delta_flash.FLASH_SIZE - 2 * PAGE))
+
+    def test_board_without_base_image(self):
+        board = Stk500Board(flash=program(8 * PAGE + 40, seed=1))
+        with self.assertRaises(SystemExit) as raised:
+            self.run_main(board, "--port", "/dev/placa", "--verify-base")
+        self.assertIn("no tiene la imagen base (página 0x0000)", str(raised.exception))
+        self.assertEqual(board.pages_written, [])
+
+    def test_bad_write_detected(self):
+        board = Stk500Board(flash=self.base, corrupt_address=3 * PAGE + 100)
+        with self.assertRaises(SystemExit) as raised:
+            self.run_main(board, "--port", "/dev/placa")
+        self.assertIn("0x0180 no quedó bien escrita", str(raised.exception))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,249 @@
+"""Validación de la configuración y encabezado generado con scripts/gen_config.py.
+
+Parte de config/board.json y cambia un valor por prueba: cada error de la validación se
+rechaza con su mensaje, y los valores válidos (nombres con comillas o barras, tarifas,
+cruce por cero, registro en la SD, detector de anomalías) llegan bien a board_config.h.
+
+Uso:
+    python test/tools/test_gen_config.py
+"""
+
+import copy
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.join(HERE, "..", "..")
+TOOL = os.path.join(ROOT, "scripts", "gen_config.py")
+sys.path.insert(0, os.path.dirname(TOOL))
+
+import gen_config  # noqa: E402
+
+with open(os.path.join(ROOT, "config", "board.json"), encoding="utf-8") as handle:
+    BASE = json.load(handle)
+
+TARIFF = [
+    {"start": "00:00", "end": "07:00", "price": 0.10},
+    {"start": "07:00", "end": "22:00", "price": 0.25},
+    {"start": "22:00", "end": "24:00", "price": 0.10},
+]
+SD_LOG = {"cs": 10, "start_block": 2048, "blocks": 6144}
+
+
+def config_with(**changes):
+    config = copy.deepcopy(BASE)
+    config.update(copy.deepcopy(changes))
+    return config
+
+
+def generate(config, *flags):
+    """Texto de board_config.h generado para la configuración."""
+    with tempfile.TemporaryDirectory() as directory:
+        source = os.path.join(directory, "board.json")
+        output = os.path.join(directory, "board_config.h")
+        with open(source, "w", encoding="utf-8") as handle:
+            json.dump(config, handle, ensure_ascii=False)
+        gen_config.generate(source, output, flags)
+        with open(output, encoding="utf-8") as handle:
+            return handle.read()
+
+
+def sram(text):
+    """SRAM estimada que anota el encabezado."""
+    line = next(line for line in text.splitlines() if "SRAM estimada" in line)
+    return int(line.split("SRAM estimada: ")[1].split()[0])
+
+
+class RejectTest(unittest.TestCase):
+    def rejects(self, config, message, *flags):
+        with self.assertRaises(gen_config.ConfigError) as raised:
+            generate(config, *flags)
+        self.assertIn(message, str(raised.exception))
+
+    def test_unknown_board(self):
+        self.rejects(config_with(board="mega"), "placa desconocida")
+
+    def test_missing_pins(self):
+        config = config_with()
+        config["pins"]["temperature_sensor"] = "A9"
+        self.rejects(config, "el pin A9 no existe")
+        config["pins"]["temperature_sensor"] = 40
+        self.rejects(config, "el pin 40 no existe")
+
+    def test_pin_used_twice(self):
+        config = config_with()
+        config["pins"]["irrigation_motor"] = 13
+        self.rejects(config, "el pin 13 está asignado a irrigation_motor y a keypad.rows[0]")
+
+    def test_serial_pins(self):
+        self.rejects(config_with(serial={"enabled": True, "baud": 9600}), "el puerto serie está habilitado pero el pin 0")
+
+    def test_sensor_without_adc(self):
+        config = config_with()
+        config["pins"]["humidity_sensor"] = 12
+        config["pins"]["keypad"]["rows"][1] = "A3"
+        self.rejects(config, "humidity_sensor: el pin 12 no tiene canal del ADC")
+
+    def test_analog_only_pin(self):
+        config = config_with(board="nano")
+        config["pins"]["irrigation_motor"] = "A7"
+        self.rejects(config, "irrigation_motor: el pin 21 solo es entrada analógica")
+
+    def test_crop_list(self):
+        self.rejects(config_with(crops=[]), "no hay cultivos")
+        crop = BASE["crops"][0]
+        self.rejects(config_with(crops=[dict(crop, name="C%d" % i) for i in range(10)]), "entre 9 cultivos")
+
+    def test_crop_ranges(self):
+        self.rejects(config_with(crops=[dict(BASE["crops"][0], min_humidity=60)]), "Cilantro: el mínimo es mayor que el máximo")
+        self.rejects(config_with(crops=[dict(BASE["crops"][0], min_temp=30)]), "el mínimo es mayor que el máximo")
+
+    def test_crop_names(self):
+        crop = BASE["crops"][0]
+        self.rejects(config_with(crops=[dict(crop, name="Zanahoria morada!")]), "no cabe en una línea")
+        # En UTF-8 la ñ y las tildes no están en la ROM de la pantalla y ocupan dos bytes
+        for name in ("Piña", "Maíz", "Ajo\tblanco", ""):
+            self.rejects(config_with(crops=[dict(crop, name=name)]), "ASCII")
+
+    def test_fixed_crop(self):
+        self.rejects(config_with(fixed_crop="Tomate"), "fixed_crop: el cultivo Tomate no está en la lista")
+
+    def test_sram(self):
+        crop = BASE["crops"][0]
+        crops = [dict(crop, name="Cultivo numero %d" % i) for i in range(9)]
+        flags = ("-DENABLE_PROFILER", "-DENABLE_TRACE", "-DENABLE_TELEMETRY")
+        self.assertLess(sram(generate(config_with(crops=crops), *flags)) + gen_config.STACK_RESERVE_BYTES, 2048)
+        # Con el detector de anomalías ya no queda el margen para la pila
+        self.rejects(config_with(crops=crops, anomaly_detection=True), "no queda margen para la pila", *flags)
+
+    def test_tariff(self):
+        self.rejects(config_with(tariff=[dict(TARIFF[0], start="7:61")]), "tariff[0]: hora inválida")
+        self.rejects(config_with(tariff=[dict(TARIFF[0], start="siete")]), "tariff[0]: hora inválida")
+        self.rejects(config_with(tariff=[TARIFF[1], TARIFF[0], TARIFF[2]]), "tariff[0]: las ventanas deben ir en orden")
+        self.rejects(config_with(tariff=[TARIFF[0], dict(TARIFF[1], price=-1), TARIFF[2]]), "tariff[1]: precio negativo")
+        self.rejects(config_with(tariff=TARIFF[:2]), "deben terminar a las 24:00")
+
+    def test_temperature_reference(self):
+        config = config_with()
+        config["calibration"]["temperature_reference"] = "aref"
+        self.rejects(config, "debe ser \"vcc\" o \"internal\"")
+        config["calibration"]["temperature_reference"] = "internal"
+        self.rejects(config, "hay que anotar la tensión medida en AREF")
+        config["calibration"]["internal_vref"] = 1.3
+        self.rejects(config, "entre 1.0 y 1.2 V")
+        config["calibration"]["internal_vref"] = 1.1
+        config["crops"][0]["max_temp"] = 65
+        self.rejects(config, "Cilantro: con la referencia interna la temperatura satura en 60 °C")
+
+    def test_latency_slo(self):
+        self.rejects(config_with(latency_slo={"percentile": 99.5}), "el percentil debe ser un entero")
+        self.rejects(config_with(latency_slo={"percentile": 0}), "el percentil debe ser un entero")
+        self.rejects(config_with(latency_slo={"limit_ms": 0}), "el límite debe ser positivo")
+
+    def test_probe_power(self):
+        self.rejects(config_with(probe_power={"pin": "A5", "settle_ms": 0}), "la espera debe estar entre 1 y 250 ms")
+        self.rejects(config_with(probe_power={"pin": "A5", "settle_ms": 20, "period_ms": 20}), "el periodo debe ser mayor")
+        self.rejects(config_with(probe_power={"pin": "A5", "burst": 65}), "entre 1 y 64 lecturas")
+        self.rejects(config_with(probe_power={"pin": "A5", "period_ms": 1000}), "la latencia nunca cumple el objetivo")
+
+    def test_zero_cross(self):
+        self.rejects(config_with(zero_cross={"pin": "A5", "mains_hz": 40}), "50 o 60 Hz")
+        self.rejects(config_with(zero_cross={"pin": "A5", "relay_operate_ms": 25}), "entre 0 y 20 ms")
+
+    def test_zero_cross_needs_pin_change_interrupt(self):
+        board = copy.deepcopy(gen_config.BOARDS["uno"])
+        board["pcint"] = {"PCINT0_vect": range(8, 14)}
+        with self.assertRaises(gen_config.ConfigError) as raised:
+            gen_config.pcint_vector(board, 19)
+        self.assertIn("el pin 19 no tiene interrupción", str(raised.exception))
+
+    def test_sd_log(self):
+        keypad = {"rows": [9, 8, 7, 6], "cols": ["A3", "A4", "A5"]}
+        pins = dict(BASE["pins"], keypad=keypad)
+        self.rejects(config_with(pins=pins, sd_log={"cs": 10}), "start_block y blocks son obligatorios")
+        self.rejects(config_with(pins=pins, sd_log=dict(SD_LOG, start_block=0)), "zona de la tarjeta inválida")
+        self.rejects(config_with(pins=pins, sd_log=dict(SD_LOG, interval_ms=500)), "el intervalo mínimo")
+        # Con el teclado de siempre el bus SPI choca con las filas
+        self.rejects(config_with(sd_log=SD_LOG), "el pin 10 está asignado a keypad.rows[3] y a sd_log.cs")
+
+    def test_anomaly_detection(self):
+        self.rejects(config_with(anomaly_detection="si"), "anomaly_detection: debe ser true o false")
+
+    def test_keymap(self):
+        config = config_with()
+        config["pins"]["keypad"]["keys"] = ["123A", "456B", "789C"]
+        self.rejects(config, "debe tener 4 filas de 4 teclas")
+        config["pins"]["keypad"]["keys"] = ["123A", "456B", "789C", "*A#D"]
+        self.rejects(config, "faltan dígitos")
+
+
+class RenderTest(unittest.TestCase):
+    def test_default_config(self):
+        text = generate(config_with())
+        self.assertIn('  {"Cilantro", 15.0f, 24.0f, 40.0f, 50.0f},', text)
+        self.assertIn('template <> struct CropTraits<1> { // "Cilantro"', text)
+        self.assertIn("#define TARIFF_WINDOW_COUNT 0", text)
+        self.assertIn("#define SD_LOG_ENABLED 0", text)
+        self.assertIn("#define ANOMALY_DETECTION_ENABLED 0", text)
+        self.assertNotIn("FIXED_CROP_INDEX", text)
+
+    def test_names_are_escaped(self):
+        # Una \\ final en un comentario de C uniría la línea siguiente al comentario
+        crop = dict(BASE["crops"][0], name='Ajo "rojo" \\')
+        text = generate(config_with(crops=[crop], fixed_crop=crop["name"]))
+        self.assertIn('  {"Ajo \\"rojo\\" \\\\", 15.0f', text)
+        self.assertIn('CropTraits<1> { // "Ajo \\"rojo\\" \\\\"\n', text)
+        self.assertIn('un solo cultivo: "Ajo \\"rojo\\" \\\\"\n', text)
+        self.assertIn("#define FIXED_CROP_INDEX 1", text)
+
+    def test_optional_features(self):
+        keypad = {"rows": [9, 8, 7, 6], "cols": ["A3", "A4", "A5"]}
+        base = generate(config_with(pins=dict(BASE["pins"], keypad=keypad)))
+        text = generate(config_with(pins=dict(BASE["pins"], keypad=keypad), tariff=TARIFF, sd_log=SD_LOG,
+                                    anomaly_detection=True))
+        self.assertIn("#define TARIFF_WINDOW_COUNT 3", text)
+        self.assertIn("  {420, 1320, 0.25f},", text)
+        self.assertIn("#define SD_LOG_ENABLED 1", text)
+        self.assertIn("constexpr unsigned long SD_LOG_INTERVAL_MS = 10000UL;", text)
+        self.assertIn("#define ANOMALY_DETECTION_ENABLED 1", text)
+        extra = 3 * gen_config.TARIFF_SRAM_BYTES + gen_config.SD_LOG_SRAM_BYTES + gen_config.ANOMALY_SRAM_BYTES
+        self.assertEqual(sram(base) + extra, sram(text))
+
+    def test_build_flags_count_buffers(self):
+        base = sram(generate(config_with()))
+        text = generate(config_with(), "-DENABLE_TRACE", "-D ENABLE_PROFILER")
+        self.assertEqual(base + gen_config.OPTIONAL_SRAM_BYTES["ENABLE_TRACE"] + gen_config.OPTIONAL_SRAM_BYTES["ENABLE_PROFILER"],
+                         sram(text))
+        self.assertIn("con ENABLE_PROFILER, ENABLE_TRACE", text)
+
+    def test_zero_cross_delay(self):
+        # 50 Hz: semiperiodo de 10 ms; con 3 ms de relé se energiza 7 ms después del cruce
+        text = generate(config_with(zero_cross={"pin": "A5", "mains_hz": 50, "relay_operate_ms": 3}))
+        self.assertIn("constexpr unsigned long MAINS_HALF_PERIOD_US = 10000UL;", text)
+        self.assertIn("constexpr unsigned long RELAY_SWITCH_DELAY_US = 7000UL;", text)
+        self.assertIn("#define ZERO_CROSS_VECTOR PCINT1_vect", text)
+
+    def test_command_line(self):
+        with tempfile.TemporaryDirectory() as directory:
+            source = os.path.join(directory, "board.json")
+            output = os.path.join(directory, "board_config.h")
+            with open(source, "w", encoding="utf-8") as handle:
+                json.dump(config_with(fixed_crop="Tomate"), handle)
+            result = subprocess.run([sys.executable, TOOL, source, output], capture_output=True, text=True)
+            self.assertNotEqual(0, result.returncode)
+            self.assertIn("fixed_crop: el cultivo Tomate no está en la lista", result.stderr)
+            self.assertFalse(os.path.exists(output))
+
+            with open(source, "w", encoding="utf-8") as handle:
+                json.dump(config_with(), handle)
+            result = subprocess.run([sys.executable, TOOL, source, output], capture_output=True, text=True)
+            self.assertEqual(0, result.returncode, result.stderr)
+            self.assertTrue(os.path.exists(output))
+
+
+if __name__ == "__main__":
+    unittest.main()
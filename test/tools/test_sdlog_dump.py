@@ -0,0 +1,136 @@
+"""Lectura del registro de la tarjeta SD con tools/sdlog_dump.py.
+
+Arma una imagen con bloques en el formato de include/sd_log.h (cabecera, lecturas y
+suma de cada registro) y comprueba las lecturas convertidas, los registros dañados y la
+cuenta de lecturas perdidas por arranque.
+
+Uso:
+    python test/tools/test_sdlog_dump.py
+"""
+
+import io
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TOOL = os.path.join(HERE, "..", "..", "tools", "sdlog_dump.py")
+sys.path.insert(0, os.path.dirname(TOOL))
+
+import sdlog_dump  # noqa: E402
+
+START_BLOCK = 4
+BLOCKS = 8
+CALIBRATION = {"temperature_offset": -50, "adc_max": 1023, "vcc": 5.0}
+
+
+def seal(record):
+    return record + bytes([sum(record) & 0xFF])
+
+
+def header(boot, number, vref_mv=5000, lost=0):
+    return seal(sdlog_dump.HEADER.pack(ord("H"), sdlog_dump.VERSION, boot, number, number * 310000, vref_mv, lost))
+
+
+def reading(millis, raw_temp=153, raw_hum=409, flags=0, crop=1):
+    return seal(sdlog_dump.READING.pack(ord("R"), flags, millis, raw_temp, raw_hum, 98, 7, crop))
+
+
+def block(boot, number, records, vref_mv=5000, lost=0):
+    data = header(boot, number, vref_mv, lost) + b"".join(records)
+    return data + b"\xff" * (sdlog_dump.BLOCK_SIZE - len(data))
+
+
+def image(blocks):
+    """Imagen con la zona desde START_BLOCK; lo anterior simula el MBR y las particiones."""
+    return b"\x00" * (START_BLOCK * sdlog_dump.BLOCK_SIZE) + b"".join(blocks)
+
+
+def full(boot, number, base_ms, **kwargs):
+    return block(boot, number, [reading(base_ms + i * 10000) for i in range(sdlog_dump.BLOCK_SIZE // sdlog_dump.RECORD_SIZE - 1)], **kwargs)
+
+
+class SdLogDumpTest(unittest.TestCase):
+    def read(self, data):
+        lost = {}
+        source = io.BytesIO(data)
+        rows = list(sdlog_dump.readings(sdlog_dump.read_blocks(source, START_BLOCK, BLOCKS), CALIBRATION, lost))
+        return rows, lost
+
+    def test_converts_readings(self):
+        # Anomalías fuga y deriva, bomba encendida, referencia interna de 1.083 V
+        rows, lost = self.read(image([block(3, 0, [reading(12345, raw_temp=620, raw_hum=512, flags=0b101011, crop=2)], vref_mv=1083)]))
+        self.assertEqual(1, len(rows))
+        row = rows[0]
+        self.assertEqual(3, row["arranque"])
+        self.assertEqual(12.345, row["segundos"])
+        self.assertAlmostEqual(620 * 1.083 / 1023 * 100 - 50, row["temperatura"], places=2)
+        self.assertAlmostEqual(512 * 5.0 / 1023 * 100, row["humedad"], places=2)
+        self.assertEqual(1, row["bomba"])
+        self.assertEqual(1, row["alarma_latencia"])
+        self.assertEqual("fuga|deriva", row["anomalias"])
+        self.assertEqual(2, row["cultivo"])
+        self.assertEqual({3: 0}, lost)
+
+    def test_reads_until_first_unwritten_block(self):
+        blocks = [full(1, 0, 0), full(1, 1, 310000), block(2, 2, [reading(0)])]
+        # Un bloque viejo de otra zona más adelante no se lee: el número no sigue
+        blocks += [b"\xff" * sdlog_dump.BLOCK_SIZE, full(1, 4, 0)]
+        rows, _ = self.read(image(blocks))
+        self.assertEqual(2 * 31 + 1, len(rows))
+        self.assertEqual([0, 1, 2], sorted(set(row["bloque"] for row in rows)))
+
+    def test_stops_at_bad_header(self):
+        second = bytearray(full(1, 1, 310000))
+        second[5] ^= 0x01  # Número de bloque dañado: la suma no coincide
+        rows, _ = self.read(image([full(1, 0, 0), bytes(second), full(1, 2, 620000)]))
+        self.assertEqual(31, len(rows))
+
+    def test_skips_torn_records(self):
+        records = [reading(1000), reading(2000), reading(3000)]
+        torn = bytearray(records[1])
+        torn[6] ^= 0x10
+        records[1] = bytes(torn)
+        # El apagón deja el resto del bloque con lo que tenía la tarjeta
+        rows, _ = self.read(image([block(1, 0, records + [b"\x00" * 16])]))
+        self.assertEqual([1.0, 3.0], [row["segundos"] for row in rows])
+
+    def test_counts_lost_readings_per_boot(self):
+        blocks = [full(1, 0, 0), full(1, 1, 310000, lost=31), full(2, 2, 0, lost=4), full(2, 3, 310000, lost=255)]
+        _, lost = self.read(image(blocks))
+        self.assertEqual({1: 31, 2: 259}, lost)
+
+    def test_command_line(self):
+        with tempfile.TemporaryDirectory() as directory:
+            config = os.path.join(directory, "board.json")
+            with open(config, "w") as handle:
+                json.dump({"calibration": CALIBRATION, "sd_log": {"start_block": START_BLOCK, "blocks": BLOCKS}}, handle)
+            card = os.path.join(directory, "sd.img")
+            with open(card, "wb") as handle:
+                handle.write(image([full(1, 0, 0), full(2, 1, 0, lost=5)]))
+            output = os.path.join(directory, "lecturas.csv")
+            result = subprocess.run([sys.executable, TOOL, "--config", config, card, output], capture_output=True, text=True)
+            self.assertEqual(0, result.returncode, result.stderr)
+            self.assertIn("62 lecturas de 2 arranques, 5 perdidas", result.stderr)
+            self.assertIn("arranque 2: 5 lecturas perdidas", result.stderr)
+            with open(output) as handle:
+                self.assertEqual(63, len(handle.readlines()))
+
+            empty = os.path.join(directory, "vacia.img")
+            with open(empty, "wb") as handle:
+                handle.write(b"\xff" * (START_BLOCK + BLOCKS) * sdlog_dump.BLOCK_SIZE)
+            result = subprocess.run([sys.executable, TOOL, "--config", config, empty, "-"], capture_output=True, text=True)
+            self.assertNotEqual(0, result.returncode)
+
+    def test_default_config_has_zone(self):
+        with open(sdlog_dump.DEFAULT_CONFIG) as handle:
+            log = json.load(handle)["sd_log"]
+        self.assertGreater(log["start_block"], 0)
+        self.assertGreater(log["blocks"], 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,94 @@
+"""Búsqueda de los envíos del firmware con tools/serial_frames.py.
+
+Mezcla en un mismo flujo envíos del perfilador, de las trazas y de la telemetría, con
+ruido, sumas incorrectas y un envío cortado al final, y comprueba que cada herramienta
+lee solo los suyos.
+
+Uso:
+    python test/tools/test_serial_frames.py
+"""
+
+import os
+import struct
+import sys
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, "..", "..", "tools"))
+
+import profile_report  # noqa: E402
+import serial_frames  # noqa: E402
+import telemetry_decode  # noqa: E402
+import trace_convert  # noqa: E402
+
+# Tipo de prueba: una cabecera de un byte con el largo de los datos que siguen
+LENGTHS = {ord("X"): (1, lambda header: 1 + header[0])}
+
+
+def frame(tag, body):
+    payload = bytes([tag]) + body
+    return serial_frames.SYNC + payload + bytes([sum(payload) & 0xFF])
+
+
+def profile_frame(shift, buckets, lost=0):
+    body = profile_report.HEADER.pack(shift, len(buckets), sum(buckets), lost) + struct.pack("<%dH" % len(buckets), *buckets)
+    return frame(profile_report.TAG, body)
+
+
+def trace_frame(events, dropped=0):
+    body = trace_convert.HEADER.pack(len(events), dropped)
+    for task, end, ticks in events:
+        body += bytes([task << 1 | end]) + ticks.to_bytes(3, "little")
+    return frame(trace_convert.TAG, body)
+
+
+def telemetry_frame(sequence, payload):
+    return frame(telemetry_decode.TAG, telemetry_decode.HEADER.pack(sequence, 0, len(payload)) + payload)
+
+
+class ScanTest(unittest.TestCase):
+    def test_frames_and_consumed(self):
+        data = b"ruido" + frame(ord("X"), b"\x02ab") + frame(ord("X"), b"\x00")
+        # El último byte queda sin leer por si es el comienzo del SYNC siguiente
+        self.assertEqual(serial_frames.scan(data, LENGTHS), ([(ord("X"), b"\x02ab"), (ord("X"), b"\x00")], len(data) - 1))
+
+    def test_unknown_tag_and_bad_checksum_skipped(self):
+        damaged = bytearray(frame(ord("X"), b"\x01z"))
+        damaged[-1] ^= 0xFF
+        data = frame(ord("Y"), b"\x01z") + bytes(damaged) + frame(ord("X"), b"\x01w")
+        frames, consumed = serial_frames.scan(data, LENGTHS)
+        self.assertEqual(frames, [(ord("X"), b"\x01w")])
+        self.assertEqual(consumed, len(data) - 1)
+
+    def test_sync_inside_a_frame(self):
+        # Un SYNC dentro del contenido no corta el envío
+        body = b"\x04" + serial_frames.SYNC + b"ok"
+        self.assertEqual(serial_frames.scan(frame(ord("X"), body), LENGTHS)[0], [(ord("X"), body)])
+
+    def test_incomplete_frame_kept_for_next_chunk(self):
+        whole = frame(ord("X"), b"\x03abc")
+        for cut in range(1, len(whole)):
+            data = b"\x00" + whole[:cut]
+            frames, consumed = serial_frames.scan(data, LENGTHS)
+            self.assertEqual(frames, [])
+            # Se guarda desde el SYNC, aunque solo haya llegado su primer byte
+            self.assertEqual(consumed, 1)
+            frames, _ = serial_frames.scan(data[consumed:] + whole[cut:], LENGTHS)
+            self.assertEqual(frames, [(ord("X"), b"\x03abc")])
+
+
+class SharedPortTest(unittest.TestCase):
+    def test_each_tool_reads_its_frames(self):
+        payload = b"\xff" + bytes(range(10))
+        data = (b"\x5a\xa5" + profile_frame(2, [0, 7, 1]) + trace_frame([(1, 0, 100), (1, 1, 180)], dropped=2)
+                + telemetry_frame(5, payload) + trace_frame([]) + profile_frame(0, [3]))
+
+        self.assertEqual(profile_report.read_frames(data), [(2, [0, 7, 1], 0), (0, [3], 0)])
+        self.assertEqual(trace_convert.read_frames(data), [(2, [(1, 0, 100), (1, 1, 180)]), (0, [])])
+        frames, consumed = telemetry_decode.read_frames(data)
+        self.assertEqual(frames, [(telemetry_decode.TAG, telemetry_decode.HEADER.pack(5, 0, len(payload)) + payload)])
+        self.assertEqual(consumed, len(data) - 1)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,141 @@
+"""Ajuste de los parámetros del suelo con tools/soil_fit.py.
+
+Genera registros como los de tools/sdlog_dump.py con el mismo balance que soilStep()
+(lib/SoilSim/src/soil_model.h), con parámetros conocidos, riego por histéresis y
+temperatura con ciclo diario, y comprueba que el ajuste los recupera. También la
+división del registro en tramos y el promedio de las lecturas.
+
+Uso:
+    python test/tools/test_soil_fit.py
+"""
+
+import csv
+import math
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TOOL = os.path.join(HERE, "..", "..", "tools", "soil_fit.py")
+sys.path.insert(0, os.path.dirname(TOOL))
+
+import soil_fit  # noqa: E402
+
+FIELDS = ["arranque", "segundos", "temperatura", "bomba", "humedad"]
+# Distintos de los valores por defecto, que son uno de los puntos de partida
+SOIL = {"field_capacity": 55.0, "drainage_rate": 0.8, "evaporation_coeff": 0.35, "pump_gain": 40.0, "probe_lag_seconds": 200.0}
+
+
+def diurnal(mean, swing, hour):
+    """Mínima a las 6 y máxima a las 18, como diurnalTemperature()."""
+    return mean - swing * math.cos((hour - 6) * math.pi / 12)
+
+
+def simulate(soil, hours, low, high, every=10, boot=1, start=0.0):
+    """Filas del CSV de sdlog_dump.py: el modelo avanza de a un segundo y se registra cada every segundos."""
+    moisture = probe = (low + high) / 2
+    pump = False
+    follow = 1.0 - math.exp(-1.0 / soil["probe_lag_seconds"])
+    rows = []
+    for second in range(int(hours * 3600)):
+        temperature = diurnal(20, 6, second / 3600.0)
+        excess = moisture - soil["field_capacity"]
+        drainage = soil["drainage_rate"] * excess if excess > 0 else 0.0
+        evaporation = soil["evaporation_coeff"] * max(temperature, 0.0) * moisture / soil["field_capacity"]
+        moisture += ((soil["pump_gain"] if pump else 0.0) - evaporation - drainage) / 3600.0
+        moisture = min(max(moisture, 0.0), 100.0)
+        probe += (moisture - probe) * follow
+        if second % every == 0:
+            rows.append({"arranque": boot, "segundos": start + second, "temperatura": round(temperature, 2),
+                         "bomba": int(pump), "humedad": round(probe, 2)})
+        if probe < low:
+            pump = True
+        elif probe > high:
+            pump = False
+    return rows
+
+
+def write_csv(path, rows):
+    with open(path, "w", newline="") as handle:
+        writer = csv.DictWriter(handle, fieldnames=FIELDS)
+        writer.writeheader()
+        writer.writerows(rows)
+
+
+def read_soil(path):
+    values = {}
+    with open(path) as handle:
+        for line in handle:
+            if not line.startswith("#"):
+                name, value = line.split("=")
+                values[name.strip()] = float(value)
+    return values
+
+
+class SoilFitTest(unittest.TestCase):
+    def fit(self, rows, *extra):
+        with tempfile.TemporaryDirectory() as directory:
+            trace = os.path.join(directory, "cama.csv")
+            write_csv(trace, rows)
+            result = subprocess.run([sys.executable, TOOL, "--out-dir", directory, "--starts", "4", "--jobs", "2"] + list(extra) + [trace],
+                                    capture_output=True, text=True)
+            self.assertEqual(0, result.returncode, result.stderr)
+            return read_soil(os.path.join(directory, "cama.soil")), result.stderr
+
+    def test_average_keeps_pump_fraction(self):
+        rows = [(1, float(second), 20.0, 1 if second < 20 else 0, 50.0 + second / 10) for second in range(0, 60, 10)]
+        averaged = list(soil_fit.average(rows, 30))
+        self.assertEqual(2, len(averaged))
+        boot, seconds, temperature, pump, humidity = averaged[0]
+        self.assertEqual((1, 10.0, 20.0), (boot, seconds, temperature))
+        self.assertAlmostEqual(2 / 3, pump)
+        self.assertAlmostEqual(51.0, humidity)
+        self.assertEqual(0.0, averaged[1][3])
+
+    def test_splits_segments_on_gaps_and_boots(self):
+        rows = simulate(SOIL, 0.5, 50, 60)
+        # Un hueco de una hora (apagón) y un arranque nuevo que vuelve a contar desde 0
+        rows += simulate(SOIL, 0.5, 50, 60, start=5400)
+        rows += simulate(SOIL, 0.5, 50, 60, boot=2)
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "cama.csv")
+            write_csv(path, rows)
+            trace = soil_fit.load_trace(path, None, 30.0)
+        self.assertEqual("cama", trace.name)
+        self.assertEqual(3, len(trace.segments))
+        for segment in trace.segments:
+            self.assertEqual(0.0, segment[0][0])
+            self.assertTrue(all(gap == 30.0 for gap, _, _, _ in segment[1:]))
+
+    def test_recovers_parameters_with_drainage(self):
+        # El riego sube por encima de la capacidad de campo, así que el drenaje se ve en el registro
+        values, warnings = self.fit(simulate(SOIL, 24, 45, 70))
+        self.assertAlmostEqual(SOIL["field_capacity"], values["field_capacity"], delta=2.0)
+        self.assertAlmostEqual(SOIL["drainage_rate"], values["drainage_rate"], delta=0.2 * SOIL["drainage_rate"])
+        self.assertAlmostEqual(SOIL["evaporation_coeff"], values["evaporation_coeff"], delta=0.1 * SOIL["evaporation_coeff"])
+        self.assertAlmostEqual(SOIL["pump_gain"], values["pump_gain"], delta=0.1 * SOIL["pump_gain"])
+        self.assertAlmostEqual(SOIL["probe_lag_seconds"], values["probe_lag_seconds"], delta=0.5 * SOIL["probe_lag_seconds"])
+        self.assertNotIn("capacidad de campo", warnings)
+
+    def test_warns_without_drainage(self):
+        # Sin drenaje solo el cociente evaporación / capacidad de campo está determinado
+        values, warnings = self.fit(simulate(SOIL, 24, 35, 50))
+        ratio = SOIL["evaporation_coeff"] / SOIL["field_capacity"]
+        self.assertAlmostEqual(ratio, values["evaporation_coeff"] / values["field_capacity"], delta=0.1 * ratio)
+        self.assertAlmostEqual(SOIL["pump_gain"], values["pump_gain"], delta=0.1 * SOIL["pump_gain"])
+        self.assertIn("solo el cociente evaporación/capacidad es confiable", warnings)
+
+    def test_rejects_unknown_csv(self):
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "otra.csv")
+            with open(path, "w") as handle:
+                handle.write("a,b\n1,2\n")
+            result = subprocess.run([sys.executable, TOOL, "--out-dir", directory, path], capture_output=True, text=True)
+            self.assertNotEqual(0, result.returncode)
+            self.assertIn("no es un CSV de sdlog_dump.py", result.stderr)
+
+
+if __name__ == "__main__":
+    unittest.main()
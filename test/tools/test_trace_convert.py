@@ -0,0 +1,109 @@
+"""Conversión de las trazas del firmware con tools/trace_convert.py.
+
+Arma envíos en el formato de include/trace.h (sincronismo, cabecera, eventos y suma) y
+comprueba la lectura de los envíos y los eventos de Chrome, en especial cuando se
+perdieron eventos entre dos envíos.
+
+Uso:
+    python test/tools/test_trace_convert.py
+"""
+
+import os
+import sys
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, "..", "..", "tools"))
+
+import trace_convert  # noqa: E402
+
+SENSE, CONTROL, DISPLAY = 0, 1, 2
+BEGIN, END = 0, 1
+
+
+def frame(events, dropped=0):
+    """Envío con eventos (tarea, fin, ticks)."""
+    body = bytes([trace_convert.TAG]) + trace_convert.HEADER.pack(len(events), dropped)
+    for task, end, ticks in events:
+        body += bytes([task << 1 | end, ticks & 0xFF, ticks >> 8 & 0xFF, ticks >> 16 & 0xFF])
+    return trace_convert.serial_frames.SYNC + body + bytes([sum(body) & 0xFF])
+
+
+def convert(*frames):
+    return trace_convert.to_chrome(trace_convert.read_frames(b"".join(frames)))
+
+
+def slices(trace):
+    return [(event["ph"], event["name"], event["ts"]) for event in trace]
+
+
+class ReadFramesTest(unittest.TestCase):
+    def test_frames_between_noise(self):
+        data = b"\x00\xa5" + frame([(SENSE, BEGIN, 10), (SENSE, END, 20)]) + b"\xa5\x5a\x01" + frame([], 3)
+        self.assertEqual(trace_convert.read_frames(data),
+                         [(0, [(SENSE, BEGIN, 10), (SENSE, END, 20)]), (3, [])])
+
+    def test_bad_checksum_skipped(self):
+        damaged = bytearray(frame([(SENSE, BEGIN, 10)]))
+        damaged[-2] ^= 1
+        self.assertEqual(trace_convert.read_frames(bytes(damaged) + frame([(CONTROL, END, 5)])),
+                         [(0, [(CONTROL, END, 5)])])
+
+    def test_incomplete_frame_at_end(self):
+        self.assertEqual(trace_convert.read_frames(frame([(SENSE, BEGIN, 10)])[:-1]), [])
+
+
+class ToChromeTest(unittest.TestCase):
+    def test_nested_tasks(self):
+        trace, dropped = convert(frame([(SENSE, BEGIN, 100), (DISPLAY, BEGIN, 110), (DISPLAY, END, 150)]),
+                                 frame([(SENSE, END, 200)]))
+        self.assertEqual(dropped, 0)
+        self.assertEqual(slices(trace), [("B", "sense", 0), ("B", "display", 40), ("E", "display", 200),
+                                         ("E", "sense", 400)])
+
+    def test_counter_wrap(self):
+        wrap = trace_convert.TICK_WRAP
+        trace, _ = convert(frame([(SENSE, BEGIN, wrap - 10), (SENSE, END, 5)]))
+        self.assertEqual([event["ts"] for event in trace], [0, 15 * trace_convert.TICK_US])
+
+    def test_loss_marked_inside_gap(self):
+        trace, dropped = convert(frame([(SENSE, BEGIN, 0), (SENSE, END, 100)]),
+                                 frame([(CONTROL, BEGIN, 300), (CONTROL, END, 350)], dropped=4))
+        self.assertEqual(dropped, 4)
+        marker = trace[2]
+        self.assertEqual((marker["ph"], marker["name"]), ("i", "4 eventos perdidos"))
+        self.assertEqual(marker["ts"], 200 * trace_convert.TICK_US)
+
+    def test_open_slice_closed_at_loss(self):
+        # El fin de sense se perdió: sense termina en la marca y no abarca a control
+        trace, _ = convert(frame([(SENSE, BEGIN, 0)]),
+                           frame([(CONTROL, BEGIN, 200), (CONTROL, END, 250)], dropped=1))
+        self.assertEqual(slices(trace), [("B", "sense", 0), ("i", "1 eventos perdidos", 400), ("E", "sense", 400),
+                                         ("B", "control", 800), ("E", "control", 1000)])
+        self.assertEqual(trace[2]["args"], {"fin": "eventos perdidos"})
+
+    def test_end_without_begin_dropped(self):
+        # El inicio de display se perdió, y sense terminó antes de empezar la captura
+        trace, _ = convert(frame([(SENSE, END, 0), (CONTROL, BEGIN, 10)]),
+                           frame([(DISPLAY, END, 30), (CONTROL, END, 40)], dropped=1))
+        self.assertEqual(slices(trace), [("B", "control", 40), ("i", "1 eventos perdidos", 80),
+                                         ("E", "control", 80)])
+        begins = sum(1 for event in trace if event["ph"] == "B")
+        ends = sum(1 for event in trace if event["ph"] == "E")
+        self.assertEqual(begins, ends)
+
+    def test_loss_in_frame_without_events(self):
+        # La marca espera al primer evento siguiente para quedar dentro del hueco
+        trace, dropped = convert(frame([(SENSE, BEGIN, 0), (SENSE, END, 10)]), frame([], dropped=2),
+                                 frame([(SENSE, BEGIN, 30)], dropped=1))
+        self.assertEqual(dropped, 3)
+        self.assertEqual(slices(trace)[2], ("i", "3 eventos perdidos", 20 * trace_convert.TICK_US))
+
+    def test_loss_after_last_event(self):
+        trace, _ = convert(frame([(SENSE, BEGIN, 0), (CONTROL, BEGIN, 10)]), frame([], dropped=2))
+        self.assertEqual(slices(trace)[2:], [("i", "2 eventos perdidos", 40), ("E", "control", 40),
+                                             ("E", "sense", 40)])
+
+
+if __name__ == "__main__":
+    unittest.main()
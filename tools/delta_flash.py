@@ -0,0 +1,194 @@
+"""Actualiza el firmware escribiendo solo las páginas de flash que cambiaron.
+
+Compara la imagen instalada en la placa (el .hex con el que se programó, guardado
+aparte) con la nueva página por página (128 bytes en el ATmega328P) y envía al
+bootloader de la placa (Optiboot, protocolo STK500v1) solo las páginas distintas. Un
+cambio pequeño, como un cultivo nuevo en la tabla, toca pocas páginas si el resto
+del código no se desplaza. Antes de escribir se puede leer la placa para confirmar
+que tiene la imagen base (--verify-base), y después se leen las páginas escritas para
+comprobarlas.
+
+Uso:
+    python tools/delta_flash.py --dry-run instalado.hex .pio/build/uno/firmware.hex
+    python tools/delta_flash.py --port /dev/ttyACM0 --verify-base instalado.hex .pio/build/uno/firmware.hex
+
+Tras actualizar conviene reemplazar instalado.hex por la imagen nueva.
+"""
+
+import argparse
+import sys
+import time
+
+PAGE_SIZE = 128          # Bytes por página de flash del ATmega328P
+FLASH_SIZE = 32768 - 512  # Flash de la aplicación (Optiboot ocupa los últimos 512 bytes)
+
+# Protocolo STK500v1 que entiende Optiboot
+STK_OK = 0x10
+STK_INSYNC = 0x14
+CRC_EOP = 0x20
+STK_GET_SYNC = 0x30
+STK_ENTER_PROGMODE = 0x50
+STK_LEAVE_PROGMODE = 0x51
+STK_LOAD_ADDRESS = 0x55
+STK_PROG_PAGE = 0x64
+STK_READ_PAGE = 0x74
+
+
+def read_hex(path):
+    """Imagen de la flash a partir de un archivo Intel HEX (0xFF donde no hay datos)."""
+    image = bytearray(b"\xff" * FLASH_SIZE)
+    used = 0
+    base = 0
+    with open(path) as handle:
+        for number, line in enumerate(handle, 1):
+            line = line.strip()
+            if not line:
+                continue
+            if not line.startswith(":"):
+                sys.exit("%s:%d: no es un archivo Intel HEX" % (path, number))
+            try:
+                record = bytes.fromhex(line[1:])
+            except ValueError:
+                sys.exit("%s:%d: no es un archivo Intel HEX" % (path, number))
+            if len(record) < 5 or len(record) != record[0] + 5:
+                sys.exit("%s:%d: el largo del registro no coincide con sus datos" % (path, number))
+            if sum(record) & 0xFF:
+                sys.exit("%s:%d: suma de comprobación incorrecta" % (path, number))
+            length, address, kind = record[0], record[1] << 8 | record[2], record[3]
+            data = record[4:4 + length]
+            if kind == 0x00:
+                start = base + address
+                if start + length > FLASH_SIZE:
+                    sys.exit("%s: la imagen no cabe en la flash de la aplicación" % path)
+                image[start:start + length] = data
+                used = max(used, start + length)
+            elif kind == 0x01:
+                break
+            elif kind == 0x02:
+                base = (data[0] << 8 | data[1]) << 4
+            elif kind == 0x04:
+                base = (data[0] << 8 | data[1]) << 16
+    return image, used
+
+
+def changed_pages(base, new, used):
+    """Direcciones de las páginas de la imagen nueva que difieren de la base.
+
+    Con used hasta el final de la más larga de las dos, si la nueva es más corta las
+    páginas donde la base tenía código también cambian: se escriben borradas (0xFF) y
+    la placa queda igual a la imagen nueva.
+    """
+    pages = []
+    for address in range(0, used, PAGE_SIZE):
+        if base[address:address + PAGE_SIZE] != new[address:address + PAGE_SIZE]:
+            pages.append(address)
+    return pages
+
+
+def page_bytes(count):
+    """Bytes por el puerto serie para escribir count páginas (dirección + página)."""
+    return count * (4 + 5 + PAGE_SIZE)
+
+
+def open_port(port, baud):
+    """Abre el puerto serie y reinicia la placa para que atienda el bootloader."""
+    import serial  # pyserial
+
+    link = serial.Serial(port, baud, timeout=1)
+    # La placa se reinicia al bajar DTR y el bootloader atiende por unos instantes
+    link.dtr = False
+    time.sleep(0.1)
+    link.dtr = True
+    time.sleep(0.05)
+    link.reset_input_buffer()
+    return link
+
+
+class Bootloader:
+    """Comandos STK500v1 sobre un puerto ya abierto (open_port() o test/tools/stk500_emulator.py)."""
+
+    def __init__(self, link):
+        self.link = link
+
+    def command(self, request, reply_length=0):
+        self.link.write(bytes(request) + bytes([CRC_EOP]))
+        reply = self.link.read(reply_length + 2)
+        if len(reply) != reply_length + 2 or reply[0] != STK_INSYNC or reply[-1] != STK_OK:
+            raise IOError("el bootloader no respondió al comando 0x%02x" % request[0])
+        return reply[1:-1]
+
+    def sync(self):
+        for _ in range(10):
+            try:
+                self.command([STK_GET_SYNC])
+                return
+            except IOError:
+                self.link.reset_input_buffer()
+        raise IOError("no se pudo sincronizar con el bootloader")
+
+    def load_address(self, address):
+        word = address // 2
+        self.command([STK_LOAD_ADDRESS, word & 0xFF, word >> 8])
+
+    def write_page(self, address, data):
+        self.load_address(address)
+        self.command([STK_PROG_PAGE, len(data) >> 8, len(data) & 0xFF, ord("F")] + list(data))
+
+    def read_page(self, address):
+        self.load_address(address)
+        return self.command([STK_READ_PAGE, PAGE_SIZE >> 8, PAGE_SIZE & 0xFF, ord("F")], PAGE_SIZE)
+
+    def __enter__(self):
+        self.sync()
+        self.command([STK_ENTER_PROGMODE])
+        return self
+
+    def __exit__(self, *error):
+        try:
+            self.command([STK_LEAVE_PROGMODE])  # Optiboot salta a la aplicación
+        finally:
+            self.link.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("base", help="imagen instalada en la placa (.hex)")
+    parser.add_argument("new", help="imagen nueva (.hex)")
+    parser.add_argument("--port", help="puerto serie de la placa")
+    parser.add_argument("--baud", type=int, default=115200, help="velocidad del bootloader (Optiboot del Uno: 115200)")
+    parser.add_argument("--verify-base", action="store_true", help="lee la placa y cancela si no tiene la imagen base")
+    parser.add_argument("--dry-run", action="store_true", help="solo muestra las páginas que cambiarían")
+    args = parser.parse_args()
+
+    base, base_used = read_hex(args.base)
+    new, new_used = read_hex(args.new)
+    used = max(base_used, new_used)
+    pages = changed_pages(base, new, used)
+
+    # La comparación abarca también lo que la base tenía después del final de la nueva
+    compared = (used + PAGE_SIZE - 1) // PAGE_SIZE
+    full = (new_used + PAGE_SIZE - 1) // PAGE_SIZE
+    print("%d de %d páginas cambiaron: %d bytes por el puerto serie en lugar de %d (%.0f %%)"
+          % (len(pages), compared, page_bytes(len(pages)), page_bytes(full), 100.0 * len(pages) / max(full, 1)))
+    if args.dry_run or not pages:
+        return
+    if not args.port:
+        sys.exit("falta --port")
+
+    with Bootloader(open_port(args.port, args.baud)) as loader:
+        if args.verify_base:
+            for address in range(0, base_used, PAGE_SIZE):
+                if loader.read_page(address) != bytes(base[address:address + PAGE_SIZE]):
+                    sys.exit("la placa no tiene la imagen base (página 0x%04x): use una actualización completa" % address)
+
+        start = time.time()
+        for address in pages:
+            loader.write_page(address, new[address:address + PAGE_SIZE])
+        for address in pages:
+            if loader.read_page(address) != bytes(new[address:address + PAGE_SIZE]):
+                sys.exit("la página 0x%04x no quedó bien escrita: repita la actualización" % address)
+        print("%d páginas escritas y comprobadas en %.1f s" % (len(pages), time.time() - start))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,124 @@
+"""Perfil plano del firmware a partir de los histogramas del perfilador por muestreo.
+
+Lee los envíos del perfilador (include/profiler.h) desde el puerto serie o desde un
+archivo capturado, reparte las muestras de cada casilla entre las funciones del ELF
+que la ocupan y muestra el porcentaje de tiempo de cada función.
+
+Uso:
+    python tools/profile_report.py --port /dev/ttyACM0 --seconds 60 .pio/build/uno_profile/firmware.elf
+    python tools/profile_report.py --capture perfil.bin --folded perfil.folded firmware.elf
+
+El archivo --folded sirve para generar un flamegraph con flamegraph.pl o speedscope.
+Como solo se conoce la función interrumpida, cada pila tiene un único nivel.
+"""
+
+import argparse
+import bisect
+import struct
+import subprocess
+import sys
+
+import serial_frames
+
+TAG = ord("P")
+HEADER = struct.Struct("<BBIH")  # desplazamiento, casillas, muestras, fuera de rango
+
+
+def read_frames(data):
+    """Extrae (desplazamiento, casillas, fuera de rango) de cada envío válido."""
+    frames = []
+    lengths = {TAG: (HEADER.size, lambda header: HEADER.size + 2 * header[1])}
+    for _, body in serial_frames.scan(data, lengths)[0]:
+        shift, count, _samples, lost = HEADER.unpack_from(body)
+        buckets = struct.unpack_from("<%dH" % count, body, HEADER.size)
+        frames.append((shift, list(buckets), lost))
+    return frames
+
+
+def load_symbols(elf, nm):
+    """Símbolos de código ordenados por dirección: (inicio, fin, nombre) en bytes."""
+    output = subprocess.run([nm, "-n", "-S", "--demangle", elf], check=True, capture_output=True, text=True).stdout
+    symbols = []
+    for line in output.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) != 4 or parts[2] not in "tTwW":
+            continue
+        start = int(parts[0], 16)
+        size = int(parts[1], 16)
+        if size > 0:
+            symbols.append((start, start + size, parts[3]))
+    return symbols
+
+
+def attribute(frames, symbols):
+    """Reparte las muestras de cada casilla entre los símbolos según el solapamiento."""
+    starts = [symbol[0] for symbol in symbols]
+    totals = {}
+    unknown = 0
+    for shift, buckets, lost in frames:
+        unknown += lost
+        bucket_bytes = 2 << shift  # Las direcciones del contador de programa están en palabras
+        for index, count in enumerate(buckets):
+            if count == 0:
+                continue
+            low = index * bucket_bytes
+            high = low + bucket_bytes
+            first = max(bisect.bisect_right(starts, low) - 1, 0)
+            shares = []
+            for start, end, name in symbols[first:]:
+                if start >= high:
+                    break
+                overlap = min(end, high) - max(start, low)
+                if overlap > 0:
+                    shares.append((name, overlap))
+            covered = sum(overlap for _, overlap in shares)
+            if covered == 0:
+                unknown += count
+                continue
+            for name, overlap in shares:
+                totals[name] = totals.get(name, 0.0) + count * overlap / covered
+    return totals, unknown
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="firmware.elf del entorno uno_profile")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="puerto serie de la placa")
+    source.add_argument("--capture", help="archivo con los bytes recibidos por el puerto serie")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--seconds", type=float, default=30, help="tiempo de captura desde el puerto serie")
+    parser.add_argument("--save", help="guarda los bytes capturados para analizarlos después")
+    parser.add_argument("--folded", help="escribe las muestras en formato de pilas plegadas")
+    parser.add_argument("--nm", default="avr-nm", help="ejecutable de nm para AVR")
+    parser.add_argument("--top", type=int, default=25)
+    args = parser.parse_args()
+
+    if args.port:
+        data = serial_frames.capture(args.port, args.baud, args.seconds, args.save)
+    else:
+        with open(args.capture, "rb") as handle:
+            data = handle.read()
+
+    frames = read_frames(data)
+    if not frames:
+        sys.exit("no se encontraron histogramas del perfilador")
+
+    totals, unknown = attribute(frames, load_symbols(args.elf, args.nm))
+    samples = sum(totals.values()) + unknown
+    print("%d histogramas, %d muestras" % (len(frames), samples))
+    print("%8s %8s  %s" % ("muestras", "%", "función"))
+    for name, count in sorted(totals.items(), key=lambda item: -item[1])[: args.top]:
+        print("%8.0f %7.2f%%  %s" % (count, 100.0 * count / samples, name))
+    if unknown:
+        print("%8d %7.2f%%  (fuera del código)" % (unknown, 100.0 * unknown / samples))
+
+    if args.folded:
+        with open(args.folded, "w") as handle:
+            for name, count in sorted(totals.items()):
+                if round(count) > 0:
+                    handle.write("%s %d\n" % (name.replace(";", ":").replace(" ", "_"), round(count)))
+
+
+if __name__ == "__main__":
+    main()
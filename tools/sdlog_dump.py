@@ -0,0 +1,115 @@
+"""Extrae las lecturas registradas en la tarjeta SD (include/sd_log.h) a un archivo CSV.
+
+Lee la zona reservada de la tarjeta (o de una imagen, como la del entorno native con
+HOST_SD_IMAGE) bloque por bloque hasta el primero sin cabecera válida, y convierte las
+lecturas crudas del ADC con la calibración de la configuración de la placa. Los
+registros con la suma incorrecta (un bloque cortado por un apagón) se descartan. Al
+final muestra cuántas lecturas perdió el firmware (bloques rechazados por la tarjeta o
+cola llena), según la cuenta de la cabecera de cada bloque.
+
+Uso:
+    python tools/sdlog_dump.py /dev/sdX lecturas.csv
+    python tools/sdlog_dump.py --config config/board_sdlog.json sd.img -
+
+Leer el dispositivo de la tarjeta suele requerir permisos de administrador.
+"""
+
+import argparse
+import csv
+import json
+import os
+import struct
+import sys
+
+BLOCK_SIZE = 512
+RECORD_SIZE = 16
+VERSION = 1
+HEADER = struct.Struct("<BBHIIHB")  # tag, versión, arranque, bloque, millis, vref en mV, lecturas perdidas
+READING = struct.Struct("<BBIHHHHB")  # tag, estado, millis, temperatura, humedad, lecturas, relé, cultivo
+# Bits 2-5 del estado, en el orden de AnomalyDetector (include/anomaly_detector.h)
+ANOMALIES = ["atascada", "fuga", "evaporacion", "deriva"]
+DEFAULT_CONFIG = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "config", "board_sdlog.json")
+
+
+def sealed(record):
+    return sum(record[:-1]) & 0xFF == record[-1]
+
+
+def read_blocks(source, start_block, max_blocks):
+    """Genera (número de bloque, contenido) de los bloques escritos de la zona."""
+    source.seek(start_block * BLOCK_SIZE)
+    for index in range(max_blocks):
+        block = source.read(BLOCK_SIZE)
+        if len(block) < BLOCK_SIZE:
+            return
+        header = block[:RECORD_SIZE]
+        tag, version, _, number, _, _, _ = HEADER.unpack_from(header)
+        if tag != ord("H") or version != VERSION or not sealed(header) or number != index:
+            return
+        yield index, block
+
+
+def readings(blocks, calibration, lost):
+    """Lecturas convertidas de cada bloque, con el arranque al que pertenecen.
+
+    Suma en lost[arranque] las lecturas perdidas que anota la cabecera de cada bloque.
+    """
+    adc_max = calibration["adc_max"]
+    for index, block in blocks:
+        _, _, boot, _, _, vref_mv, lost_readings = HEADER.unpack_from(block)
+        lost[boot] = lost.get(boot, 0) + lost_readings
+        vref = vref_mv / 1000.0
+        for offset in range(RECORD_SIZE, BLOCK_SIZE, RECORD_SIZE):
+            record = block[offset:offset + RECORD_SIZE]
+            if record[0] != ord("R") or not sealed(record):
+                continue
+            _, flags, millis, raw_temp, raw_hum, samples, relay, crop = READING.unpack_from(record)
+            yield {
+                "arranque": boot,
+                "bloque": index,
+                "segundos": millis / 1000.0,
+                "temperatura": round(raw_temp * vref / adc_max * 100 + calibration["temperature_offset"], 2),
+                "humedad": round(raw_hum * calibration["vcc"] / adc_max * 100, 2),
+                "bomba": flags & 1,
+                "alarma_latencia": flags >> 1 & 1,
+                "anomalias": "|".join(name for bit, name in enumerate(ANOMALIES) if flags >> (2 + bit) & 1),
+                "lecturas_adc": samples,
+                "conmutaciones_rele": relay,
+                "cultivo": crop,
+            }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", help="dispositivo de la tarjeta o imagen")
+    parser.add_argument("output", help="archivo CSV de salida (- para la salida estándar)")
+    parser.add_argument("--config", default=DEFAULT_CONFIG, help="configuración de la placa con el bloque sd_log (por defecto config/board_sdlog.json)")
+    args = parser.parse_args()
+
+    with open(args.config) as handle:
+        config = json.load(handle)
+    log = config.get("sd_log")
+    if log is None or "start_block" not in log or "blocks" not in log:
+        sys.exit("%s no tiene el bloque sd_log con start_block y blocks" % args.config)
+
+    lost = {}
+    with open(args.source, "rb") as source:
+        rows = list(readings(read_blocks(source, log["start_block"], log["blocks"]), config["calibration"], lost))
+    if not rows:
+        sys.exit("no se encontraron lecturas")
+
+    output = sys.stdout if args.output == "-" else open(args.output, "w", newline="")
+    writer = csv.DictWriter(output, fieldnames=list(rows[0]))
+    writer.writeheader()
+    writer.writerows(rows)
+    if output is not sys.stdout:
+        output.close()
+
+    boots = len(set(row["arranque"] for row in rows))
+    print("%d lecturas de %d arranques, %d perdidas" % (len(rows), boots, sum(lost.values())), file=sys.stderr)
+    for boot in sorted(boot for boot, count in lost.items() if count > 0):
+        print("  arranque %d: %d lecturas perdidas" % (boot, lost[boot]), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,70 @@
+"""Envíos binarios del firmware por el puerto serie (include/serial_frame.h).
+
+Cada envío es SYNC, una letra con su tipo, el contenido y la suma de la letra y el
+contenido. El largo del contenido depende del tipo, y a veces de su cabecera, así que
+cada herramienta pasa los tipos que entiende: los demás se saltean, y el perfilador,
+las trazas y la telemetría pueden compartir el mismo puerto.
+
+Lo usan tools/profile_report.py, tools/trace_convert.py y tools/telemetry_decode.py.
+"""
+
+import time
+
+SYNC = b"\xa5\x5a"  # FRAME_SYNC_1, FRAME_SYNC_2
+
+
+def scan(data, lengths):
+    """Extrae los envíos válidos como (letra, contenido) y la posición hasta donde se leyó.
+
+    lengths asocia cada letra con (bytes de cabecera, función que recibe la cabecera y
+    devuelve el largo del contenido, cabecera incluida). Un envío incompleto al final
+    queda sin leer para completarlo con los bytes siguientes; uno con la suma incorrecta
+    se descarta y se sigue buscando desde el byte siguiente a su SYNC.
+    """
+    frames = []
+    position = 0
+    while True:
+        position = data.find(SYNC, position)
+        if position < 0:
+            return frames, max(len(data) - 1, 0)
+        start = position + len(SYNC) + 1
+        if start > len(data):
+            return frames, position
+        tag = data[start - 1]
+        if tag not in lengths:
+            position += 1
+            continue
+        header_size, body_size = lengths[tag]
+        if start + header_size > len(data):
+            return frames, position
+        end = start + body_size(data[start:start + header_size])
+        if end >= len(data):
+            return frames, position
+        if sum(data[start - 1:end]) & 0xFF != data[end]:
+            position += 1
+            continue
+        frames.append((tag, bytes(data[start:end])))
+        position = end + 1
+
+
+def read_port(port, baud, seconds, save=None):
+    """Bloques leídos del puerto hasta cumplir el tiempo (0: sin límite); save recibe una copia."""
+    import serial  # pyserial
+
+    with serial.Serial(port, baud, timeout=0.5) as link:
+        deadline = time.time() + seconds
+        while seconds == 0 or time.time() < deadline:
+            chunk = link.read(4096)
+            if save:
+                save.write(chunk)
+            yield chunk
+
+
+def capture(port, baud, seconds, save_path=None):
+    """Todos los bytes recibidos durante seconds, guardados también en save_path si se da."""
+    save = open(save_path, "wb") if save_path else None
+    try:
+        return b"".join(read_port(port, baud, seconds, save))
+    finally:
+        if save:
+            save.close()
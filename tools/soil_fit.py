@@ -0,0 +1,273 @@
+"""Ajusta los parámetros del modelo del suelo a las lecturas registradas de cada zona.
+
+Para que la simulación del entorno native se parezca a una cama real se buscan los
+parámetros de SoilParams (lib/SoilSim/src/soil_model.h) con los que el modelo,
+alimentado con la temperatura y la bomba registradas, reproduce mejor la humedad
+leída: capacidad de campo, drenaje, coeficiente de evaporación, aporte de la bomba y
+retardo de la sonda. El error es el cuadrático medio entre la sonda simulada y la
+leída; se minimiza con Nelder-Mead desde varios puntos de partida que se reparten
+entre los procesadores, y se queda el mejor de cada zona.
+
+Cada archivo de entrada es una zona y puede ser:
+- el CSV de tools/sdlog_dump.py (temperatura y humedad ya convertidas), o
+- el CSV de tools/telemetry_decode.py (lecturas crudas), con --config para convertirlas.
+Las lecturas se promedian en pasos de --step segundos, que también es el paso con el
+que se integra el modelo; la bomba queda como la fracción del paso en que estuvo encendida.
+
+Por cada zona se escribe <zona>.soil en --out-dir, que la simulación lee con
+HOST_SIM_SOIL=<zona>.soil.
+
+Uso:
+    python tools/soil_fit.py --out-dir suelos zona1.csv zona2.csv
+    python tools/soil_fit.py --config config/board_telemetry.json --jobs 8 telemetria.csv
+    HOST_SIM_SOIL=suelos/zona1.soil .pio/build/native/program
+
+Si la humedad casi no superó la capacidad de campo ajustada no hay drenaje en el
+registro, y la capacidad de campo y el coeficiente de evaporación no se pueden
+separar: solo su cociente es confiable.
+"""
+
+import argparse
+import csv
+import math
+import multiprocessing
+import os
+import random
+import sys
+
+# Nombre en el archivo .soil, mínimo, máximo y valor por defecto de SoilParams
+PARAMETERS = [
+    ("field_capacity", 20.0, 95.0, 60.0),     # %
+    ("drainage_rate", 0.01, 5.0, 0.5),        # fracción del exceso por hora
+    ("evaporation_coeff", 0.01, 2.0, 0.25),   # %/h por °C a capacidad de campo
+    ("pump_gain", 1.0, 300.0, 30.0),          # %/h con la bomba encendida
+    ("probe_lag_seconds", 1.0, 1800.0, 120.0),
+]
+MAX_GAP_SECONDS = 600.0  # Un hueco mayor en el registro (apagón, reinicio) vuelve a arrancar el modelo
+DRAINAGE_MARGIN = 2.0    # Humedad (%) sobre la capacidad de campo para que el drenaje se vea en el registro
+
+
+class Trace:
+    """Segmentos continuos de (segundos desde la muestra anterior, temperatura, bomba, humedad)."""
+
+    def __init__(self, name, segments):
+        self.name = name
+        self.segments = segments
+
+    def samples(self):
+        return sum(len(segment) for segment in self.segments)
+
+    def max_humidity(self):
+        return max(sample[3] for segment in self.segments for sample in segment)
+
+
+def load_sdlog(rows):
+    """Filas (arranque, segundos, temperatura, bomba, humedad) del CSV de sdlog_dump.py."""
+    for row in rows:
+        yield (row["arranque"], float(row["segundos"]), float(row["temperatura"]), int(row["bomba"]),
+               float(row["humedad"]))
+
+
+def load_telemetry(rows, config):
+    """Igual que load_sdlog para el CSV de telemetry_decode.py, que tiene las lecturas crudas."""
+    calibration = config["calibration"]
+    vref = calibration["vcc"]
+    if calibration.get("temperature_reference", "vcc") == "internal":
+        vref = calibration.get("internal_vref", 1.1)
+    for row in rows:
+        temperature = int(row["temperatura_cruda"]) * vref / calibration["adc_max"] * 100 + calibration["temperature_offset"]
+        humidity = int(row["humedad_cruda"]) * calibration["vcc"] / calibration["adc_max"] * 100
+        yield (0, float(row["segundos"]), temperature, int(row["estado"]) & 1, humidity)
+
+
+def average(rows, step):
+    """Promedia las lecturas en intervalos de step segundos; la bomba queda como fracción del intervalo."""
+    bucket = None
+    for boot, seconds, temperature, pump, humidity in rows:
+        key = (boot, int(seconds // step))
+        if bucket is not None and bucket[0] != key:
+            yield (bucket[0][0],) + tuple(total / bucket[2] for total in bucket[1])
+            bucket = None
+        if bucket is None:
+            bucket = [key, [0.0, 0.0, 0.0, 0.0], 0]
+        for index, value in enumerate((seconds, temperature, pump, humidity)):
+            bucket[1][index] += value
+        bucket[2] += 1
+    if bucket is not None:
+        yield (bucket[0][0],) + tuple(total / bucket[2] for total in bucket[1])
+
+
+def load_trace(path, config, step):
+    with open(path, newline="") as handle:
+        reader = csv.DictReader(handle)
+        if "humedad" in reader.fieldnames:
+            rows = list(average(load_sdlog(reader), step))
+        elif "humedad_cruda" in reader.fieldnames:
+            if config is None:
+                sys.exit("%s: las lecturas de la telemetría son crudas, falta --config" % path)
+            rows = list(average(load_telemetry(reader, config), step))
+        else:
+            sys.exit("%s: no es un CSV de sdlog_dump.py ni de telemetry_decode.py" % path)
+
+    segments = []
+    previous = None
+    for boot, seconds, temperature, pump, humidity in rows:
+        gap = None if previous is None else seconds - previous[1]
+        if gap is None or boot != previous[0] or gap <= 0 or gap > MAX_GAP_SECONDS:
+            segments.append([(0.0, temperature, pump, humidity)])
+        else:
+            segments[-1].append((gap, temperature, pump, humidity))
+        previous = (boot, seconds)
+    segments = [segment for segment in segments if len(segment) > 1]
+    if not segments:
+        sys.exit("%s: no hay lecturas suficientes" % path)
+    return Trace(os.path.splitext(os.path.basename(path))[0], segments)
+
+
+def simulate_error(values, trace):
+    """Error cuadrático medio de la sonda simulada (mismo modelo que soilStep) contra la leída."""
+    field_capacity, drainage_rate, evaporation_coeff, pump_gain, probe_lag = values
+    evaporation = evaporation_coeff / field_capacity
+    total = 0.0
+    count = 0
+    for segment in trace.segments:
+        moisture = probe = segment[0][3]
+        for gap, temperature, pump, humidity in segment[1:]:
+            excess = moisture - field_capacity
+            drainage = drainage_rate * excess if excess > 0 else 0.0
+            moisture += (pump_gain * pump - evaporation * max(temperature, 0.0) * moisture - drainage) * gap / 3600.0
+            moisture = min(max(moisture, 0.0), 100.0)
+            probe += (moisture - probe) * (1.0 - math.exp(-gap / probe_lag))
+            total += (probe - humidity) ** 2
+            count += 1
+    return total / count
+
+
+# Se busca en logaritmos para que los parámetros positivos de escalas distintas se muevan parejo
+def to_values(point):
+    return [min(max(math.exp(coordinate), low), high) for coordinate, (_, low, high, _) in zip(point, PARAMETERS)]
+
+
+def objective(point, trace):
+    values = to_values(point)
+    penalty = sum((math.log(value) - coordinate) ** 2 for value, coordinate in zip(values, point))
+    return simulate_error(values, trace) + 1e3 * penalty
+
+
+def nelder_mead(function, start, scale=0.3, iterations=400, tolerance=1e-6):
+    """Minimizador de Nelder-Mead sin dependencias (reflexión, expansión, contracción y encogimiento)."""
+    dimension = len(start)
+    simplex = [list(start)]
+    for index in range(dimension):
+        point = list(start)
+        point[index] += scale
+        simplex.append(point)
+    scores = [function(point) for point in simplex]
+
+    for _ in range(iterations):
+        order = sorted(range(dimension + 1), key=scores.__getitem__)
+        simplex = [simplex[index] for index in order]
+        scores = [scores[index] for index in order]
+        if scores[-1] - scores[0] < tolerance * (abs(scores[0]) + tolerance):
+            break
+
+        centroid = [sum(point[axis] for point in simplex[:-1]) / dimension for axis in range(dimension)]
+        worst = simplex[-1]
+
+        def towards(factor):
+            return [c + factor * (w - c) for c, w in zip(centroid, worst)]
+
+        reflected = towards(-1.0)
+        reflected_score = function(reflected)
+        if reflected_score < scores[0]:
+            expanded = towards(-2.0)
+            expanded_score = function(expanded)
+            if expanded_score < reflected_score:
+                simplex[-1], scores[-1] = expanded, expanded_score
+            else:
+                simplex[-1], scores[-1] = reflected, reflected_score
+        elif reflected_score < scores[-2]:
+            simplex[-1], scores[-1] = reflected, reflected_score
+        else:
+            contracted = towards(0.5 if reflected_score >= scores[-1] else -0.5)
+            contracted_score = function(contracted)
+            if contracted_score < min(reflected_score, scores[-1]):
+                simplex[-1], scores[-1] = contracted, contracted_score
+            else:
+                best = simplex[0]
+                simplex = [best] + [[b + 0.5 * (p - b) for b, p in zip(best, point)] for point in simplex[1:]]
+                scores = [scores[0]] + [function(point) for point in simplex[1:]]
+
+    best = min(range(dimension + 1), key=scores.__getitem__)
+    return simplex[best], scores[best]
+
+
+def starting_points(count, seed):
+    """Los valores por defecto y puntos al azar (reproducibles) dentro de los límites."""
+    generator = random.Random(seed)
+    points = [[math.log(default) for _, _, _, default in PARAMETERS]]
+    while len(points) < count:
+        points.append([generator.uniform(math.log(low), math.log(high)) for _, low, high, _ in PARAMETERS])
+    return points
+
+
+def fit_task(task):
+    trace, start, iterations = task
+    point, _ = nelder_mead(lambda candidate: objective(candidate, trace), start, iterations=iterations)
+    values = to_values(point)
+    return trace.name, simulate_error(values, trace), values
+
+
+def write_soil(path, trace, source, values, error):
+    with open(path, "w") as handle:
+        handle.write("# Suelo de %s ajustado con tools/soil_fit.py a partir de %s\n" % (trace.name, source))
+        handle.write("# %d lecturas, error cuadrático medio de la sonda %.3f %%\n" % (trace.samples(), math.sqrt(error)))
+        for (name, _, _, _), value in zip(PARAMETERS, values):
+            handle.write("%s = %.4g\n" % (name, value))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("traces", nargs="+", help="CSV de cada zona (el nombre del archivo es el de la zona)")
+    parser.add_argument("--config", help="configuración de la placa para convertir las lecturas crudas de la telemetría")
+    parser.add_argument("--out-dir", default=".", help="carpeta donde se escriben los archivos .soil")
+    parser.add_argument("--step", type=float, default=30.0, help="segundos de cada paso del modelo (las lecturas se promedian)")
+    parser.add_argument("--starts", type=int, default=8, help="puntos de partida por zona")
+    parser.add_argument("--iterations", type=int, default=400, help="iteraciones de Nelder-Mead por punto de partida")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count(), help="procesos en paralelo")
+    parser.add_argument("--seed", type=int, default=1, help="semilla de los puntos de partida")
+    args = parser.parse_args()
+
+    config = None
+    if args.config:
+        import json
+
+        with open(args.config) as handle:
+            config = json.load(handle)
+    traces = [load_trace(path, config, args.step) for path in args.traces]
+    sources = dict((trace.name, path) for trace, path in zip(traces, args.traces))
+    if len(sources) != len(traces):
+        sys.exit("dos archivos de entrada tienen el mismo nombre de zona")
+
+    tasks = [(trace, start, args.iterations) for trace in traces for start in starting_points(args.starts, args.seed)]
+    with multiprocessing.Pool(max(1, args.jobs)) as pool:
+        results = pool.map(fit_task, tasks, chunksize=1)
+
+    best = {}
+    for name, error, values in results:
+        if name not in best or error < best[name][0]:
+            best[name] = (error, values)
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    print("%-16s %8s %8s %8s %8s %8s %8s" % ("zona", "capacid.", "drenaje", "evapor.", "bomba", "sonda s", "error %"))
+    for trace in traces:
+        error, values = best[trace.name]
+        write_soil(os.path.join(args.out_dir, trace.name + ".soil"), trace, sources[trace.name], values, error)
+        print("%-16s %8.2f %8.3f %8.4f %8.2f %8.1f %8.3f" % ((trace.name,) + tuple(values) + (math.sqrt(error),)))
+        if trace.max_humidity() < values[0] + DRAINAGE_MARGIN:
+            print("  %s: la humedad casi no superó la capacidad de campo; solo el cociente evaporación/capacidad es confiable"
+                  % trace.name, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
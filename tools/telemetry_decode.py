@@ -0,0 +1,372 @@
+"""Descomprime la telemetría del firmware (include/telemetry_codec.h) a un archivo CSV.
+
+Lee los envíos de la telemetría desde el puerto serie o desde un archivo capturado,
+reconstruye los registros y muestra la relación de compresión: bytes que ocuparían
+los registros sin comprimir (10 bytes cada uno) contra los bytes recibidos. Si se
+pierde un envío (número de envío salteado o suma incorrecta) los registros se
+descartan hasta el próximo registro completo.
+
+Con --metrics-port publica en http://127.0.0.1:<puerto>/metrics, en formato Prometheus,
+la última lectura, el resumen del firmware (latencia, duración del ciclo, relé,
+fallas, anomalías), el pronóstico de la humedad de la zona y las estadísticas de la
+recepción. El texto se arma una vez por cada bloque recibido y las consultas solo lo
+copian, así no frenan la recepción.
+
+Uso:
+    python tools/telemetry_decode.py --port /dev/ttyUSB0 --seconds 600 telemetria.csv
+    python tools/telemetry_decode.py --capture telemetria.bin telemetria.csv
+    python tools/telemetry_decode.py --port /dev/ttyUSB0 --seconds 0 --metrics-port 9108 \\
+        --config config/board_telemetry.json telemetria.csv
+"""
+
+import argparse
+import csv
+import json
+import math
+import os
+import struct
+import sys
+import threading
+
+import serial_frames
+
+SYNC = serial_frames.SYNC
+TAG = ord("C")
+STATS_TAG = ord("S")
+HEADER = struct.Struct("<BBB")  # número de envío, registros descartados, bytes
+# Mismo orden que TelemetryStats en include/telemetry.h
+STATS = struct.Struct("<IHIIIBIIIHHHBHH")
+STATS_FIELDS = ["uptime", "loop_ms", "latency_p50", "latency_p99", "latency_max", "latency_alarm",
+                "relay_operations", "relay_synchronized", "relay_unsynchronized", "relay_dropped",
+                "sensor_faults", "telemetry_dropped", "anomalies", "dry_minutes", "evaporation_milli"]
+# Bits de AnomalyDetector::active() en include/anomaly_detector.h
+ANOMALIES = ["stuck", "leak", "evaporation", "drift"]
+NO_CROSSING = 0xFFFF  # MoistureForecaster::NO_CROSSING
+FORECAST_HOURS = [1, 3, 6]  # Horizontes de la humedad prevista
+TOKEN_RUN = 0x80
+TOKEN_KEYFRAME = 0xFF
+MASK = 0xFFFF
+SAMPLE_PERIOD_S = 98 * 1024e-6  # Periodo de las lecturas del ADC (SAMPLE_PERIOD_TICKS en sensor_sampler.h)
+
+# Mismo orden que TelemetryField en include/telemetry_codec.h
+FIELDS = ["tiempo", "temperatura_cruda", "humedad_cruda", "estado", "conmutaciones_rele"]
+RAW_RECORD_BYTES = 2 * len(FIELDS)
+FRAME_OVERHEAD = len(SYNC) + 1 + HEADER.size + 1
+# Cabecera y largo del contenido de cada tipo de envío
+FRAME_LENGTHS = {TAG: (HEADER.size, lambda header: HEADER.size + header[2]), STATS_TAG: (0, lambda header: STATS.size)}
+
+
+def read_frames(data):
+    """Extrae los envíos válidos como (letra, contenido) y la posición hasta donde se leyó.
+
+    Un envío incompleto al final queda sin leer para completarlo con los bytes siguientes.
+    """
+    return serial_frames.scan(data, FRAME_LENGTHS)
+
+
+def varint(payload, position):
+    value = 0
+    shift = 0
+    while True:
+        byte = payload[position]
+        position += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if byte < 0x80:
+            return value & MASK, position
+
+
+def unzigzag(value):
+    return (value >> 1) ^ (-(value & 1) & MASK)
+
+
+class Decoder:
+    def __init__(self):
+        self.previous = None  # None hasta recibir un registro completo
+        self.time_delta = 0
+
+    def lose_sync(self):
+        self.previous = None
+
+    def decode(self, payload):
+        """Registros del envío; los que dependen de un registro perdido se descartan."""
+        records = []
+        position = 0
+        while position < len(payload):
+            token = payload[position]
+            position += 1
+            if token == TOKEN_KEYFRAME:
+                values = []
+                for _ in FIELDS:
+                    value, position = varint(payload, position)
+                    values.append(value)
+                self.time_delta = 0
+                self.previous = values
+                records.append(list(values))
+            elif token & TOKEN_RUN:
+                for _ in range(token & 0x7F):
+                    self.advance([0] * len(FIELDS), records)
+            else:
+                residuals = [0] * len(FIELDS)
+                for field in range(len(FIELDS)):
+                    if token & (1 << field):
+                        value, position = varint(payload, position)
+                        residuals[field] = unzigzag(value)
+                self.advance(residuals, records)
+        return records
+
+    def advance(self, residuals, records):
+        if self.previous is None:
+            return
+        self.time_delta = (self.time_delta + residuals[0]) & MASK
+        values = [(self.previous[0] + self.time_delta) & MASK]
+        values += [(self.previous[i] + residuals[i]) & MASK for i in range(1, len(FIELDS))]
+        self.previous = values
+        records.append(list(values))
+
+
+class Ingest:
+    """Estado de la recepción: registros, último resumen y contadores."""
+
+    def __init__(self):
+        self.decoder = Decoder()
+        self.expected = None
+        self.frames = 0
+        self.stats_frames = 0
+        self.records = 0
+        self.lost = 0
+        self.dropped = 0
+        self.payload_bytes = 0
+        self.received_bytes = 0
+        self.elapsed = 0
+        self.last = None
+        self.stats = None
+
+    def add(self, frames):
+        """Procesa los envíos y devuelve las filas nuevas (segundos y campos)."""
+        rows = []
+        for tag, body in frames:
+            if tag == STATS_TAG:
+                self.stats = dict(zip(STATS_FIELDS, STATS.unpack(body)))
+                self.stats_frames += 1
+                self.received_bytes += len(SYNC) + 2 + STATS.size
+                continue
+            sequence, dropped, _ = HEADER.unpack_from(body)
+            payload = body[HEADER.size:]
+            if self.expected is not None and sequence != self.expected:
+                self.lost += (sequence - self.expected) & 0xFF
+                self.decoder.lose_sync()
+            self.expected = (sequence + 1) & 0xFF
+            self.dropped += dropped
+            self.frames += 1
+            self.payload_bytes += len(payload)
+            self.received_bytes += len(payload) + FRAME_OVERHEAD
+            for values in self.decoder.decode(payload):
+                if self.last is not None:
+                    self.elapsed += (values[0] - self.last[0]) & MASK
+                self.last = values
+                self.records += 1
+                rows.append([round(self.elapsed * SAMPLE_PERIOD_S, 1)] + values)
+        return rows
+
+    def ratio(self):
+        return RAW_RECORD_BYTES * self.records / self.payload_bytes if self.payload_bytes else 0.0
+
+
+class Calibration:
+    """Conversión de las lecturas crudas con la configuración de la placa (opcional)."""
+
+    def __init__(self, path):
+        self.config = None
+        if path:
+            with open(path) as handle:
+                self.config = json.load(handle)
+
+    def temperature(self, raw):
+        calibration = self.config["calibration"]
+        vref = calibration["vcc"]
+        if calibration.get("temperature_reference", "vcc") == "internal":
+            vref = calibration.get("internal_vref", 1.1)
+        return raw * vref / calibration["adc_max"] * 100 + calibration["temperature_offset"]
+
+    def humidity(self, raw):
+        calibration = self.config["calibration"]
+        return raw * calibration["vcc"] / calibration["adc_max"] * 100
+
+
+def sample_value(value):
+    """Valor de una muestra en el formato de texto de Prometheus (+Inf, -Inf y NaN)."""
+    value = float(value)
+    if math.isnan(value):
+        return "NaN"
+    if math.isinf(value):
+        return "+Inf" if value > 0 else "-Inf"
+    return repr(value)
+
+
+class Metrics:
+    """Texto de Prometheus listo para servir; se reemplaza entero al cambiar."""
+
+    def __init__(self, controller, calibration):
+        self.label = '{controller="%s"}' % controller.replace("\\", "\\\\").replace('"', '\\"')
+        self.controller = controller
+        self.calibration = calibration
+        self.lines = []  # Se reutiliza entre actualizaciones
+        self.text = b""
+
+    def metric(self, name, kind, help_text, value, labels=None):
+        self.lines.append("# HELP riego_%s %s" % (name, help_text))
+        self.lines.append("# TYPE riego_%s %s" % (name, kind))
+        if labels is None:
+            labels = [("", value)]
+        else:
+            labels = [(',%s="%s"' % label, labeled) for label, labeled in zip(labels, value)]
+        for extra, labeled in labels:
+            self.lines.append("riego_%s%s %s" % (name, self.label[:-1] + extra + "}", sample_value(labeled)))
+
+    def render(self, ingest):
+        del self.lines[:]
+        if ingest.last is not None:
+            _, raw_temp, raw_hum, status, relay = ingest.last
+            self.metric("temperature_raw", "gauge", "Temperatura cruda del ADC", raw_temp)
+            self.metric("humidity_raw", "gauge", "Humedad cruda del ADC", raw_hum)
+            if self.calibration.config is not None:
+                self.metric("temperature_celsius", "gauge", "Temperatura del suelo", self.calibration.temperature(raw_temp))
+                self.metric("humidity_percent", "gauge", "Humedad del suelo", self.calibration.humidity(raw_hum))
+            self.metric("pump_on", "gauge", "Bomba encendida", status & 1)
+            self.metric("crop", "gauge", "Cultivo seleccionado (desde 1)", status >> 2)
+        stats = ingest.stats
+        if stats is not None:
+            self.metric("uptime_seconds", "gauge", "Tiempo desde el encendido", stats["uptime"])
+            self.metric("loop_duration_seconds", "gauge", "Duración del último ciclo de loop()", stats["loop_ms"] / 1000.0)
+            # La placa envía solo los percentiles, sin suma ni cantidad: es un gauge por percentil,
+            # ya que la etiqueta quantile queda reservada para los summary
+            self.metric("control_latency_seconds", "gauge", "Latencia entre la lectura y el relé",
+                        [stats["latency_p50"] / 1e6, stats["latency_p99"] / 1e6, stats["latency_max"] / 1e6],
+                        [("percentile", "50"), ("percentile", "99"), ("percentile", "100")])
+            self.metric("latency_alarm", "gauge", "La latencia no cumple el objetivo", stats["latency_alarm"])
+            self.metric("relay_switches_total", "counter", "Conmutaciones del relé",
+                        [stats["relay_synchronized"], stats["relay_unsynchronized"]],
+                        [("mode", "synchronized"), ("mode", "unsynchronized")])
+            self.metric("relay_dropped_commands_total", "counter", "Órdenes del relé descartadas", stats["relay_dropped"])
+            self.metric("sensor_faults_total", "counter", "Lecturas fuera de rango", stats["sensor_faults"])
+            self.metric("device_dropped_records_total", "counter", "Registros descartados en la placa", stats["telemetry_dropped"])
+            self.metric("anomaly", "gauge", "Anomalía detectada en la placa",
+                        [stats["anomalies"] >> bit & 1 for bit in range(len(ANOMALIES))],
+                        [("kind", kind) for kind in ANOMALIES])
+            if stats["evaporation_milli"]:
+                self.forecast(ingest, stats)
+        self.metric("ingest_frames_total", "counter", "Envíos recibidos", [ingest.frames, ingest.stats_frames],
+                    [("type", "telemetry"), ("type", "stats")])
+        self.metric("ingest_records_total", "counter", "Registros descomprimidos", ingest.records)
+        self.metric("ingest_lost_frames_total", "counter", "Envíos perdidos", ingest.lost)
+        self.metric("ingest_bytes_total", "counter", "Bytes de envíos válidos", ingest.received_bytes)
+        self.metric("ingest_compression_ratio", "gauge", "Bytes sin comprimir por byte comprimido", ingest.ratio())
+        self.lines.append("")
+        self.text = "\n".join(self.lines).encode()  # Reemplazo atómico para las consultas
+
+
+    def forecast(self, ingest, stats):
+        """Pronóstico de la placa (include/moisture_forecaster.h) y la humedad prevista."""
+        dry = stats["dry_minutes"]
+        self.metric("forecast_dry_seconds", "gauge", "Tiempo hasta bajar del mínimo del cultivo sin regar",
+                    float("inf") if dry == NO_CROSSING else dry * 60)
+        coefficient = stats["evaporation_milli"] / 1000.0
+        self.metric("forecast_evaporation_coeff", "gauge", "Coeficiente de evaporación ajustado (%/h por °C)", coefficient)
+        if ingest.last is None or self.calibration.config is None:
+            return
+        # Mismo modelo que la placa: sin regar la humedad baja de forma exponencial
+        _, raw_temp, raw_hum, _, _ = ingest.last
+        temperature = max(self.calibration.temperature(raw_temp), 0.0)
+        humidity = self.calibration.humidity(raw_hum)
+        self.metric("forecast_humidity_percent", "gauge", "Humedad prevista sin regar",
+                    [humidity * math.exp(-coefficient * temperature / 100 * hours) for hours in FORECAST_HOURS],
+                    [("hours", str(hours)) for hours in FORECAST_HOURS])
+
+
+def serve_metrics(port, metrics):
+    from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+    class Handler(BaseHTTPRequestHandler):
+        def do_GET(self):
+            if self.path != "/metrics":
+                self.send_error(404)
+                return
+            body = metrics.text
+            self.send_response(200)
+            self.send_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+        def log_message(self, *args):
+            pass
+
+    server = ThreadingHTTPServer(("127.0.0.1", port), Handler)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    return server
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("output", help="archivo CSV de salida (- para la salida estándar)")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="puerto serie de la placa")
+    source.add_argument("--capture", help="archivo con los bytes recibidos por el puerto serie")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--seconds", type=float, default=300, help="tiempo de captura desde el puerto serie (0: sin límite)")
+    parser.add_argument("--save", help="guarda los bytes capturados para convertirlos después")
+    parser.add_argument("--metrics-port", type=int, help="publica las métricas en http://127.0.0.1:<puerto>/metrics")
+    parser.add_argument("--config", help="configuración de la placa para convertir las lecturas crudas")
+    parser.add_argument("--name", help="nombre del controlador en las métricas (por defecto el puerto o la captura)")
+    args = parser.parse_args()
+
+    metrics = Metrics(args.name or os.path.basename(args.port or args.capture), Calibration(args.config))
+    if args.metrics_port:
+        serve_metrics(args.metrics_port, metrics)
+
+    save = open(args.save, "wb") if args.save and args.port else None
+    if args.port:
+        chunks = serial_frames.read_port(args.port, args.baud, args.seconds, save)
+    else:
+        with open(args.capture, "rb") as handle:
+            chunks = [handle.read()]
+
+    ingest = Ingest()
+    output = sys.stdout if args.output == "-" else open(args.output, "w", newline="")
+    writer = csv.writer(output)
+    writer.writerow(["segundos"] + FIELDS)
+    pending = b""
+    try:
+        for chunk in chunks:
+            pending += chunk
+            frames, consumed = read_frames(pending)
+            pending = pending[consumed:]
+            if frames:
+                writer.writerows(ingest.add(frames))
+                metrics.render(ingest)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if output is not sys.stdout:
+            output.close()
+        if save:
+            save.close()
+
+    if ingest.frames == 0:
+        sys.exit("no se encontraron envíos de telemetría")
+
+    print("%d envíos, %d registros, %d resúmenes" % (ingest.frames, ingest.records, ingest.stats_frames), file=sys.stderr)
+    if ingest.records:
+        print("compresión %.2f:1 (%.2f bytes por registro, %.2f:1 con la cabecera de los envíos)"
+              % (ingest.ratio(), ingest.payload_bytes / ingest.records,
+                 RAW_RECORD_BYTES * ingest.records / (ingest.payload_bytes + FRAME_OVERHEAD * ingest.frames)),
+              file=sys.stderr)
+    if ingest.lost:
+        print("%d envíos perdidos: registros descartados hasta el siguiente registro completo" % ingest.lost, file=sys.stderr)
+    if ingest.dropped:
+        print("%d registros descartados en la placa: el envío anterior no salió a tiempo" % ingest.dropped, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
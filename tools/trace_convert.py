@@ -0,0 +1,133 @@
+"""Convierte las trazas del firmware al formato JSON de Chrome (chrome://tracing, Perfetto).
+
+Lee los envíos de las trazas (include/trace.h) desde el puerto serie o desde un archivo
+capturado y escribe un evento de inicio ("B") o fin ("E") por cada marca del firmware.
+Así se ven en una línea de tiempo las tareas, su solapamiento, la variación entre
+ciclos y las esperas bloqueantes como la de showSelectionMessage().
+
+Uso:
+    python tools/trace_convert.py --port /dev/ttyACM0 --seconds 60 traza.json
+    python tools/trace_convert.py --capture traza.bin traza.json
+
+El archivo resultante se abre en https://ui.perfetto.dev o en chrome://tracing.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+import serial_frames
+
+TAG = ord("T")
+HEADER = struct.Struct("<BB")  # eventos, eventos perdidos
+EVENT_SIZE = 4
+TICK_US = 4  # Unidades de tiempo de cada evento
+TICK_WRAP = 1 << 24
+
+# Mismo orden que TraceId en include/trace.h
+NAMES = ["sense", "control", "display", "keypad", "delay"]
+
+
+def read_frames(data):
+    """Extrae (eventos perdidos, [(id, fin, tiempo)]) de cada envío válido."""
+    frames = []
+    lengths = {TAG: (HEADER.size, lambda header: HEADER.size + EVENT_SIZE * header[0])}
+    for _, body in serial_frames.scan(data, lengths)[0]:
+        count, dropped = HEADER.unpack_from(body)
+        events = []
+        for offset in range(HEADER.size, HEADER.size + EVENT_SIZE * count, EVENT_SIZE):
+            code = body[offset]
+            ticks = body[offset + 1] | body[offset + 2] << 8 | body[offset + 3] << 16
+            events.append((code >> 1, code & 1, ticks))
+        frames.append((dropped, events))
+    return frames
+
+
+def to_chrome(frames):
+    """Eventos de Chrome con el tiempo en microsegundos desde el primer evento.
+
+    Los eventos perdidos están entre el último evento recibido y el primero del envío
+    siguiente: la marca va en la mitad de ese hueco, y las tareas que seguían abiertas se
+    cierran ahí porque su fin puede estar entre lo perdido. Un fin sin su inicio (perdido o
+    anterior a la captura) se descarta para no cerrar otra tarea en el visor.
+    """
+    trace = []
+    dropped = 0
+    pending = 0  # Eventos perdidos que todavía no tienen marca
+    base = None
+    last = 0
+    previous = None
+    wraps = 0
+    open_tasks = []  # Tareas con inicio y sin fin, en orden de apertura
+
+    def mark_loss(ts):
+        trace.append({"name": "%d eventos perdidos" % pending, "ph": "i", "s": "g",
+                      "ts": ts * TICK_US, "pid": 1, "tid": 1})
+        while open_tasks:
+            trace.append({"name": open_tasks.pop(), "ph": "E", "ts": ts * TICK_US, "pid": 1, "tid": 1,
+                          "args": {"fin": "eventos perdidos"}})
+
+    for lost, events in frames:
+        dropped += lost
+        pending += lost
+        for task, end, ticks in events:
+            # El contador de 24 bits da la vuelta cada ~67 s
+            if base is None:
+                base = last = ticks
+            if ticks + wraps * TICK_WRAP < last:
+                wraps += 1
+            last = ticks + wraps * TICK_WRAP
+            now = last - base
+            if pending:
+                mark_loss(now if previous is None else (previous + now) // 2)
+                pending = 0
+            previous = now
+
+            name = NAMES[task] if task < len(NAMES) else "tarea %d" % task
+            if end:
+                if name not in open_tasks:
+                    continue
+                # Se cierra la última apertura de esa tarea
+                del open_tasks[len(open_tasks) - 1 - open_tasks[::-1].index(name)]
+            else:
+                open_tasks.append(name)
+            trace.append({"name": name, "ph": "E" if end else "B",
+                          "ts": now * TICK_US, "pid": 1, "tid": 1})
+    if pending:
+        mark_loss(previous or 0)
+    return trace, dropped
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("output", help="archivo JSON de salida")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="puerto serie de la placa")
+    source.add_argument("--capture", help="archivo con los bytes recibidos por el puerto serie")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--seconds", type=float, default=30, help="tiempo de captura desde el puerto serie")
+    parser.add_argument("--save", help="guarda los bytes capturados para convertirlos después")
+    args = parser.parse_args()
+
+    if args.port:
+        data = serial_frames.capture(args.port, args.baud, args.seconds, args.save)
+    else:
+        with open(args.capture, "rb") as handle:
+            data = handle.read()
+
+    frames = read_frames(data)
+    if not frames:
+        sys.exit("no se encontraron trazas")
+
+    trace, dropped = to_chrome(frames)
+    with open(args.output, "w") as handle:
+        json.dump({"traceEvents": trace, "displayTimeUnit": "ms"}, handle)
+
+    print("%d envíos, %d eventos" % (len(frames), sum(1 for event in trace if event["ph"] in "BE")))
+    if dropped:
+        print("%d eventos perdidos: el buffer se llenó antes de poder enviarlo" % dropped)
+
+
+if __name__ == "__main__":
+    main()